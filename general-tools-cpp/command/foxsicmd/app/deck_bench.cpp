@@ -0,0 +1,199 @@
+#include "commands.h"
+#include <chrono>
+#include <random>
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+
+// the deck as it was before indexing: linear scans over systems, and commands copied out of nested maps.
+// kept here only as a baseline to compare against.
+class LegacyDeck {
+    public:
+        void add(System system, std::vector<Command> commands) {
+            systems.push_back(system);
+            std::unordered_map<uint8_t, Command> inner;
+            for (auto c: commands) {
+                inner[c.hex] = c;
+            }
+            lookup_map[system.hex] = inner;
+        }
+        System lookup(std::string system) {
+            for (auto s: systems) {
+                if (s.name == system) {
+                    return s;
+                }
+            }
+            return System();
+        }
+        std::vector<Command> lookup_commands(uint8_t system) {
+            std::vector<Command> result;
+            for (auto& c: lookup_map[system]) {
+                result.push_back(c.second);
+            }
+            return result;
+        }
+        // what a caller had to do to find one command by code or name
+        Command lookup(uint8_t system, uint8_t command) {
+            for (auto c: lookup_commands(system)) {
+                if (c.hex == command) {
+                    return c;
+                }
+            }
+            return Command();
+        }
+        Command lookup(std::string system, std::string command) {
+            for (auto c: lookup_commands(lookup(system).hex)) {
+                if (c.name == command) {
+                    return c;
+                }
+            }
+            return Command();
+        }
+
+        std::vector<System> systems;
+        std::unordered_map<uint8_t, std::unordered_map<uint8_t, Command>> lookup_map;
+};
+
+struct DeckSource {
+    std::string label;
+    std::vector<System> systems;
+    std::vector<std::vector<Command>> commands;
+};
+
+// `counts[k]` commands for system k, with names and codes like the ones in foxsi4-commands
+DeckSource make_deck(std::string label, std::vector<size_t> counts) {
+    DeckSource source;
+    source.label = label;
+    std::mt19937 random(7);
+    for (size_t s = 0; s < counts.size(); ++s) {
+        uint8_t sys_hex = static_cast<uint8_t>(s + 1);
+        std::string sys_name = "system_" + std::to_string(s);
+        source.systems.push_back(System(sys_hex, sys_name, "spw"));
+        std::vector<Command> commands;
+        for (size_t c = 0; c < counts[s]; ++c) {
+            std::string name = (c % 2 ? "set_" : "get_") + sys_name + "_register_" + std::to_string(c);
+            commands.push_back(Command(static_cast<uint8_t>(c), name, 0xffffff, static_cast<uint32_t>(random() % 1000), {sys_hex, static_cast<uint8_t>(c)}));
+        }
+        source.commands.push_back(commands);
+    }
+    return source;
+}
+
+struct Query {
+    uint8_t system;
+    uint8_t command;
+    std::string system_name;
+    std::string command_name;
+};
+
+// time `run`, which does `ops` operations, in ns per operation
+template <typename F>
+double time_per_op(size_t ops, F run) {
+    auto start = std::chrono::steady_clock::now();
+    run();
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return elapsed / ops;
+}
+
+/**
+ * @brief Benchmark `Deck` lookups against the old linear-scan deck, on a deck the size of the flight command set and on a 10 000-command synthetic deck.
+ *
+ * Run like `./bin/deck_bench [repeats]`. Each result is the mean time per lookup over random queries, in nanoseconds.
+ */
+int main(int argc, char** argv) {
+    size_t repeats = argc > 1 ? strtoul(argv[1], nullptr, 10) : 20;
+    volatile uint64_t sink = 0;
+
+    std::vector<DeckSource> sources = {
+        // 16 systems with 4 to 60 commands, about the size of foxsi4-commands
+        make_deck("flight-sized", {4, 12, 60, 60, 60, 60, 24, 24, 40, 8, 8, 16, 30, 6, 12, 20}),
+        make_deck("synthetic 10k", std::vector<size_t>(40, 250)),
+    };
+
+    std::cout << std::left << std::setw(16) << "deck" << std::setw(22) << "lookup" << std::right << std::setw(14) << "indexed ns" << std::setw(14) << "legacy ns" << std::setw(10) << "speedup" << "\n";
+    for (auto& source: sources) {
+        Deck deck(source.systems, source.commands);
+        LegacyDeck legacy;
+        for (size_t s = 0; s < source.systems.size(); ++s) {
+            legacy.add(source.systems[s], source.commands[s]);
+        }
+
+        std::mt19937 random(11);
+        std::vector<Query> queries(4096);
+        for (auto& q: queries) {
+            size_t s = random() % source.systems.size();
+            const Command& c = source.commands[s][random() % source.commands[s].size()];
+            q = {source.systems[s].hex, c.hex, source.systems[s].name, c.name};
+        }
+        // check both decks agree before timing them
+        for (auto& q: queries) {
+            if (deck.lookup(q.system, q.command).name != q.command_name || deck.lookup(q.system_name, q.command_name).hex != q.command || legacy.lookup(q.system, q.command).name != q.command_name) {
+                std::cerr << "lookup mismatch in " << source.label << " deck\n";
+                return 1;
+            }
+        }
+
+        size_t ops = queries.size() * repeats;
+        // the legacy deck is slow enough that fewer repeats give a stable mean
+        size_t legacy_repeats = std::max<size_t>(1, repeats / 10);
+        size_t legacy_ops = queries.size() * legacy_repeats;
+        auto report = [&](std::string what, double indexed, double old) {
+            std::cout << std::left << std::setw(16) << source.label << std::setw(22) << what << std::right << std::fixed << std::setprecision(1);
+            std::cout << std::setw(14) << indexed << std::setw(14) << old << std::setw(9) << old / indexed << "x\n";
+        };
+
+        report("by code", time_per_op(ops, [&] {
+            for (size_t r = 0; r < repeats; ++r) {
+                for (auto& q: queries) {
+                    sink = sink + deck.lookup(q.system, q.command).order;
+                }
+            }
+        }), time_per_op(legacy_ops, [&] {
+            for (size_t r = 0; r < legacy_repeats; ++r) {
+                for (auto& q: queries) {
+                    sink = sink + legacy.lookup(q.system, q.command).order;
+                }
+            }
+        }));
+        report("by name", time_per_op(ops, [&] {
+            for (size_t r = 0; r < repeats; ++r) {
+                for (auto& q: queries) {
+                    sink = sink + deck.lookup(q.system_name, q.command_name).order;
+                }
+            }
+        }), time_per_op(legacy_ops, [&] {
+            for (size_t r = 0; r < legacy_repeats; ++r) {
+                for (auto& q: queries) {
+                    sink = sink + legacy.lookup(q.system_name, q.command_name).order;
+                }
+            }
+        }));
+        report("system by name", time_per_op(ops, [&] {
+            for (size_t r = 0; r < repeats; ++r) {
+                for (auto& q: queries) {
+                    sink = sink + deck.lookup(q.system_name).hex;
+                }
+            }
+        }), time_per_op(legacy_ops, [&] {
+            for (size_t r = 0; r < legacy_repeats; ++r) {
+                for (auto& q: queries) {
+                    sink = sink + legacy.lookup(q.system_name).hex;
+                }
+            }
+        }));
+        report("list commands", time_per_op(ops, [&] {
+            for (size_t r = 0; r < repeats; ++r) {
+                for (auto& q: queries) {
+                    sink = sink + deck.lookup_commands(q.system).size();
+                }
+            }
+        }), time_per_op(legacy_ops, [&] {
+            for (size_t r = 0; r < legacy_repeats; ++r) {
+                for (auto& q: queries) {
+                    sink = sink + legacy.lookup_commands(q.system).size();
+                }
+            }
+        }));
+    }
+    return 0;
+}
@@ -0,0 +1,164 @@
+#include "deckload.h"
+#include "util.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// `text` as a C++ string literal. Anything unprintable is an octal escape, which can't run into the next character like a hex escape can.
+std::string literal(const std::string& text) {
+    std::stringstream out;
+    out << '"';
+    for (unsigned char c: text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (c < 0x20 || c >= 0x7f) {
+            out << '\\' << std::oct << std::setw(3) << std::setfill('0') << static_cast<int>(c) << std::dec;
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+    return out.str();
+}
+
+std::string uart_entry(const UARTInfo& uart) {
+    std::stringstream out;
+    out << "{" << literal(uart.port_name) << ", " << uart.baud_rate << ", " << static_cast<int>(uart.data_bits) << ", " << static_cast<int>(uart.stop_bits) << ", " << static_cast<int>(uart.parity) << ", ";
+    out << static_cast<int>(uart.flow_control) << ", " << static_cast<int>(uart.read_min) << ", " << static_cast<int>(uart.read_timeout) << ", " << (uart.low_latency ? "true" : "false") << ", " << static_cast<int>(uart.latency_timer) << ", " << uart.xmit_fifo << "}";
+    return out.str();
+}
+
+// replace `path` with `contents` only if they differ, so an unchanged deck doesn't rebuild everything that includes it
+bool write_if_changed(const std::string& path, const std::string& contents) {
+    std::ifstream old(path, std::ios::binary);
+    if (old.is_open()) {
+        std::stringstream existing;
+        existing << old.rdbuf();
+        if (existing.str() == contents) {
+            return true;
+        }
+        old.close();
+    }
+    std::filesystem::path target(path);
+    if (target.has_parent_path()) {
+        std::filesystem::create_directories(target.parent_path());
+    }
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << contents;
+    return static_cast<bool>(out);
+}
+
+/**
+ * @brief Generate `builtin_deck_data.h`, the compiled-in command deck used by `foxsicmd --builtin-deck`. Run by the build, not by hand.
+ *
+ * Use like `deckgen <systems.json> <output header>`, or `deckgen --none <output header>` to generate empty tables when there's no systems file. Command files are read with the same loaders `foxsicmd` uses at runtime; any file that's missing or doesn't parse fails the build.
+ */
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::cerr << "use like this:\n\t> ./deckgen <systems.json> <output header>\n\t> ./deckgen --none <output header>\n";
+        return 1;
+    }
+    std::string config_path = argv[1];
+    std::string header_path = argv[2];
+
+    std::stringstream out;
+    out << "// generated by deckgen";
+    if (config_path != "--none") {
+        out << " from " << config_path;
+    }
+    out << ". Don't edit.\n";
+    out << "#ifndef BUILTIN_DECK_DATA_H\n#define BUILTIN_DECK_DATA_H\n\n#include \"builtin.h\"\n#include <array>\n#include <cstdint>\n\n";
+    out << "namespace builtin_deck::data {\n";
+
+    if (config_path == "--none") {
+        out << "    constexpr bool available = false;\n";
+        out << "    constexpr const char* source = \"\";\n";
+        out << "    constexpr std::array<uint8_t, 0> write_values = {};\n";
+        out << "    constexpr std::array<SystemEntry, 0> systems = {};\n";
+        out << "    constexpr std::array<CommandEntry, 0> commands = {};\n";
+        out << "    constexpr UARTEntry uplink = " << uart_entry(UARTInfo()) << ";\n";
+        out << "    constexpr UARTEntry timepix = " << uart_entry(UARTInfo()) << ";\n";
+        out << "}\n\n#endif\n";
+        return write_if_changed(header_path, out.str()) ? 0 : 1;
+    }
+
+    std::ifstream sys_file(config_path);
+    if (!sys_file.is_open()) {
+        std::cerr << "deckgen: couldn't open " << config_path << "\n";
+        return 1;
+    }
+    nlohmann::json systems_data;
+    try {
+        systems_data = nlohmann::json::parse(sys_file);
+    } catch(std::exception& e) {
+        std::cerr << "deckgen: couldn't parse " << config_path << ": " << e.what() << "\n";
+        return 1;
+    }
+
+    UARTInfo uplink, timepix;
+    std::string uart_error;
+    try {
+        if (!deck_load::uplink_from(systems_data, 0, uplink, uart_error) || !deck_load::uplink_from(systems_data, 1, timepix, uart_error)) {
+            std::cerr << "deckgen: bad UART settings in " << config_path << ": " << uart_error << "\n";
+            return 1;
+        }
+    } catch(std::exception& e) {
+        std::cerr << "deckgen: bad UART settings in " << config_path << ": " << e.what() << "\n";
+        return 1;
+    }
+    std::vector<System> systems;
+    std::vector<std::string> files;
+    deck_load::list_command_files(systems_data, config_path, systems, files);
+    auto loads = deck_load::load_command_files(files, 1);
+    size_t system_count = 0;
+    for (size_t k = 0; k < loads.size(); ++k) {
+        if (!loads[k].opened) {
+            // as foxsicmd does when loading JSON, a system without a command file is left out
+            std::cerr << "deckgen: no command file for " << systems[k].name << " at " << loads[k].path << ", leaving it out\n";
+            continue;
+        }
+        if (loads[k].error != "") {
+            std::cerr << "deckgen: couldn't load commands for " << systems[k].name << " from " << loads[k].path << ": " << loads[k].error << "\n";
+            return 1;
+        }
+        ++system_count;
+    }
+
+    std::stringstream system_rows, command_rows, value_bytes;
+    size_t command_count = 0, value_count = 0;
+    for (size_t k = 0; k < systems.size(); ++k) {
+        if (!loads[k].opened) {
+            continue;
+        }
+        system_rows << "        {" << util::byte_to_string(systems[k].hex) << ", " << literal(systems[k].name) << ", " << literal(systems[k].interface) << ", " << command_count << ", " << loads[k].commands.size() << "},\n";
+        for (auto& command: loads[k].commands) {
+            command_rows << "        {" << util::byte_to_string(command.hex) << ", " << literal(command.name) << ", 0x" << std::hex << std::setw(6) << std::setfill('0') << command.color << std::dec << ", " << command.order << ", " << value_count << ", " << command.write_value.size() << "},\n";
+            for (auto byte: command.write_value) {
+                value_bytes << (value_count % 16 == 0 ? "\n        " : " ") << util::byte_to_string(byte) << ",";
+                ++value_count;
+            }
+            ++command_count;
+        }
+    }
+
+    out << "    constexpr bool available = true;\n";
+    out << "    constexpr const char* source = " << literal(std::filesystem::weakly_canonical(config_path).string()) << ";\n";
+    out << "    constexpr std::array<uint8_t, " << value_count << "> write_values = {" << value_bytes.str() << "\n    };\n";
+    out << "    constexpr std::array<SystemEntry, " << system_count << "> systems = {{\n" << system_rows.str() << "    }};\n";
+    out << "    constexpr std::array<CommandEntry, " << command_count << "> commands = {{\n" << command_rows.str() << "    }};\n";
+    out << "    constexpr UARTEntry uplink = " << uart_entry(uplink) << ";\n";
+    out << "    constexpr UARTEntry timepix = " << uart_entry(timepix) << ";\n";
+    out << "}\n\n#endif\n";
+
+    if (!write_if_changed(header_path, out.str())) {
+        std::cerr << "deckgen: couldn't write " << header_path << "\n";
+        return 1;
+    }
+    std::cout << "deckgen: " << system_count << " systems, " << command_count << " commands from " << config_path << "\n";
+    return 0;
+}
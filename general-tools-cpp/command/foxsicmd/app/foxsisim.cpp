@@ -0,0 +1,134 @@
+#include "simulator.h"
+#include "script.h"
+#include "util.h"
+#include <boost/program_options.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+
+namespace {
+    std::atomic<bool> interrupted(false);
+
+    void on_signal(int) {
+        interrupted = true;
+    }
+}
+
+/**
+ * @brief Pretend to be the Formatter (or Timepix) on a pseudo-terminal, so foxsicmd can be run without hardware.
+ *
+ * Run like `./bin/foxsisim --link /tmp/formatter`, then `./bin/foxsicmd --config systems.json --port /tmp/formatter`. Stops on Ctrl-C (or after `--count` commands) and prints what arrived.
+ */
+int main(int argc, char** argv) {
+    boost::program_options::options_description options("options");
+    options.add_options()
+        ("help,h",                                                              "output help message")
+        ("mode",        boost::program_options::value<std::string>()->default_value("formatter"), "formatter or timepix")
+        ("reply",       boost::program_options::value<std::string>()->default_value("none"), "none, echo or ack")
+        ("baud",        boost::program_options::value<uint32_t>()->default_value(0), "line speed to model, 0 for none")
+        ("byte-timeout", boost::program_options::value<std::string>()->default_value("10ms"), "time allowed between the two bytes of a command")
+        ("link",        boost::program_options::value<std::string>(),           "symlink to make to the pseudo-terminal")
+        ("log",         boost::program_options::value<std::string>(),           "CSV file of arrival times")
+        ("count",       boost::program_options::value<uint64_t>()->default_value(0), "stop after this many commands")
+    ;
+    boost::program_options::variables_map vm;
+    try {
+        boost::program_options::store(boost::program_options::command_line_parser(argc, argv).options(options).run(), vm);
+        boost::program_options::notify(vm);
+    } catch(std::exception& e) {
+        std::cerr << e.what() << "\n" << options << "\n";
+        return 1;
+    }
+    if (vm.count("help")) {
+        std::cout << "usage: foxsisim [options]\n\n"
+            << "Creates a pseudo-terminal and reads commands from it as the Formatter would (system code, then\n"
+            << "command code) or, with --mode timepix, as Timepix would when the Formatter is bypassed (one byte\n"
+            << "per command). Point foxsicmd's --port at the device it prints, or at --link.\n\n"
+            << options << "\n";
+        return 0;
+    }
+
+    SimSettings settings;
+    std::string mode = vm["mode"].as<std::string>();
+    std::string reply = vm["reply"].as<std::string>();
+    if (mode != "formatter" && mode != "timepix") {
+        std::cerr << "--mode must be formatter or timepix\n";
+        return 1;
+    }
+    if (reply != "none" && reply != "echo" && reply != "ack") {
+        std::cerr << "--reply must be none, echo or ack\n";
+        return 1;
+    }
+    settings.mode = mode == "timepix" ? SimMode::timepix : SimMode::formatter;
+    settings.reply = reply == "echo" ? SimReply::echo : reply == "ack" ? SimReply::ack : SimReply::none;
+    settings.baud_rate = vm["baud"].as<uint32_t>();
+    if (!script::parse_duration(vm["byte-timeout"].as<std::string>(), settings.byte_timeout)) {
+        std::cerr << "--byte-timeout needs a duration, like 10ms\n";
+        return 1;
+    }
+
+    SerialSim sim(settings);
+    std::string error;
+    if (!sim.open(error)) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+    std::string link = vm.count("link") ? vm["link"].as<std::string>() : "";
+    if (link != "") {
+        std::error_code err;
+        std::filesystem::remove(link, err);
+        std::filesystem::create_symlink(sim.device(), link, err);
+        if (err) {
+            std::cerr << "couldn't link " << link << " to " << sim.device() << ": " << err.message() << "\n";
+            return 1;
+        }
+    }
+    std::cout << "simulating " << mode << " on " << sim.device() << (link != "" ? " (" + link + ")" : "") << ", replying " << reply;
+    std::cout << (settings.baud_rate > 0 ? ", " + std::to_string(settings.baud_rate) + " baud" : "") << ". Ctrl-C to stop.\n";
+
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+    uint64_t count = vm["count"].as<uint64_t>();
+    sim.start();
+    while (!interrupted && (count == 0 || sim.commands.load() < count)) {
+        sim.wait_for(count == 0 ? SIZE_MAX : count, std::chrono::milliseconds(100));
+    }
+    sim.stop();
+
+    auto arrivals = sim.arrivals();
+    std::cout << "\n" << arrivals.size() << " commands, " << sim.bytes_in.load() << " bytes, " << sim.partial.load() << " dropped as partial commands";
+    if (sim.replies_dropped.load() > 0) {
+        std::cout << ", " << sim.replies_dropped.load() << " reply bytes not read";
+    }
+    std::cout << "\n";
+    if (arrivals.size() > 1) {
+        std::vector<double> gaps;
+        for (size_t k = 1; k < arrivals.size(); ++k) {
+            gaps.push_back((arrivals[k].time - arrivals[k - 1].time) / 1e3);
+        }
+        std::sort(gaps.begin(), gaps.end());
+        double seconds = (arrivals.back().time - arrivals.front().time) / 1e9;
+        std::cout << std::fixed << std::setprecision(1) << (arrivals.size() - 1) / seconds << " commands/s; gap between commands, us: min " << gaps.front();
+        std::cout << ", median " << gaps[gaps.size() / 2] << ", max " << gaps.back() << "\n";
+    }
+
+    if (vm.count("log")) {
+        std::ofstream log(vm["log"].as<std::string>());
+        log << "index,time ns,bytes\n";
+        for (auto& arrival: arrivals) {
+            log << arrival.index << "," << arrival.time << "," << util::bytes_to_string(arrival.bytes) << "\n";
+        }
+        if (!log) {
+            std::cerr << "couldn't write " << vm["log"].as<std::string>() << "\n";
+        }
+    }
+    if (link != "") {
+        std::error_code err;
+        std::filesystem::remove(link, err);
+    }
+    return 0;
+}
@@ -5,15 +5,24 @@
 #include "ftxui/dom/elements.hpp"  // for operator|, Element, size, border, frame, HEIGHT, LESS_THAN
  
 #include "line.h"
+#include "uplink.h"
+#include "downlink.h"
+#include "script.h"
 #include "util.h"
+#include "trace.h"
 #include <boost/asio.hpp>
 #include <chrono>
 #include <ftxui/component/component_options.hpp>
 #include <iostream>
+#include <fstream>
 #include <thread>
 #include <vector>
 #include <algorithm>
 #include <string>
+#include <sstream>
+#include <cctype>
+#include <memory>
+#include <iomanip>
 
 // Define a special style for some menu entry.
 ftxui::MenuEntryOption Colored(ftxui::Color c) {
@@ -35,10 +44,82 @@ int main(int argc, char** argv) {
     // digest CLI args and make app objects
     Line lf = Line(argc, argv, context);
 
+    // a script runs headless, so check it before anything starts:
+    std::vector<script::Step> script_steps;
+    if (lf.script_path != "") {
+        std::ifstream script_file(lf.script_path);
+        if (!script_file.is_open()) {
+            std::cerr << "couldn't open script " << lf.script_path << "\n";
+            return 1;
+        }
+        std::string error;
+        if (!script::parse(script_file, lf.deck, script_steps, error)) {
+            std::cerr << "bad script " << lf.script_path << ", " << error << "\n";
+            return 1;
+        }
+    }
+
+    // all port I/O runs on its own thread, so a slow UART never holds up the UI:
+    Uplink uplink(lf.port, lf.interface, lf.pacing);
+    uplink.measure_wire = lf.latency_report;
+
+    // read whatever comes back (acks, echoes) into a ring, framed for display and logged raw:
+    const size_t downlink_ring_size = 1 << 16;
+    std::unique_ptr<Downlink> downlink;
+    if (lf.downlink) {
+        std::string error;
+        auto framer = make_framer(lf.framer_spec, downlink_ring_size, error);
+        if (!framer) {
+            std::cerr << "bad --framer: " << error << "\n";
+            return 1;
+        }
+        downlink = std::make_unique<Downlink>(lf.port, std::move(framer), downlink_ring_size);
+        if (!downlink->start(lf.downlink_log, error)) {
+            std::cerr << "reading the downlink without a log: " << error << "\n";
+            downlink->start("", error);
+        }
+    }
+    auto start_time = std::chrono::steady_clock::now();
+    auto io_guard = boost::asio::make_work_guard(context);
+    std::thread io_thread([&] {
+        trace::set_thread_name("io");
+        context.run();
+    });
+    auto stop_io = [&] {
+        if (downlink) {
+            downlink->stop();
+        }
+        io_guard.reset();
+        context.stop();
+        io_thread.join();
+    };
+
+    if (lf.script_path != "") {
+        std::cout << "running " << script_steps.size() << " sends from " << lf.script_path << "\n";
+        auto results = script::run(script_steps, uplink, 20000000);
+        std::string report = script::report(results);
+        std::cout << report;
+        if (lf.script_report != "") {
+            std::ofstream report_file(lf.script_report);
+            report_file << report;
+            if (!report_file) {
+                std::cerr << "couldn't write " << lf.script_report << "\n";
+            }
+        }
+        std::cout << "pacing: " << uplink.pacer.stats().to_string() << "\n";
+        if (downlink) {
+            std::cout << "downlink: " << downlink->bytes_read.load() << " B, " << downlink->frames.load() << " frames";
+            std::cout << (downlink->log().path != "" ? ", logged to " + downlink->log().path : "") << "\n";
+        }
+        stop_io();
+        trace::stop();
+        return uplink.failed.load() == 0 && uplink.sent.load() == results.size() ? 0 : 1;
+    }
+
     // assemble display names for systems:
     std::vector<std::string> system_names;
     std::vector<uint8_t> system_hexes;
-    for (auto& s: lf.deck.systems) {
+    for (auto& s: lf.deck.systems()) {
         // filter only sytems which can be commanded:
         if (lf.deck.lookup_commands(s.hex).size()) {
             system_names.push_back(s.name);
@@ -52,37 +133,14 @@ int main(int argc, char** argv) {
     //      for context: to make the command menu change based on the selection in the
     //      system menu in FTXUI, an array of each command (std::vector<std::string>) 
     //      name needs to exist in scope for the UI. 
-    std::vector<size_t> sort_index;
     std::vector<ftxui::Component> all_command_menu(system_names.size());
     std::vector<std::vector<ftxui::Component>> all_command_menu_entries(system_names.size());
     std::vector<int> all_command_selection(system_names.size());
-    std::vector<std::vector<Command>> all_commands(system_names.size());
+    std::vector<std::span<const Command>> all_commands(system_names.size());
     std::vector<std::vector<std::string>> all_command_str(system_names.size());
-    std::vector<std::vector<size_t>> all_command_order(system_names.size());
     for (size_t k = 0; k < system_names.size(); ++k) {
-        // get all command objects for this system
-        auto all_commands_temp = lf.deck.lookup_commands(lf.deck.lookup(system_names[k]).hex);
-        sort_index.resize(all_commands_temp.size());
-        //      (temp commands used here for sorting, then copied to outer scope command list for UI once sorted).
-        //      (makes the indexing easier later on.)
-
-        // get sorting order for these commands:
-        all_command_order[k].resize(all_commands_temp.size());
-        for (size_t p = 0; p < all_commands_temp.size(); ++p) {
-            all_command_order[k][p] = all_commands_temp[p].order;
-            sort_index[p] = p;
-        }
-
-        // sort the commands by order:
-        std::sort(sort_index.begin(), sort_index.end(), 
-            [&](const size_t& a, const size_t& b) {
-                return (all_command_order[k][a] < all_command_order[k][b]);
-            }
-        );
-        all_commands[k].resize(all_commands_temp.size());
-        for (size_t p = 0; p < all_commands_temp.size(); ++p) {
-            all_commands[k][p] = all_commands_temp[sort_index[p]];
-        }
+        // the deck keeps each system's commands sorted by order already
+        all_commands[k] = lf.deck.lookup_commands(system_hexes[k]);
 
         // populate the command string values for display
         all_command_str[k].resize(all_commands[k].size());
@@ -115,7 +173,7 @@ int main(int argc, char** argv) {
     };
     auto put_selection_note = [&]() {
         auto sys_name = system_names[sys_selected];
-        auto cmd = all_commands[sys_selected][all_command_selection[sys_selected]];
+        auto& cmd = all_commands[sys_selected][all_command_selection[sys_selected]];
         return sys_name + " > " + cmd.name;
     };
 
@@ -130,9 +188,10 @@ int main(int argc, char** argv) {
         // get system and command selection from UI
         auto sys_name = system_names[sys_selected];
         auto sys_hex = system_hexes[sys_selected];
-        auto cmd = all_commands[sys_selected][all_command_selection[sys_selected]];
+        auto& cmd = all_commands[sys_selected][all_command_selection[sys_selected]];
         
         debug_note = sys_name + " > " + cmd.name;
+        trace::Span span("send command", "uplink", debug_note);
         debug_hex = util::bytes_to_string({sys_hex, cmd.hex});
 
         if (bypass_state) { // bypass Formatter, and attempt to send onboard system raw command
@@ -141,7 +200,7 @@ int main(int argc, char** argv) {
                 // send to timepix based on write_value
                 std::vector<uint8_t> write_value = cmd.write_value;
                 // debug_note = "sending " + util::byte_to_string(write_value[0]);
-                lf.port.write_some(boost::asio::buffer(write_value));
+                uplink.send(sys_hex, write_value, debug_note);
 
                 return;
             } else {
@@ -151,8 +210,83 @@ int main(int argc, char** argv) {
         } else { // send command as if GSE to Formatter:
             std::vector<uint8_t> write_value = {sys_hex, cmd.hex};
             // debug_note = "sending " + util::bytes_to_string(write_value);
-            lf.port.write_some(boost::asio::buffer(write_value));
+            uplink.send(sys_hex, write_value, debug_note);
+        }
+    };
+
+    // queue depth, and how long the last command took on the wire
+    auto put_uplink_status = [&]() {
+        std::stringstream status;
+        status << std::fixed << std::setprecision(2);
+        status << "uplink: " << uplink.depth() << " queued, " << uplink.sent.load() << " sent";
+        if (uplink.failed.load() > 0) {
+            status << ", " << uplink.failed.load() << " failed";
+        }
+        PacingStats pacing = uplink.pacer.stats();
+        if (pacing.delayed > 0) {
+            status << ", " << pacing.delayed << " paced (max " << pacing.max_delay / 1e6 << " ms)";
+        }
+        UplinkRecord last = uplink.last();
+        if (last.id != 0) {
+            status << " | #" << last.id << " " << last.label << ": ";
+            if (last.ok) {
+                status << "wire " << last.wire_ns() / 1e6 << " ms, waited " << last.wait_ns() / 1e6 << " ms";
+                if (last.drained != 0) {
+                    status << ", on wire " << last.to_wire_ns() / 1e6 << " ms";
+                }
+                if (last.paced > 0) {
+                    status << " (paced " << last.paced / 1e6 << " ms)";
+                }
+            } else {
+                status << "failed (" << last.error << ")";
+            }
+        }
+        return status.str();
+    };
+
+    // one line per received frame: time since start, length, then the first bytes as hex and text
+    auto format_frame = [&](const DownlinkFrame& frame) {
+        const size_t shown = 24;
+        std::stringstream line;
+        double seconds = (frame.time - std::chrono::duration_cast<std::chrono::nanoseconds>(start_time.time_since_epoch()).count()) / 1e9;
+        line << std::fixed << std::setprecision(3) << std::setw(9) << seconds << " s " << std::setw(5) << frame.bytes.size() << " B  ";
+        std::string text;
+        for (size_t k = 0; k < std::min(shown, frame.bytes.size()); ++k) {
+            line << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(frame.bytes[k]) << std::dec << std::setfill(' ') << " ";
+            text += std::isprint(frame.bytes[k]) ? static_cast<char>(frame.bytes[k]) : '.';
+        }
+        line << (frame.bytes.size() > shown ? "... " : "") << " " << text;
+        return line.str();
+    };
+    auto downlink_panel = [&]() {
+        std::stringstream status;
+        status << "downlink (" << downlink->framing().describe() << "): " << downlink->bytes_read.load() << " B, " << downlink->frames.load() << " frames";
+        if (downlink->skipped.load() > 0 || downlink->overflowed.load() > 0) {
+            status << ", " << downlink->skipped.load() << " B skipped, " << downlink->overflowed.load() << " B overflowed";
+        }
+        if (downlink->log().path != "") {
+            status << " | log " << downlink->log().path;
+            if (downlink->log().dropped.load() > 0) {
+                status << " (" << downlink->log().dropped.load() << " B dropped)";
+            }
+        }
+        if (downlink->last_error() != "") {
+            status << " | stopped: " << downlink->last_error();
+        }
+        ftxui::Elements lines;
+        for (auto& frame: downlink->recent()) {
+            lines.push_back(ftxui::text(format_frame(frame)));
         }
+        if (lines.empty()) {
+            lines.push_back(ftxui::text("nothing received"));
+        }
+        // focusing the newest frame keeps the panel scrolled to the bottom
+        lines.back() = lines.back() | ftxui::focus;
+        return ftxui::vbox({
+            ftxui::text(status.str()),
+            ftxui::separator(),
+            ftxui::vbox(lines) | ftxui::vscroll_indicator | ftxui::frame | size(ftxui::HEIGHT, ftxui::EQUAL, 10)
+        }) | ftxui::border;
     };
 
     // UI layout for the bypass button and send button
@@ -175,6 +309,7 @@ int main(int argc, char** argv) {
     });
 
     auto renderer = ftxui::Renderer(container, [&] {
+        trace::Span span("render", "ui");
         return ftxui::vbox({
             ftxui::separator(),
             ftxui::text("selection: " + put_selection_note()),
@@ -188,6 +323,8 @@ int main(int argc, char** argv) {
             }),
             ftxui::text("previous command: " + put_debug_str()),
             ftxui::text("                  " + put_debug_hex()),
+            ftxui::text(put_uplink_status()),
+            downlink ? downlink_panel() : ftxui::text("downlink: off"),
             ftxui::separator()
         });
     });
@@ -200,6 +337,7 @@ int main(int argc, char** argv) {
     //      the port/socket polling thread is blocked.
     std::atomic<bool> refresh_ui_continue = true;
     std::thread refresh_ui([&] {
+        trace::set_thread_name("refresh");
         while (refresh_ui_continue) {
             using namespace std::chrono_literals;
             std::this_thread::sleep_for(20ms);
@@ -219,5 +357,12 @@ int main(int argc, char** argv) {
     refresh_ui_continue = false;
     refresh_ui.join();
 
+    // let anything still queued go out before closing:
+    if (!uplink.drain(std::chrono::seconds(2))) {
+        std::cerr << "quitting with " << uplink.depth() << " commands still queued.\n";
+    }
+    stop_io();
+    trace::stop();
+
     return 0;
 }
\ No newline at end of file
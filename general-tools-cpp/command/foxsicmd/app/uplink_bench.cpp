@@ -0,0 +1,198 @@
+#include "line.h"
+#include "uplink.h"
+#include "simulator.h"
+#include <boost/program_options.hpp>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <map>
+
+namespace {
+    struct Send {
+        uint8_t system;
+        std::vector<uint8_t> bytes;
+        std::string label;
+    };
+
+    // mean, median, p99 and max of `values`
+    std::string summary(std::vector<double> values) {
+        if (values.empty()) {
+            return "none";
+        }
+        std::sort(values.begin(), values.end());
+        double sum = 0;
+        for (double value: values) {
+            sum += value;
+        }
+        std::stringstream text;
+        text << std::fixed << std::setprecision(1);
+        text << "mean " << sum / values.size() << ", median " << values[values.size() / 2] << ", p99 " << values[std::min(values.size() - 1, values.size() * 99 / 100)] << ", max " << values.back();
+        return text.str();
+    }
+}
+
+/**
+ * @brief Benchmark the uplink end to end, without hardware: commands go through `Line`'s serial port and `Uplink` to a `SerialSim` on a pseudo-terminal, which timestamps them as they arrive.
+ *
+ * Run like `./bin/uplink_bench --builtin-deck --count 2000` (or with `--config systems.json`). Options it doesn't know are passed to `Line`, so `--no-pacing`, `--min-gap`, `--system-rate` and `--latency-report` work as in foxsicmd; `--port` is always the simulator. Exits with status 1 if any command didn't arrive intact.
+ */
+int main(int argc, char** argv) {
+    boost::program_options::options_description options("uplink_bench options");
+    options.add_options()
+        ("help,h",                                                              "output help message")
+        ("count",       boost::program_options::value<size_t>()->default_value(1000), "commands to send")
+        ("rate",        boost::program_options::value<double>()->default_value(0), "commands per second to send at, 0 for as fast as possible")
+        ("mode",        boost::program_options::value<std::string>()->default_value("formatter"), "formatter, or timepix to bypass the Formatter")
+        ("sim-baud",    boost::program_options::value<int64_t>()->default_value(-1), "line speed for the simulator to model: -1 for the config's, 0 for none")
+    ;
+    boost::program_options::variables_map vm;
+    auto parsed = boost::program_options::command_line_parser(argc, argv).options(options).allow_unregistered().run();
+    boost::program_options::store(parsed, vm);
+    boost::program_options::notify(vm);
+    if (vm.count("help")) {
+        std::cout << "usage: uplink_bench [options] [foxsicmd options]\n\n" << options << "\n";
+        return 0;
+    }
+    size_t count = vm["count"].as<size_t>();
+    double rate = vm["rate"].as<double>();
+    std::string mode = vm["mode"].as<std::string>();
+    if (mode != "formatter" && mode != "timepix") {
+        std::cerr << "--mode must be formatter or timepix\n";
+        return 1;
+    }
+
+    SimSettings settings;
+    settings.mode = mode == "timepix" ? SimMode::timepix : SimMode::formatter;
+    SerialSim sim(settings);
+    std::string error;
+    if (!sim.open(error)) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+
+    // everything else is for Line, with the simulator as its port:
+    std::vector<std::string> line_args = {argv[0]};
+    for (auto& arg: boost::program_options::collect_unrecognized(parsed.options, boost::program_options::include_positional)) {
+        line_args.push_back(arg);
+    }
+    line_args.push_back("--port");
+    line_args.push_back(sim.device());
+    std::vector<char*> line_argv;
+    for (auto& arg: line_args) {
+        line_argv.push_back(arg.data());
+    }
+    boost::asio::io_context context;
+    Line lf(static_cast<int>(line_argv.size()), line_argv.data(), context);
+
+    // what to send: every command in the deck, round robin
+    std::vector<Send> deck_sends;
+    for (auto& system: lf.deck.systems()) {
+        if (settings.mode == SimMode::timepix && system.name != "timepix") {
+            continue;
+        }
+        for (auto& command: lf.deck.lookup_commands(system.hex)) {
+            if (settings.mode == SimMode::timepix) {
+                // the simulated Timepix takes one byte per command
+                if (command.write_value.size() == 1) {
+                    deck_sends.push_back({system.hex, command.write_value, system.name + " > " + command.name});
+                }
+            } else {
+                deck_sends.push_back({system.hex, {system.hex, command.hex}, system.name + " > " + command.name});
+            }
+        }
+    }
+    if (deck_sends.empty()) {
+        std::cerr << (settings.mode == SimMode::timepix ? "no one-byte timepix commands in the deck\n" : "no commands in the deck\n");
+        return 1;
+    }
+
+    Uplink uplink(lf.port, lf.interface, lf.pacing);
+    uplink.measure_wire = lf.latency_report;
+    std::mutex record_mutex;
+    std::map<uint64_t, UplinkRecord> records;
+    uplink.on_done = [&](const UplinkRecord& record) {
+        std::lock_guard<std::mutex> lock(record_mutex);
+        records[record.id] = record;
+    };
+
+    int64_t sim_baud = vm["sim-baud"].as<int64_t>();
+    sim.settings.baud_rate = sim_baud < 0 ? lf.interface.baud_rate : static_cast<uint32_t>(sim_baud);
+    sim.settings.bits_per_byte = uplink.pacer.bits_per_byte();
+    sim.start();
+
+    auto guard = boost::asio::make_work_guard(context);
+    std::thread io_thread([&] { context.run(); });
+
+    std::cout << "sending " << count << " commands (" << mode << ") ";
+    if (rate > 0) {
+        std::cout << "at " << rate << "/s";
+    } else {
+        std::cout << "as fast as possible";
+    }
+    std::cout << ", simulator at " << (sim.settings.baud_rate > 0 ? std::to_string(sim.settings.baud_rate) + " baud" : "no modelled baud rate");
+    std::cout << ", pacing " << (lf.pacing.enabled ? "on" : "off") << "\n";
+
+    std::vector<Send> sent;
+    sent.reserve(count);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t k = 0; k < count; ++k) {
+        if (rate > 0) {
+            std::this_thread::sleep_until(start + std::chrono::nanoseconds(static_cast<int64_t>(k * 1e9 / rate)));
+        }
+        const Send& send = deck_sends[k % deck_sends.size()];
+        uplink.send(send.system, send.bytes, send.label);
+        sent.push_back(send);
+    }
+    bool drained = uplink.drain(std::chrono::seconds(60));
+    bool arrived = sim.wait_for(count, std::chrono::seconds(5));
+    sim.stop();
+    guard.reset();
+    context.stop();
+    io_thread.join();
+
+    // commands arrive in the order they were sent, so the k-th arrival is the k-th send
+    auto arrivals = sim.arrivals();
+    std::vector<double> latency;
+    std::vector<double> waited;
+    std::vector<double> to_wire;
+    size_t wrong = 0;
+    int64_t first = 0;
+    {
+        std::lock_guard<std::mutex> lock(record_mutex);
+        size_t k = 0;
+        for (auto& [id, record]: records) {
+            if (k == 0) {
+                first = record.queued;
+            }
+            waited.push_back(record.wait_ns() / 1e3);
+            if (record.drained != 0) {
+                to_wire.push_back(record.to_wire_ns() / 1e3);
+            }
+            if (k < arrivals.size()) {
+                if (arrivals[k].bytes != sent[k].bytes) {
+                    wrong += 1;
+                }
+                latency.push_back((arrivals[k].time - record.queued) / 1e3);
+            }
+            k += 1;
+        }
+    }
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "arrived " << arrivals.size() << " of " << count << ", " << wrong << " wrong, " << sim.partial.load() << " partial bytes, " << uplink.failed.load() << " failed writes";
+    std::cout << (drained ? "" : ", uplink didn't drain") << (arrived ? "" : ", simulator timed out") << "\n";
+    if (!arrivals.empty() && first != 0) {
+        double seconds = (arrivals.back().time - first) / 1e9;
+        std::cout << "throughput: " << arrivals.size() / seconds << " commands/s over " << std::setprecision(3) << seconds << std::setprecision(1) << " s\n";
+    }
+    std::cout << "latency (send to arrival), us: " << summary(latency) << "\n";
+    std::cout << "queued (send to start of write), us: " << summary(waited) << "\n";
+    if (!to_wire.empty()) {
+        std::cout << "write-to-wire, us: " << summary(to_wire) << "\n";
+    }
+    std::cout << "pacing: " << uplink.pacer.stats().to_string() << "\n";
+    return arrivals.size() == count && wrong == 0 && uplink.failed.load() == 0 ? 0 : 1;
+}
@@ -0,0 +1,47 @@
+#include "builtin.h"
+// generated by deckgen into the build tree:
+#include "builtin_deck_data.h"
+
+bool builtin_deck::available() {
+    return data::available;
+}
+
+std::string builtin_deck::source() {
+    return data::source;
+}
+
+bool builtin_deck::load(bool timepix, UARTInfo& interface, Deck& deck, std::string& error) {
+    if (!data::available) {
+        error = "this build has no built-in deck (foxsi4-commands wasn't found when it was configured)";
+        return false;
+    }
+    const UARTEntry& uart = timepix ? data::timepix : data::uplink;
+    if (uart.baud_rate == 0) {
+        error = timepix ? "the built-in deck has no timepix UART settings" : "the built-in deck has no uplink UART settings";
+        return false;
+    }
+    interface = UARTInfo(uart.port_name, uart.baud_rate, uart.data_bits, uart.stop_bits, uart.parity);
+    interface.flow_control = uart.flow_control;
+    interface.read_min = uart.read_min;
+    interface.read_timeout = uart.read_timeout;
+    interface.low_latency = uart.low_latency;
+    interface.latency_timer = uart.latency_timer;
+    interface.xmit_fifo = uart.xmit_fifo;
+
+    std::vector<System> systems;
+    std::vector<std::vector<Command>> commands;
+    systems.reserve(data::systems.size());
+    commands.reserve(data::systems.size());
+    for (auto& system: data::systems) {
+        systems.push_back(System(system.hex, system.name, system.command_type));
+        commands.push_back({});
+        commands.back().reserve(system.count);
+        for (uint32_t k = system.first; k < system.first + system.count; ++k) {
+            const CommandEntry& command = data::commands[k];
+            auto value = data::write_values.begin() + command.write_first;
+            commands.back().push_back(Command(command.hex, command.name, command.color, command.order, std::vector<uint8_t>(value, value + command.write_count)));
+        }
+    }
+    deck = Deck(systems, commands);
+    return true;
+}
@@ -0,0 +1,65 @@
+#ifndef BUILTIN_H
+#define BUILTIN_H
+
+#include "commands.h"
+#include "uart.h"
+#include <string>
+#include <cstdint>
+
+/**
+ * @brief The command deck compiled into foxsicmd, for `--builtin-deck`.
+ *
+ * At build time, `deckgen` turns `external/foxsi4-commands` (or whatever `FOXSI4_COMMANDS_DIR` points to) into `builtin_deck_data.h`: `constexpr` tables of every system and command, and the uplink and Timepix UART settings. Loading the built-in deck reads no files and parses nothing. If the commands weren't there when the build was configured, the tables are empty and `::available` is false.
+ */
+namespace builtin_deck {
+    struct SystemEntry {
+        uint8_t hex;
+        const char* name;
+        const char* command_type;
+        // this system's commands are `commands[first]` to `commands[first + count - 1]`
+        uint32_t first;
+        uint32_t count;
+    };
+    struct CommandEntry {
+        uint8_t hex;
+        const char* name;
+        uint32_t color;
+        uint32_t order;
+        // the write value is `write_values[write_first]` onwards
+        uint32_t write_first;
+        uint32_t write_count;
+    };
+    struct UARTEntry {
+        const char* port_name;
+        uint32_t baud_rate;
+        uint8_t data_bits;
+        uint8_t stop_bits;
+        uint8_t parity;
+        uint8_t flow_control;
+        uint8_t read_min;
+        uint8_t read_timeout;
+        bool low_latency;
+        uint8_t latency_timer;
+        uint32_t xmit_fifo;
+    };
+
+    /**
+     * @brief Check whether this build has a deck compiled in.
+     */
+    bool available();
+    /**
+     * @brief The systems file the built-in deck was generated from.
+     */
+    std::string source();
+
+    /**
+     * @brief Fill `interface` and `deck` from the compiled-in tables.
+     *
+     * @param timepix use the Timepix UART settings instead of the uplink ones.
+     * @param error set to a description of the problem if there's no built-in deck (or no Timepix UART in it).
+     * @return true if `interface` and `deck` were filled.
+     */
+    bool load(bool timepix, UARTInfo& interface, Deck& deck, std::string& error);
+};
+
+#endif
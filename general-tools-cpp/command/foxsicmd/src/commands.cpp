@@ -3,6 +3,7 @@
 #include <iostream>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 
 TreeItem::TreeItem(uint8_t hex, std::string name) {
     this->hex = hex;
@@ -16,11 +17,11 @@ TreeItem::TreeItem(uint8_t hex, std::string name, uint32_t color, uint32_t order
     this->order = order;
 }
 
-std::string TreeItem::to_string() {
+std::string TreeItem::to_string() const {
     return std::string("name: " + this->name + "\n" + "hex: " + std::to_string(this->hex));
 }
 
-ftxui::Color TreeItem::get_color() {
+ftxui::Color TreeItem::get_color() const {
     uint8_t r = (this->color >> 16) & 0xff;
     uint8_t g = (this->color >> 8)  & 0xff;
     uint8_t b = (this->color >> 0)  & 0xff;
@@ -28,101 +29,148 @@ ftxui::Color TreeItem::get_color() {
     return ftxui::Color::RGB(r, g, b);
 }
 
-Deck::Deck() {
-    this->systems = std::vector<System>();
-    this->commands = std::vector<Command>();
-}
+// what lookups that find nothing refer to
+static const System no_system;
+static const Command no_command;
 
-void Deck::add(uint8_t system, std::vector<Command> commands) { 
-    std::unordered_map<uint8_t, Command> inner;
-    for (auto c: commands) {
-        inner[c.hex] = c;
-    }
-    this->lookup_map[system] = inner;
+Deck::Deck(): command_table(256 * 256, none) {
+    system_slot.fill(none);
 }
 
-System Deck::lookup(uint8_t system) {
-    for (auto s : this->systems) {
-        if (s.hex == system) {
-            return s;
+Deck::Deck(std::vector<System> systems, std::vector<std::vector<Command>> commands): Deck() {
+    // one slot per system code. A repeated code keeps its first system and its last command list.
+    std::vector<const std::vector<Command>*> lists;
+    for (size_t k = 0; k < systems.size(); ++k) {
+        const std::vector<Command>* list = k < commands.size() ? &commands[k] : nullptr;
+        uint32_t s = system_slot[systems[k].hex];
+        if (s == none) {
+            system_slot[systems[k].hex] = system_list.size();
+            system_list.push_back(systems[k]);
+            lists.push_back(list);
+        } else if (list) {
+            lists[s] = list;
         }
     }
-    return System();
-}
-System Deck::lookup(std::string system) {
-    for (auto s : this->systems) {
-        if (s.name == system) {
-            return s;
-        }
-    }
-    return System();
-}
-Command Deck::lookup(uint8_t system, uint8_t command) {
-    for (auto s : this->systems) {
-        if (s.hex == system) {
-            for (auto c : this->commands) {
-                if (c.hex == command) {
-                    return c;
+
+    // lay each system's commands out contiguously, sorted by order, keeping the last of any repeated code:
+    for (uint32_t s = 0; s < system_list.size(); ++s) {
+        uint32_t begin = command_list.size();
+        if (lists[s]) {
+            const std::vector<Command>& list = *lists[s];
+            std::array<size_t, 256> last;
+            for (size_t k = 0; k < list.size(); ++k) {
+                last[list[k].hex] = k;
+            }
+            for (size_t k = 0; k < list.size(); ++k) {
+                if (last[list[k].hex] == k) {
+                    command_list.push_back(list[k]);
                 }
             }
+            std::stable_sort(command_list.begin() + begin, command_list.end(), [](const Command& a, const Command& b) {
+                return a.order < b.order;
+            });
+        }
+        command_range.push_back({begin, static_cast<uint32_t>(command_list.size())});
+        for (uint32_t i = begin; i < command_list.size(); ++i) {
+            command_table[static_cast<size_t>(system_list[s].hex) << 8 | command_list[i].hex] = i;
         }
     }
-    return Command();
-}
 
-Command Deck::lookup(std::string system, std::string command) {
-    for (auto s : this->systems) {
-        if (s.name == system) {
-            for (auto c : this->commands) {
-                if (c.name == command) {
-                    return c;
-                }
-            }
+    // copy every name into one arena, and index views of them:
+    size_t arena_size = 0;
+    for (auto& system: system_list) {
+        arena_size += system.name.size();
+    }
+    for (auto& command: command_list) {
+        arena_size += command.name.size();
+    }
+    arena = std::make_unique<char[]>(std::max<size_t>(arena_size, 1));
+    char* next = arena.get();
+    auto intern = [&next](const std::string& name) {
+        std::copy(name.begin(), name.end(), next);
+        std::string_view view(next, name.size());
+        next += name.size();
+        return view;
+    };
+    system_names.reserve(system_list.size());
+    command_names.reserve(command_list.size());
+    for (uint32_t s = 0; s < system_list.size(); ++s) {
+        system_names.emplace(intern(system_list[s].name), s);
+        for (uint32_t i = command_range[s].first; i < command_range[s].second; ++i) {
+            command_names.emplace(NameKey{s, intern(command_list[i].name)}, i);
         }
     }
-    return Command();
 }
 
-std::vector<Command> Deck::lookup_commands(uint8_t system) {
-    std::vector<Command> result;
-    for (auto& c: this->lookup_map[system]) {
-        result.push_back(c.second);
+const System& Deck::lookup(uint8_t system) const {
+    uint32_t s = slot(system);
+    return s == none ? no_system : system_list[s];
+}
+
+const System& Deck::lookup(std::string_view system) const {
+    auto found = system_names.find(system);
+    return found == system_names.end() ? no_system : system_list[found->second];
+}
+
+const Command& Deck::lookup(uint8_t system, uint8_t command) const {
+    uint32_t i = command_table[static_cast<size_t>(system) << 8 | command];
+    return i == none ? no_command : command_list[i];
+}
+
+const Command& Deck::lookup(std::string_view system, std::string_view command) const {
+    auto found_system = system_names.find(system);
+    if (found_system == system_names.end()) {
+        return no_command;
+    }
+    auto found = command_names.find(NameKey{found_system->second, command});
+    return found == command_names.end() ? no_command : command_list[found->second];
+}
+
+bool Deck::contains(uint8_t system, uint8_t command) const {
+    return command_table[static_cast<size_t>(system) << 8 | command] != none;
+}
+
+std::span<const Command> Deck::lookup_commands(uint8_t system) const {
+    uint32_t s = slot(system);
+    if (s == none) {
+        return {};
     }
-    return result;
+    return std::span<const Command>(command_list.data() + command_range[s].first, command_range[s].second - command_range[s].first);
 }
 
-std::vector<Command> Deck::lookup_commands(std::string system) {
-    std::vector<Command> result;
-    for (auto& c: this->lookup_map[this->lookup(system).hex]) {
-        result.push_back(c.second);
+std::span<const Command> Deck::lookup_commands(std::string_view system) const {
+    auto found = system_names.find(system);
+    if (found == system_names.end()) {
+        return {};
     }
-    return result;
+    return lookup_commands(system_list[found->second].hex);
 }
 
-std::vector<std::string> Deck::lookup_commands_str(uint8_t system) {
+std::vector<std::string> Deck::lookup_commands_str(uint8_t system) const {
     std::vector<std::string> result;
-    for (auto& c: this->lookup_map[system]) {
-        result.push_back(c.second.name);
+    for (auto& c: lookup_commands(system)) {
+        result.push_back(c.name);
     }
     return result;
 }
-std::vector<std::string> Deck::lookup_commands_str(std::string system) {
+
+std::vector<std::string> Deck::lookup_commands_str(std::string_view system) const {
     std::vector<std::string> result;
-    for (auto& c: this->lookup_map[this->lookup(system).hex]) {
-        result.push_back(c.second.name);
+    for (auto& c: lookup_commands(system)) {
+        result.push_back(c.name);
     }
     return result;
 }
 
-std::string Deck::to_string() {
+std::string Deck::to_string() const {
     std::stringstream result;
     result << "Deck::systems:\n";
 
-    for (auto& s: this->lookup_map) {
-        result << "\t" << this->lookup(s.first).name << "\n";
-        for (auto& c: this->lookup_map[s.first]) {
-            result << "\t\t" << c.second.name << "\n";
+    for (auto& s: system_list) {
+        result << "\t" << s.name << "\n";
+        for (auto& c: lookup_commands(s.hex)) {
+            result << "\t\t" << c.name << "\n";
         }
     }
     return result.str();
-}
\ No newline at end of file
+}
@@ -3,15 +3,19 @@
 
 #include <unordered_map>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <array>
+#include <span>
+#include <memory>
 #include "ftxui/screen/color.hpp"
 
 class TreeItem{
     public:
-        uint8_t hex;
+        uint8_t hex = 0;
         std::string name;
-        uint32_t color;
-        uint32_t order;
+        uint32_t color = 0;
+        uint32_t order = 0;
 
         std::unordered_map<uint8_t, std::string> lookup_name;
         std::unordered_map<std::string, uint8_t> lookup_hex;
@@ -20,8 +24,8 @@ class TreeItem{
         TreeItem(uint8_t hex, std::string name, uint32_t color, uint32_t order);
         TreeItem() {};
 
-        ftxui::Color get_color();
-        std::string to_string();
+        ftxui::Color get_color() const;
+        std::string to_string() const;
 };
 
 class Command: public TreeItem {
@@ -44,28 +48,90 @@ class System: public TreeItem {
         std::string interface;
 };
 
+/**
+ * @brief An immutable, flat index of every system and command, built once when the config is loaded.
+ *
+ * Every lookup is O(1) and returns a const reference into the deck, so scripts can look commands up in tight loops without copying:
+ * - (system, command) codes index a dense 256 × 256 table,
+ * - names are hashed as `std::string_view`s into one string arena,
+ * - each system's commands are stored contiguously, already sorted by their `order`, so `::lookup_commands` is just a view.
+ *
+ * Lookups that find nothing return a reference to an empty `System` or `Command` (hex 0, empty name), like the old linear scans did.
+ */
 class Deck {
     public:
         Deck();
+        /**
+         * @brief Build the index.
+         *
+         * @param systems every system, in display order. If a system code appears more than once, the first system keeps it.
+         * @param commands each system's commands, parallel to `systems`. If a command code appears more than once for a system, the last one is kept.
+         */
+        Deck(std::vector<System> systems, std::vector<std::vector<Command>> commands);
 
-        void add(uint8_t system, std::vector<Command> commands);
-        
-        System lookup(uint8_t system);
-        System lookup(std::string system);
-        Command lookup(uint8_t system, uint8_t command);
-        Command lookup(std::string system, std::string command);
-        std::vector<Command> lookup_commands(uint8_t system);
-        std::vector<Command> lookup_commands(std::string system);
-        std::vector<std::string> lookup_commands_str(uint8_t system);
-        std::vector<std::string> lookup_commands_str(std::string system);
-        
-        std::vector<System> systems;
-        std::vector<Command> commands;
-
-        std::string to_string();
+        // the name index points into `arena`, which moves with the deck but can't be shared by a copy:
+        Deck(Deck&&) = default;
+        Deck& operator=(Deck&&) = default;
+        Deck(const Deck&) = delete;
+        Deck& operator=(const Deck&) = delete;
+
+        const System& lookup(uint8_t system) const;
+        const System& lookup(std::string_view system) const;
+        const Command& lookup(uint8_t system, uint8_t command) const;
+        const Command& lookup(std::string_view system, std::string_view command) const;
+        /**
+         * @brief Check whether `system` has a command with code `command`.
+         */
+        bool contains(uint8_t system, uint8_t command) const;
+
+        /**
+         * @brief All of a system's commands, sorted by `order`. Empty for an unknown system.
+         */
+        std::span<const Command> lookup_commands(uint8_t system) const;
+        std::span<const Command> lookup_commands(std::string_view system) const;
+        std::vector<std::string> lookup_commands_str(uint8_t system) const;
+        std::vector<std::string> lookup_commands_str(std::string_view system) const;
+
+        /**
+         * @brief Every system, in the order they were given.
+         */
+        const std::vector<System>& systems() const { return system_list; }
+        /**
+         * @brief Total number of commands in the deck.
+         */
+        size_t size() const { return command_list.size(); }
+
+        std::string to_string() const;
 
     private:
-        std::unordered_map<uint8_t, std::unordered_map<uint8_t, Command>> lookup_map;
+        // a command name within one system, for the name index
+        struct NameKey {
+            uint32_t slot;
+            std::string_view name;
+            bool operator==(const NameKey& other) const { return slot == other.slot && name == other.name; }
+        };
+        struct NameKeyHash {
+            size_t operator()(const NameKey& key) const { return std::hash<std::string_view>()(key.name) * 31 + key.slot; }
+        };
+        static constexpr uint32_t none = 0xffffffff;
+
+        // index of a system in `system_list`, or `none`
+        uint32_t slot(uint8_t system) const { return system_slot[system]; }
+
+        std::vector<System> system_list;
+        // every command, grouped by system in `system_list` order and sorted by `order` within each group
+        std::vector<Command> command_list;
+        // range of each system's commands in `command_list`, parallel to `system_list`
+        std::vector<std::pair<uint32_t, uint32_t>> command_range;
+
+        std::array<uint32_t, 256> system_slot;
+        // (system << 8 | command) -> index into `command_list`, or `none`
+        std::vector<uint32_t> command_table;
+
+        // every name, back to back; the name index keys point into it
+        std::unique_ptr<char[]> arena;
+        std::unordered_map<std::string_view, uint32_t> system_names;
+        std::unordered_map<NameKey, uint32_t, NameKeyHash> command_names;
 };
 
 #endif
\ No newline at end of file
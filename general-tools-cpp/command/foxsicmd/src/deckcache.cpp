@@ -0,0 +1,310 @@
+#include "deckcache.h"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+    template <typename T>
+    void put(std::string& out, size_t offset, T value) {
+        std::memcpy(&out[offset], &value, sizeof(T));
+    }
+
+    template <typename T>
+    T get(const unsigned char* base, size_t offset) {
+        T value;
+        std::memcpy(&value, base + offset, sizeof(T));
+        return value;
+    }
+
+    // 64-bit FNV-1a
+    uint64_t fnv1a(const char* data, size_t size) {
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t k = 0; k < size; ++k) {
+            hash ^= static_cast<unsigned char>(data[k]);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    bool stat_file(const std::string& path, uint64_t& size, int64_t& mtime) {
+        std::error_code err;
+        size = std::filesystem::file_size(path, err);
+        if (err) {
+            return false;
+        }
+        auto time = std::filesystem::last_write_time(path, err);
+        if (err) {
+            return false;
+        }
+        mtime = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+        return true;
+    }
+
+    bool hash_file(const std::string& path, uint64_t& hash) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in.is_open()) {
+            return false;
+        }
+        std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        hash = fnv1a(content.data(), content.size());
+        return true;
+    }
+
+    // strings are appended to one area and referred to by (offset, length)
+    struct StringArea {
+        std::string data;
+        void add(std::string& out, size_t offset, const std::string& value) {
+            put<uint32_t>(out, offset, static_cast<uint32_t>(data.size()));
+            put<uint32_t>(out, offset + 4, static_cast<uint32_t>(value.size()));
+            data += value;
+        }
+    };
+
+    // a read-only mapping of the cache file, unmapped when it goes out of scope
+    struct Mapping {
+        const unsigned char* base = nullptr;
+        size_t size = 0;
+        ~Mapping() {
+            if (base) {
+                munmap(const_cast<unsigned char*>(base), size);
+            }
+        }
+    };
+}
+
+std::string deck_cache::default_path(const std::string& config_path) {
+    std::error_code err;
+    std::string full = std::filesystem::weakly_canonical(config_path, err).string();
+    if (err) {
+        full = config_path;
+    }
+    std::filesystem::path dir;
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+        dir = xdg;
+    } else if (const char* home = std::getenv("HOME"); home && *home) {
+        dir = std::filesystem::path(home) / ".cache";
+    } else {
+        dir = std::filesystem::temp_directory_path();
+    }
+    std::stringstream name;
+    name << "deck_" << std::hex << std::setfill('0') << std::setw(16) << fnv1a(full.data(), full.size()) << ".bin";
+    return (dir / "foxsicmd" / name.str()).string();
+}
+
+bool deck_cache::save(const std::string& cache_path, const std::vector<std::string>& sources, bool timepix, const UARTInfo& interface, const Deck& deck, std::string& error) {
+    size_t sources_offset = header_size;
+    size_t systems_offset = sources_offset + sources.size() * record_size;
+    size_t commands_offset = systems_offset + deck.systems().size() * record_size;
+    size_t strings_offset = commands_offset + deck.size() * record_size;
+    std::string out(strings_offset, '\0');
+    StringArea strings;
+
+    std::memcpy(&out[0], magic, sizeof(magic));
+    put<uint32_t>(out, 8, version);
+    put<uint32_t>(out, 12, timepix ? 1 : 0);
+    put<uint32_t>(out, 16, static_cast<uint32_t>(sources.size()));
+    put<uint32_t>(out, 20, static_cast<uint32_t>(deck.systems().size()));
+    put<uint32_t>(out, 24, static_cast<uint32_t>(deck.size()));
+    put<uint64_t>(out, 32, sources_offset);
+    put<uint64_t>(out, 40, systems_offset);
+    put<uint64_t>(out, 48, commands_offset);
+    put<uint64_t>(out, 56, strings_offset);
+    put<uint32_t>(out, 64, interface.baud_rate);
+    put<uint8_t>(out, 68, interface.data_bits);
+    put<uint8_t>(out, 69, interface.stop_bits);
+    put<uint8_t>(out, 70, interface.parity);
+    put<uint8_t>(out, 71, interface.flow_control);
+    put<uint32_t>(out, 28, interface.xmit_fifo);
+    put<uint8_t>(out, 88, interface.read_min);
+    put<uint8_t>(out, 89, interface.read_timeout);
+    put<uint8_t>(out, 90, interface.low_latency ? 1 : 0);
+    put<uint8_t>(out, 91, interface.latency_timer);
+    strings.add(out, 72, interface.port_name);
+
+    for (size_t k = 0; k < sources.size(); ++k) {
+        size_t record = sources_offset + k * record_size;
+        std::error_code err;
+        std::string path = std::filesystem::canonical(sources[k], err).string();
+        uint64_t size, hash;
+        int64_t mtime;
+        if (err || !stat_file(path, size, mtime) || !hash_file(path, hash)) {
+            error = "couldn't read " + sources[k];
+            return false;
+        }
+        put<uint64_t>(out, record, size);
+        put<int64_t>(out, record + 8, mtime);
+        put<uint64_t>(out, record + 16, hash);
+        strings.add(out, record + 24, path);
+    }
+
+    size_t command_record = commands_offset;
+    for (size_t k = 0; k < deck.systems().size(); ++k) {
+        const System& system = deck.systems()[k];
+        auto commands = deck.lookup_commands(system.hex);
+        size_t record = systems_offset + k * record_size;
+        put<uint8_t>(out, record, system.hex);
+        put<uint32_t>(out, record + 4, system.color);
+        put<uint32_t>(out, record + 8, system.order);
+        strings.add(out, record + 12, system.name);
+        strings.add(out, record + 20, system.interface);
+        put<uint32_t>(out, record + 28, static_cast<uint32_t>(commands.size()));
+        for (auto& command: commands) {
+            put<uint8_t>(out, command_record, command.hex);
+            put<uint32_t>(out, command_record + 4, command.color);
+            put<uint32_t>(out, command_record + 8, command.order);
+            strings.add(out, command_record + 12, command.name);
+            strings.add(out, command_record + 20, std::string(command.write_value.begin(), command.write_value.end()));
+            command_record += record_size;
+        }
+    }
+    out += strings.data;
+    put<uint64_t>(out, 80, out.size());
+
+    // write beside the old cache and rename over it, so a reader never sees half a file:
+    std::error_code err;
+    std::filesystem::path target(cache_path);
+    if (target.has_parent_path()) {
+        std::filesystem::create_directories(target.parent_path(), err);
+    }
+    std::string temp = cache_path + ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        if (!file.write(out.data(), out.size())) {
+            error = "couldn't write " + temp;
+            std::filesystem::remove(temp, err);
+            return false;
+        }
+    }
+    std::filesystem::rename(temp, cache_path, err);
+    if (err) {
+        error = "couldn't replace " + cache_path + ": " + err.message();
+        std::filesystem::remove(temp, err);
+        return false;
+    }
+    return true;
+}
+
+bool deck_cache::load(const std::string& cache_path, const std::string& config_path, bool timepix, UARTInfo& interface, Deck& deck, std::string& reason) {
+    int fd = open(cache_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        reason = "no cache yet";
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < header_size) {
+        close(fd);
+        reason = "cache is too small";
+        return false;
+    }
+    Mapping map;
+    void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        reason = "couldn't map the cache";
+        return false;
+    }
+    map.base = static_cast<const unsigned char*>(mapped);
+    map.size = info.st_size;
+    const unsigned char* base = map.base;
+
+    if (std::memcmp(base, magic, sizeof(magic)) != 0 || get<uint32_t>(base, 8) != version) {
+        reason = "cache has another layout version";
+        return false;
+    }
+    if ((get<uint32_t>(base, 12) & 1) != (timepix ? 1u : 0u)) {
+        reason = timepix ? "cache was built without --timepix" : "cache was built for --timepix";
+        return false;
+    }
+    uint32_t source_count = get<uint32_t>(base, 16);
+    uint32_t system_count = get<uint32_t>(base, 20);
+    uint32_t command_count = get<uint32_t>(base, 24);
+    uint64_t sources_offset = get<uint64_t>(base, 32);
+    uint64_t systems_offset = get<uint64_t>(base, 40);
+    uint64_t commands_offset = get<uint64_t>(base, 48);
+    uint64_t strings_offset = get<uint64_t>(base, 56);
+    if (get<uint64_t>(base, 80) != map.size || source_count == 0
+            || sources_offset + uint64_t(source_count) * record_size > map.size
+            || systems_offset + uint64_t(system_count) * record_size > map.size
+            || commands_offset + uint64_t(command_count) * record_size > map.size
+            || strings_offset > map.size) {
+        reason = "cache is damaged";
+        return false;
+    }
+    bool damaged = false;
+    auto text = [&](size_t offset) {
+        uint64_t begin = strings_offset + get<uint32_t>(base, offset);
+        uint32_t length = get<uint32_t>(base, offset + 4);
+        if (begin + length > map.size) {
+            damaged = true;
+            return std::string();
+        }
+        return std::string(reinterpret_cast<const char*>(base + begin), length);
+    };
+
+    // every source must be unchanged: same size, and the same modification time or (if touched) the same content.
+    std::error_code err;
+    std::string config = std::filesystem::canonical(config_path, err).string();
+    for (uint32_t k = 0; k < source_count; ++k) {
+        size_t record = sources_offset + k * record_size;
+        std::string path = text(record + 24);
+        if (k == 0 && path != config) {
+            reason = "cache was built from " + path;
+            return false;
+        }
+        uint64_t size, hash;
+        int64_t mtime;
+        if (!stat_file(path, size, mtime)) {
+            reason = path + " is gone";
+            return false;
+        }
+        if (size != get<uint64_t>(base, record) || (mtime != get<int64_t>(base, record + 8) && (!hash_file(path, hash) || hash != get<uint64_t>(base, record + 16)))) {
+            reason = path + " changed";
+            return false;
+        }
+    }
+
+    std::vector<System> systems;
+    std::vector<std::vector<Command>> commands;
+    size_t command_record = commands_offset;
+    size_t command_end = commands_offset + size_t(command_count) * record_size;
+    for (uint32_t k = 0; k < system_count; ++k) {
+        size_t record = systems_offset + k * record_size;
+        System system(get<uint8_t>(base, record), text(record + 12), text(record + 20));
+        system.color = get<uint32_t>(base, record + 4);
+        system.order = get<uint32_t>(base, record + 8);
+        systems.push_back(system);
+        commands.push_back({});
+        uint32_t count = get<uint32_t>(base, record + 28);
+        for (uint32_t c = 0; c < count && command_record < command_end; ++c) {
+            std::string value = text(command_record + 20);
+            commands.back().push_back(Command(get<uint8_t>(base, command_record), text(command_record + 12), get<uint32_t>(base, command_record + 4), get<uint32_t>(base, command_record + 8), std::vector<uint8_t>(value.begin(), value.end())));
+            command_record += record_size;
+        }
+    }
+    interface.baud_rate = get<uint32_t>(base, 64);
+    interface.data_bits = get<uint8_t>(base, 68);
+    interface.stop_bits = get<uint8_t>(base, 69);
+    interface.parity = get<uint8_t>(base, 70);
+    interface.flow_control = get<uint8_t>(base, 71);
+    interface.xmit_fifo = get<uint32_t>(base, 28);
+    interface.read_min = get<uint8_t>(base, 88);
+    interface.read_timeout = get<uint8_t>(base, 89);
+    interface.low_latency = (get<uint8_t>(base, 90) & 1) != 0;
+    interface.latency_timer = get<uint8_t>(base, 91);
+    interface.port_name = text(72);
+    if (damaged || command_record != command_end) {
+        reason = "cache is damaged";
+        return false;
+    }
+
+    deck = Deck(systems, commands);
+    return true;
+}
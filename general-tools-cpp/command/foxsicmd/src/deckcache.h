@@ -0,0 +1,75 @@
+#ifndef DECKCACHE_H
+#define DECKCACHE_H
+
+#include "commands.h"
+#include "uart.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief A compiled binary copy of the command deck and UART settings, so later starts can skip parsing JSON.
+ *
+ * The cache records every file it was built from (the systems file, then each command file) with its size, modification time and a content hash. It is used only if all of them still match: a file whose modification time changed is hashed again, so touching a file without editing it doesn't throw the cache away. Anything else (a different config, `--timepix` or not, a new layout version, a damaged file) falls back to JSON and rewrites the cache.
+ *
+ * Layout, version 3 (version 3 changed no field, only the default `UARTInfo::low_latency`, so caches from before are rebuilt). Integers are native byte order; a string is a (uint32 offset into the string area, uint32 length) pair. Header, 96 bytes:
+ * | offset | type     | field                                          |
+ * |--------|----------|------------------------------------------------|
+ * | 0      | char[8]  | magic, "FOXSIDK\0"                             |
+ * | 8      | uint32   | layout version, 3                              |
+ * | 12     | uint32   | flags: bit 0 set if built for `--timepix`      |
+ * | 16     | uint32   | source file count                              |
+ * | 20     | uint32   | system count                                   |
+ * | 24     | uint32   | command count                                  |
+ * | 28     | uint32   | UART transmit FIFO size                        |
+ * | 32     | uint64   | offset of source records (32 bytes each)       |
+ * | 40     | uint64   | offset of system records (32 bytes each)       |
+ * | 48     | uint64   | offset of command records (32 bytes each)      |
+ * | 56     | uint64   | offset of the string area                      |
+ * | 64     | uint32   | UART baud rate                                 |
+ * | 68     | uint8    | UART data bits                                 |
+ * | 69     | uint8    | UART stop bits                                 |
+ * | 70     | uint8    | UART parity                                    |
+ * | 71     | uint8    | UART flow control                              |
+ * | 72     | string   | UART device path                               |
+ * | 80     | uint64   | total file size                                |
+ * | 88     | uint8    | UART VMIN                                      |
+ * | 89     | uint8    | UART VTIME                                     |
+ * | 90     | uint8    | UART flags: bit 0 set for low latency          |
+ * | 91     | uint8    | UART latency timer (ms)                        |
+ * | 92     | uint32   | reserved                                       |
+ *
+ * Source record: uint64 size, int64 modification time (ns), uint64 FNV-1a content hash, string path.
+ * System record: uint8 hex, 3 reserved, uint32 color, uint32 order, string name, string command type, uint32 command count.
+ * Command record: uint8 hex, 3 reserved, uint32 color, uint32 order, string name, string write value (raw bytes), 4 reserved.
+ * Commands follow their systems' order, each system's already sorted as in `Deck`.
+ */
+namespace deck_cache {
+    static constexpr char magic[8] = {'F', 'O', 'X', 'S', 'I', 'D', 'K', '\0'};
+    static constexpr uint32_t version = 3;
+    static constexpr size_t header_size = 96;
+    static constexpr size_t record_size = 32;
+
+    /**
+     * @brief Where the cache for `config_path` lives by default: `$XDG_CACHE_HOME/foxsicmd/` (or `~/.cache/foxsicmd/`), named after a hash of the config's full path.
+     */
+    std::string default_path(const std::string& config_path);
+
+    /**
+     * @brief Load the deck and UART settings from the cache, if it was built from `config_path` and none of its sources changed.
+     *
+     * @param reason set to why the cache wasn't used.
+     * @return true if `interface` and `deck` were filled from the cache.
+     */
+    bool load(const std::string& cache_path, const std::string& config_path, bool timepix, UARTInfo& interface, Deck& deck, std::string& reason);
+
+    /**
+     * @brief Write the cache, replacing any old one atomically.
+     *
+     * @param sources files the deck was built from, the config file first.
+     * @param error set to a description of the problem if the cache couldn't be written.
+     */
+    bool save(const std::string& cache_path, const std::vector<std::string>& sources, bool timepix, const UARTInfo& interface, const Deck& deck, std::string& error);
+};
+
+#endif
@@ -0,0 +1,262 @@
+#include "deckload.h"
+#include "util.h"
+#include "trace.h"
+
+#include <boost/filesystem.hpp>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+
+namespace {
+    // optional low-latency settings from a `uart_interface` entry; anything missing keeps its `UARTInfo` default. False for an unknown `flow_control`.
+    bool read_tuning(const nlohmann::json& uart, UARTInfo& interface, std::string& error) {
+        std::string flow = uart.value("flow_control", std::string("none"));
+        if (flow == "none") {
+            interface.flow_control = 0;
+        } else if (flow == "software") {
+            interface.flow_control = 1;
+        } else if (flow == "hardware") {
+            interface.flow_control = 2;
+        } else {
+            error = "unknown flow_control \"" + flow + "\" in config file (use none, software or hardware)";
+            return false;
+        }
+        interface.read_min = uart.value("vmin", interface.read_min);
+        interface.read_timeout = uart.value("vtime", interface.read_timeout);
+        interface.low_latency = uart.value("low_latency", interface.low_latency);
+        interface.latency_timer = uart.value("latency_timer_ms", interface.latency_timer);
+        interface.xmit_fifo = uart.value("xmit_fifo_size", interface.xmit_fifo);
+        return true;
+    }
+
+    // builds a Command from each entry of a command file as the parser walks it
+    class CommandHandler: public nlohmann::json_sax<nlohmann::json> {
+        public:
+            CommandHandler(std::vector<Command>& commands): commands(commands), depth(0), field(none), entries(0) {}
+
+            std::string error;
+
+            bool null() override { return scalar(); }
+            bool boolean(bool) override { return scalar(); }
+            bool number_integer(number_integer_t) override { return scalar(); }
+            bool number_unsigned(number_unsigned_t) override { return scalar(); }
+            bool number_float(number_float_t, const string_t&) override { return scalar(); }
+            bool binary(binary_t&) override { return scalar(); }
+
+            bool string(string_t& value) override {
+                if (depth == 2 && field != none) {
+                    fields[field] = std::move(value);
+                    seen[field] = true;
+                }
+                field = none;
+                return true;
+            }
+
+            bool key(string_t& name) override {
+                field = none;
+                if (depth == 2) {
+                    for (size_t k = 0; k < field_count; ++k) {
+                        if (name == field_names[k]) {
+                            field = k;
+                            break;
+                        }
+                    }
+                }
+                return true;
+            }
+
+            bool start_object(std::size_t) override {
+                ++depth;
+                field = none;
+                if (depth == 2) {
+                    for (size_t k = 0; k < field_count; ++k) {
+                        seen[k] = false;
+                    }
+                }
+                return true;
+            }
+
+            bool end_object() override {
+                if (depth == 2 && !finish_entry()) {
+                    return false;
+                }
+                --depth;
+                field = none;
+                return true;
+            }
+
+            bool start_array(std::size_t) override {
+                ++depth;
+                field = none;
+                return true;
+            }
+
+            bool end_array() override {
+                --depth;
+                field = none;
+                return true;
+            }
+
+            bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& e) override {
+                error = e.what();
+                return false;
+            }
+
+        private:
+            enum Field: size_t { name, hex, write_value, order, color, field_count, none = field_count };
+            static constexpr const char* field_names[field_count] = {"name", "hex", "write_value", "order", "color"};
+
+            bool scalar() {
+                field = none;
+                return true;
+            }
+
+            bool finish_entry() {
+                for (size_t k = 0; k < field_count; ++k) {
+                    if (!seen[k]) {
+                        error = "entry " + std::to_string(entries) + " has no string \"" + field_names[k] + "\"";
+                        return false;
+                    }
+                }
+                uint8_t cmd_hex = strtol(fields[hex].c_str(), NULL, 16);
+                uint32_t cmd_color = strtoul(fields[color].c_str(), NULL, 16);
+                uint32_t cmd_order = strtoul(fields[order].c_str(), NULL, 10);
+                commands.emplace_back(cmd_hex, std::move(fields[name]), cmd_color, cmd_order, util::string_to_bytes(fields[write_value]));
+                ++entries;
+                return true;
+            }
+
+            std::vector<Command>& commands;
+            // 1 inside the top-level array or object, 2 inside an entry
+            size_t depth;
+            size_t field;
+            size_t entries;
+            std::string fields[field_count];
+            bool seen[field_count];
+    };
+}
+
+bool deck_load::parse_commands(std::string& text, std::vector<Command>& commands, std::string& error) {
+    commands.clear();
+    CommandHandler handler(commands);
+    bool ok = false;
+    try {
+        ok = nlohmann::json::sax_parse(text, &handler);
+    } catch(std::exception& e) {
+        handler.error = e.what();
+    }
+    if (!ok) {
+        error = handler.error == "" ? "parse stopped" : handler.error;
+        commands.clear();
+    }
+    return ok;
+}
+
+std::vector<CommandFileLoad> deck_load::load_command_files(const std::vector<std::string>& paths, size_t threads) {
+    std::vector<CommandFileLoad> loads(paths.size());
+    std::atomic<size_t> next(0);
+
+    // each worker takes the next file until none are left; results land in their own slot, so no locking:
+    auto work = [&](size_t worker) {
+        if (worker > 0) {
+            trace::set_thread_name("deck loader " + std::to_string(worker));
+        }
+        for (size_t k = next.fetch_add(1); k < paths.size(); k = next.fetch_add(1)) {
+            CommandFileLoad& load = loads[k];
+            load.path = paths[k];
+            trace::Span span("load commands", "config", load.path);
+            auto start = std::chrono::steady_clock::now();
+
+            std::ifstream file(load.path, std::ios::binary);
+            if (file.is_open()) {
+                load.opened = true;
+                std::stringstream contents;
+                contents << file.rdbuf();
+                std::string text = contents.str();
+                deck_load::parse_commands(text, load.commands, load.error);
+            }
+            load.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+    };
+
+    size_t count = std::max<size_t>(1, std::min(threads, paths.size()));
+    std::vector<std::thread> pool;
+    for (size_t k = 1; k < count; ++k) {
+        pool.emplace_back(work, k);
+    }
+    // the calling thread works too
+    work(0);
+    for (auto& thread: pool) {
+        thread.join();
+    }
+    return loads;
+}
+
+bool deck_load::uplink_from(const nlohmann::json& systems_data, int timepix, UARTInfo& interface, std::string& error) {
+    for(auto& this_entry: systems_data.items()) {
+        std::string sys_name = this_entry.value()["name"];
+        std::string sys_hex_str = this_entry.value()["hex"];
+        if (timepix) {
+            if (sys_name == "timepix") {
+                try {
+                    interface.port_name = this_entry.value()["uart_interface"]["tty_path"];
+                    interface.baud_rate = this_entry.value()["uart_interface"]["baud_rate"];
+                    interface.data_bits = this_entry.value()["uart_interface"]["data_bits"];
+                    interface.stop_bits = this_entry.value()["uart_interface"]["stop_bits"];
+                    interface.parity = this_entry.value()["uart_interface"]["parity_bits"];
+                    return read_tuning(this_entry.value()["uart_interface"], interface, error);
+                } catch(std::exception& e) {
+                    error = "failed to find uplink UART configuration in config file";
+                    return false;
+                }
+            }
+        } else {
+            if (sys_name == "gse") {
+                try {
+                    interface.port_name = this_entry.value()["logger_interface"]["uplink_device"];
+                } catch(std::exception& e) {
+                    error = "couldn't find uplink device in config file";
+                    return false;
+                }
+            }
+            if (sys_name == "uplink") {
+                try {
+                    interface.baud_rate = this_entry.value()["uart_interface"]["baud_rate"];
+                    interface.data_bits = this_entry.value()["uart_interface"]["data_bits"];
+                    interface.stop_bits = this_entry.value()["uart_interface"]["stop_bits"];
+                    interface.parity = this_entry.value()["uart_interface"]["parity_bits"];
+                    if (!read_tuning(this_entry.value()["uart_interface"], interface, error)) {
+                        return false;
+                    }
+                } catch(std::exception& e) {
+                    std::cerr << "failed to find uplink UART configuration in config file.\n";
+                }
+            }
+        }
+    }
+    return true;
+}
+
+void deck_load::list_command_files(const nlohmann::json& systems_data, const std::string& path, std::vector<System>& systems, std::vector<std::string>& files) {
+    boost::filesystem::path source(path);
+    for(auto& this_entry: systems_data.items()) {
+        std::string sys_name = this_entry.value()["name"];
+        std::string sys_hex_str = this_entry.value()["hex"];
+        uint8_t sys_hex = strtol(sys_hex_str.c_str(), NULL, 16);
+
+        try{
+            std::string this_command_path = this_entry.value().at("commands");
+            std::string this_command_type = this_entry.value().at("command_type");
+
+            // not `canonical`, which throws for a missing file: a system whose file is missing is still listed, so the caller sees it fail to open
+            boost::filesystem::path cmd_path = boost::filesystem::weakly_canonical(source.parent_path() / ".." / this_command_path);
+            systems.push_back(System(sys_hex, sys_name, this_command_type));
+            files.push_back(cmd_path.string());
+        } catch(std::exception &e) {}
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef DECKLOAD_H
+#define DECKLOAD_H
+
+#include "commands.h"
+#include "uart.h"
+#include "json.hpp"
+#include <string>
+#include <vector>
+
+/**
+ * @brief The outcome of loading one command definition file.
+ */
+struct CommandFileLoad {
+    std::string path;
+    /**
+     * @brief false if the file couldn't be opened. Its system is left out of the deck.
+     */
+    bool opened = false;
+    /**
+     * @brief Why the file couldn't be parsed, or empty. A file that opened but didn't parse gives its system no commands.
+     */
+    std::string error;
+    std::vector<Command> commands;
+    /**
+     * @brief Time taken to read and parse the file, in milliseconds.
+     */
+    double milliseconds = 0;
+};
+
+/**
+ * @brief Loaders for the systems file and streaming loaders for command definition files.
+ *
+ * A command file is a JSON array (or object) of entries with string fields `name`, `hex`, `write_value`, `order` and `color`. It is parsed with nlohmann's SAX interface, which builds each `Command` as soon as its entry closes instead of building a DOM first and copying fields out of it. Other fields, and anything nested inside an entry, are skipped.
+ */
+namespace deck_load {
+    /**
+     * @brief The serial settings to use from a parsed systems file: the `gse` uplink device with the `uplink` UART settings, or the `timepix` UART if `timepix` is set. The optional `flow_control`, `vmin`, `vtime`, `low_latency`, `latency_timer_ms` and `xmit_fifo_size` fields of `uart_interface` fill in `UARTInfo`'s tuning.
+     *
+     * @param interface filled in from the file; anything the file doesn't give keeps its current value.
+     * @param error set to a description of the problem if this returns false.
+     * @return false if the `gse` or `timepix` entry is there but incomplete, or `flow_control` is unknown.
+     */
+    bool uplink_from(const nlohmann::json& systems_data, int timepix, UARTInfo& interface, std::string& error);
+    /**
+     * @brief Find every system in a parsed systems file that lists a command file, whether or not the file exists (`load_command_files` reports it as not opened).
+     *
+     * @param path the systems file; command file paths are relative to its parent folder.
+     * @param systems each system found.
+     * @param files the full path of each system's command file, parallel to `systems`.
+     */
+    void list_command_files(const nlohmann::json& systems_data, const std::string& path, std::vector<System>& systems, std::vector<std::string>& files);
+
+    /**
+     * @brief Parse the contents of one command file.
+     *
+     * @param text the whole file.
+     * @param commands the commands, in file order.
+     * @param error set to a description of the problem if parsing failed.
+     * @return true if every entry was read.
+     */
+    bool parse_commands(std::string& text, std::vector<Command>& commands, std::string& error);
+
+    /**
+     * @brief Load several command files at once, on up to `threads` worker threads.
+     *
+     * @return one result per path, in the same order as `paths`.
+     */
+    std::vector<CommandFileLoad> load_command_files(const std::vector<std::string>& paths, size_t threads);
+};
+
+#endif
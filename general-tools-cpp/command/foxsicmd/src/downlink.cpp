@@ -0,0 +1,362 @@
+#include "downlink.h"
+#include "util.h"
+#include "trace.h"
+
+#include <future>
+#include <chrono>
+#include <sstream>
+#include <filesystem>
+#include <cstdlib>
+
+namespace {
+    int64_t steady_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // split "a,b,c" on commas
+    std::vector<std::string> split(const std::string& text) {
+        std::vector<std::string> parts;
+        std::stringstream stream(text);
+        std::string part;
+        while (std::getline(stream, part, ',')) {
+            parts.push_back(part);
+        }
+        return parts;
+    }
+
+    bool parse_number(const std::string& text, long& value) {
+        char* end = nullptr;
+        value = strtol(text.c_str(), &end, 0);
+        return !text.empty() && end && *end == '\0';
+    }
+}
+
+ByteRing::ByteRing(size_t capacity): head(0), tail(0) {
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    data = std::make_unique<uint8_t[]>(size);
+    mask = size - 1;
+}
+
+void ByteRing::copy(size_t k, size_t count, uint8_t* out) const {
+    size_t start = (head + k) & mask;
+    size_t first = std::min(count, capacity() - start);
+    std::copy(data.get() + start, data.get() + start + first, out);
+    std::copy(data.get(), data.get() + (count - first), out + first);
+}
+
+boost::asio::mutable_buffer ByteRing::write_space() {
+    size_t start = tail & mask;
+    return boost::asio::buffer(data.get() + start, std::min(free(), capacity() - start));
+}
+
+size_t RawFramer::next(const ByteRing& ring, size_t& skip) {
+    skip = 0;
+    return ring.size();
+}
+
+size_t FixedFramer::next(const ByteRing& ring, size_t& skip) {
+    skip = 0;
+    return ring.size() >= length ? length : 0;
+}
+
+std::string FixedFramer::describe() const {
+    return "fixed " + std::to_string(length) + " bytes";
+}
+
+size_t DelimiterFramer::next(const ByteRing& ring, size_t& skip) {
+    skip = 0;
+    size_t available = ring.size();
+    for (size_t end = std::max(scanned, delimiter.size()); end <= available; ++end) {
+        bool match = true;
+        for (size_t k = 0; k < delimiter.size(); ++k) {
+            if (ring.peek(end - delimiter.size() + k) != delimiter[k]) {
+                match = false;
+                break;
+            }
+        }
+        if (match) {
+            scanned = 0;
+            return end;
+        }
+    }
+    scanned = available + 1;
+    return 0;
+}
+
+std::string DelimiterFramer::describe() const {
+    return "ending in " + util::bytes_to_string(delimiter);
+}
+
+LengthFramer::LengthFramer(size_t offset, size_t width, bool big_endian, size_t header, long adjust, size_t max_frame):
+    offset(offset),
+    width(width),
+    big_endian(big_endian),
+    header(header),
+    adjust(adjust),
+    max_frame(max_frame) {}
+
+size_t LengthFramer::next(const ByteRing& ring, size_t& skip) {
+    skip = 0;
+    if (ring.size() < header) {
+        return 0;
+    }
+    uint64_t length = 0;
+    for (size_t k = 0; k < width; ++k) {
+        size_t shift = 8 * (big_endian ? width - 1 - k : k);
+        length |= uint64_t(ring.peek(offset + k)) << shift;
+    }
+    long total = long(header) + long(length) + adjust;
+    if (total < long(header) || total > long(max_frame)) {
+        // not a believable frame: drop a byte and look again
+        skip = 1;
+        return 0;
+    }
+    return ring.size() >= size_t(total) ? size_t(total) : 0;
+}
+
+std::string LengthFramer::describe() const {
+    std::stringstream text;
+    text << width << "-byte " << (big_endian ? "big" : "little") << "-endian length at " << offset << ", " << header << "-byte header";
+    if (adjust != 0) {
+        text << ", " << (adjust > 0 ? "+" : "") << adjust;
+    }
+    return text.str();
+}
+
+std::unique_ptr<Framer> make_framer(const std::string& spec, size_t max_frame, std::string& error) {
+    std::string kind = spec.substr(0, spec.find(':'));
+    std::string args = spec.find(':') == std::string::npos ? "" : spec.substr(spec.find(':') + 1);
+
+    if (kind == "raw" && args == "") {
+        return std::make_unique<RawFramer>();
+    }
+    if (kind == "fixed") {
+        long length;
+        if (!parse_number(args, length) || length <= 0 || size_t(length) > max_frame) {
+            error = "fixed frame length must be 1 to " + std::to_string(max_frame);
+            return nullptr;
+        }
+        return std::make_unique<FixedFramer>(length);
+    }
+    if (kind == "delim") {
+        std::string digits = args.substr(0, 2) == "0x" || args.substr(0, 2) == "0X" ? args.substr(2) : args;
+        if (digits.empty() || digits.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos) {
+            error = "delimiter must be hex bytes, like 0a or 0d0a";
+            return nullptr;
+        }
+        return std::make_unique<DelimiterFramer>(util::string_to_bytes(digits));
+    }
+    if (kind == "length") {
+        auto parts = split(args);
+        long offset, width, header, adjust = 0;
+        bool big_endian = true;
+        if (parts.size() < 2 || parts.size() > 5 || !parse_number(parts[0], offset) || !parse_number(parts[1], width) || offset < 0 || (width != 1 && width != 2 && width != 4)) {
+            error = "length framer is length:OFFSET,WIDTH[,be|le[,HEADER[,ADJUST]]], WIDTH 1, 2 or 4";
+            return nullptr;
+        }
+        if (parts.size() > 2) {
+            if (parts[2] != "be" && parts[2] != "le") {
+                error = "length byte order must be be or le";
+                return nullptr;
+            }
+            big_endian = parts[2] == "be";
+        }
+        header = offset + width;
+        if (parts.size() > 3 && (!parse_number(parts[3], header) || header < offset + width)) {
+            error = "length header must be at least OFFSET + WIDTH bytes";
+            return nullptr;
+        }
+        if (parts.size() > 4 && !parse_number(parts[4], adjust)) {
+            error = "length adjustment must be a number";
+            return nullptr;
+        }
+        return std::make_unique<LengthFramer>(offset, width, big_endian, header, adjust, max_frame);
+    }
+    error = "unknown framer \"" + spec + "\" (use raw, fixed:N, delim:HEX or length:OFFSET,WIDTH)";
+    return nullptr;
+}
+
+BinaryLog::BinaryLog(): written(0), dropped(0), running(false) {}
+
+BinaryLog::~BinaryLog() {
+    stop();
+}
+
+bool BinaryLog::start(const std::string& path, std::string& error) {
+    // the default path is under log/, which may not exist yet:
+    std::error_code err;
+    std::filesystem::path target(path);
+    if (target.has_parent_path()) {
+        std::filesystem::create_directories(target.parent_path(), err);
+    }
+    file.open(path, std::ios::binary | std::ios::out | std::ios::app);
+    if (!file.is_open()) {
+        error = "couldn't open " + path;
+        return false;
+    }
+    this->path = path;
+    pending.reserve(1 << 16);
+    running = true;
+    thread = std::thread(&BinaryLog::run, this);
+    return true;
+}
+
+void BinaryLog::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) {
+            return;
+        }
+        running = false;
+    }
+    wake.notify_one();
+    thread.join();
+    file.close();
+}
+
+void BinaryLog::append(const uint8_t* bytes, size_t count) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) {
+            return;
+        }
+        if (pending.size() + count > max_pending) {
+            dropped.fetch_add(count);
+            return;
+        }
+        pending.insert(pending.end(), bytes, bytes + count);
+    }
+    wake.notify_one();
+}
+
+void BinaryLog::run() {
+    trace::set_thread_name("downlink log");
+    std::vector<uint8_t> writing;
+    writing.reserve(1 << 16);
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return !pending.empty() || !running; });
+        if (pending.empty() && !running) {
+            break;
+        }
+        // swap buffers, so appending can carry on while this one is written
+        std::swap(writing, pending);
+        lock.unlock();
+        {
+            trace::Span span("write downlink log", "downlink");
+            file.write(reinterpret_cast<const char*>(writing.data()), writing.size());
+            file.flush();
+        }
+        written.fetch_add(writing.size());
+        writing.clear();
+        lock.lock();
+    }
+}
+
+Downlink::Downlink(boost::asio::serial_port& port, std::unique_ptr<Framer> framer, size_t capacity):
+    bytes_read(0),
+    frames(0),
+    skipped(0),
+    overflowed(0),
+    errors(0),
+    port(port),
+    framer(std::move(framer)),
+    ring(capacity),
+    running(false) {}
+
+bool Downlink::start(const std::string& log_path, std::string& error) {
+    if (log_path != "" && !raw_log.start(log_path, error)) {
+        return false;
+    }
+    running = true;
+    boost::asio::post(port.get_executor(), [this] { read(); });
+    return true;
+}
+
+void Downlink::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+    // cancel the outstanding read on the I/O thread, where the port is used
+    auto cancelled = std::make_shared<std::promise<void>>();
+    auto done = cancelled->get_future();
+    boost::asio::post(port.get_executor(), [this, cancelled] {
+        boost::system::error_code ignored;
+        port.cancel(ignored);
+        cancelled->set_value();
+    });
+    done.wait_for(std::chrono::seconds(1));
+    raw_log.stop();
+}
+
+void Downlink::read() {
+    if (!running) {
+        return;
+    }
+    port.async_read_some(ring.write_space(), [this](const boost::system::error_code& err, size_t count) {
+        int64_t time = steady_ns();
+        if (count > 0) {
+            // the bytes just read are contiguous at the end of the ring
+            trace::Span span("downlink read", "downlink");
+            boost::asio::mutable_buffer space = ring.write_space();
+            raw_log.append(static_cast<const uint8_t*>(space.data()), count);
+            ring.commit(count);
+            bytes_read.fetch_add(count);
+            extract(time);
+        }
+        if (err) {
+            if (err != boost::asio::error::operation_aborted) {
+                errors.fetch_add(1);
+                std::lock_guard<std::mutex> lock(frame_mutex);
+                error_text = err.message();
+            }
+            return;
+        }
+        read();
+    });
+}
+
+void Downlink::extract(int64_t time) {
+    while (ring.size() > 0) {
+        size_t skip = 0;
+        size_t length = framer->next(ring, skip);
+        if (skip > 0) {
+            ring.consume(skip);
+            skipped.fetch_add(skip);
+            continue;
+        }
+        if (length == 0) {
+            break;
+        }
+        DownlinkFrame frame;
+        frame.index = frames.fetch_add(1);
+        frame.time = time;
+        frame.bytes.resize(length);
+        ring.copy(0, length, frame.bytes.data());
+        ring.consume(length);
+        std::lock_guard<std::mutex> lock(frame_mutex);
+        frame_history.push_back(std::move(frame));
+        if (frame_history.size() > history) {
+            frame_history.pop_front();
+        }
+    }
+    if (ring.free() == 0) {
+        // no frame fits in the whole ring: give up on these bytes and resync
+        overflowed.fetch_add(ring.size());
+        ring.clear();
+        framer->reset();
+    }
+}
+
+std::deque<DownlinkFrame> Downlink::recent() {
+    std::lock_guard<std::mutex> lock(frame_mutex);
+    return frame_history;
+}
+
+std::string Downlink::last_error() {
+    std::lock_guard<std::mutex> lock(frame_mutex);
+    return error_text;
+}
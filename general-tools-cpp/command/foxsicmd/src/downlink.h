@@ -0,0 +1,273 @@
+#ifndef DOWNLINK_H
+#define DOWNLINK_H
+
+#include <boost/asio.hpp>
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <fstream>
+#include <cstdint>
+
+/**
+ * @brief A fixed-size byte ring, allocated once. Serial reads land directly in its free space and frames are found in place, so received bytes aren't copied on the way in.
+ *
+ * Only used from one thread (the I/O thread).
+ */
+class ByteRing {
+    public:
+        /**
+         * @brief Construct a new ByteRing object.
+         *
+         * @param capacity rounded up to a power of two.
+         */
+        ByteRing(size_t capacity);
+
+        size_t capacity() const { return mask + 1; }
+        /**
+         * @brief Number of unread bytes.
+         */
+        size_t size() const { return tail - head; }
+        size_t free() const { return capacity() - size(); }
+        /**
+         * @brief The `k`th unread byte.
+         */
+        uint8_t peek(size_t k) const { return data[(head + k) & mask]; }
+        /**
+         * @brief Copy `count` unread bytes, starting from the `k`th, to `out`.
+         */
+        void copy(size_t k, size_t count, uint8_t* out) const;
+
+        /**
+         * @brief The largest contiguous run of free space, to read into. Call `::commit` with however much was written.
+         */
+        boost::asio::mutable_buffer write_space();
+        void commit(size_t count) { tail += count; }
+        /**
+         * @brief Discard the first `count` unread bytes.
+         */
+        void consume(size_t count) { head += count; }
+        void clear() { head = tail; }
+
+    private:
+        std::unique_ptr<uint8_t[]> data;
+        size_t mask;
+        // total bytes ever read and written; their difference is the fill
+        size_t head;
+        size_t tail;
+};
+
+/**
+ * @brief Splits the received byte stream into frames.
+ */
+class Framer {
+    public:
+        virtual ~Framer() = default;
+        /**
+         * @brief Look for a frame at the start of the unread bytes in `ring`.
+         *
+         * @param skip set to a number of leading bytes that can't start a frame and should be dropped (to resync).
+         * @return the length of a complete frame at the start of `ring`, or 0 if more bytes are needed.
+         */
+        virtual size_t next(const ByteRing& ring, size_t& skip) = 0;
+        /**
+         * @brief Forget any partial scan; called when the ring is cleared.
+         */
+        virtual void reset() {}
+        virtual std::string describe() const = 0;
+};
+
+/**
+ * @brief Every read is one frame: bytes are shown as they arrive.
+ */
+class RawFramer: public Framer {
+    public:
+        size_t next(const ByteRing& ring, size_t& skip) override;
+        std::string describe() const override { return "raw"; }
+};
+
+/**
+ * @brief Frames of a fixed length.
+ */
+class FixedFramer: public Framer {
+    public:
+        FixedFramer(size_t length): length(length) {}
+        size_t next(const ByteRing& ring, size_t& skip) override;
+        std::string describe() const override;
+
+    private:
+        size_t length;
+};
+
+/**
+ * @brief Frames ending in a delimiter (included in the frame), like `\n` or `\r\n`.
+ */
+class DelimiterFramer: public Framer {
+    public:
+        DelimiterFramer(std::vector<uint8_t> delimiter): delimiter(delimiter), scanned(0) {}
+        size_t next(const ByteRing& ring, size_t& skip) override;
+        void reset() override { scanned = 0; }
+        std::string describe() const override;
+
+    private:
+        std::vector<uint8_t> delimiter;
+        // bytes already searched without finding a delimiter, so each byte is only looked at once
+        size_t scanned;
+};
+
+/**
+ * @brief Frames with a length field in a fixed-size header: a frame is `header + length + adjust` bytes long.
+ */
+class LengthFramer: public Framer {
+    public:
+        /**
+         * @brief Construct a new LengthFramer object.
+         *
+         * @param offset position of the length field in the header.
+         * @param width size of the length field: 1, 2 or 4 bytes.
+         * @param big_endian byte order of the length field.
+         * @param header bytes before the counted payload, at least `offset + width`.
+         * @param adjust added to the length, e.g. for a trailing checksum the length doesn't count.
+         * @param max_frame longest believable frame; a longer length means the stream is out of sync, and one byte is dropped.
+         */
+        LengthFramer(size_t offset, size_t width, bool big_endian, size_t header, long adjust, size_t max_frame);
+        size_t next(const ByteRing& ring, size_t& skip) override;
+        std::string describe() const override;
+
+    private:
+        size_t offset;
+        size_t width;
+        bool big_endian;
+        size_t header;
+        long adjust;
+        size_t max_frame;
+};
+
+/**
+ * @brief Make a framer from a command-line description:
+ * - `raw`: each read is a frame.
+ * - `fixed:N`: frames of N bytes.
+ * - `delim:HEX`: frames ending in the hex bytes HEX, e.g. `delim:0a` or `delim:0d0a`.
+ * - `length:OFFSET,WIDTH[,be|le[,HEADER[,ADJUST]]]`: a WIDTH-byte length at OFFSET (big-endian by default); HEADER defaults to OFFSET + WIDTH, ADJUST to 0.
+ *
+ * @param max_frame longest frame allowed.
+ * @param error set to a description of the problem if `spec` isn't understood.
+ * @return the framer, or nullptr.
+ */
+std::unique_ptr<Framer> make_framer(const std::string& spec, size_t max_frame, std::string& error);
+
+/**
+ * @brief Appends raw bytes to a file from a background thread, so the I/O thread never waits on the disk.
+ *
+ * Appending copies into a pending buffer; the writer thread swaps it out and writes it. If the disk falls more than `::max_pending` bytes behind, newer bytes are dropped (and counted) rather than buffered without limit.
+ */
+class BinaryLog {
+    public:
+        static constexpr size_t max_pending = 8 << 20;
+
+        BinaryLog();
+        ~BinaryLog();
+
+        /**
+         * @brief Open `path` for appending, creating its folder if needed, and start the writer thread.
+         *
+         * @param error set to a description of the problem if the file couldn't be opened.
+         */
+        bool start(const std::string& path, std::string& error);
+        /**
+         * @brief Write out everything pending, close the file, and stop the writer thread.
+         */
+        void stop();
+        void append(const uint8_t* bytes, size_t count);
+
+        std::string path;
+        std::atomic<uint64_t> written;
+        std::atomic<uint64_t> dropped;
+
+    private:
+        void run();
+
+        std::ofstream file;
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::vector<uint8_t> pending;
+        bool running;
+};
+
+/**
+ * @brief A frame received on the downlink.
+ */
+struct DownlinkFrame {
+    uint64_t index = 0;
+    // `steady_clock` nanoseconds when the read completing the frame finished
+    int64_t time = 0;
+    std::vector<uint8_t> bytes;
+};
+
+/**
+ * @brief Reads the serial port continuously on the I/O thread, logs every raw byte, and splits the stream into frames for display.
+ *
+ * Reads go straight into a preallocated `ByteRing`, and the `Framer` finds frames in place. The raw bytes of each read go to a `BinaryLog`. Only complete frames are copied out, into a short history for the UI. If the ring fills up without the framer finding a frame (a frame longer than the ring, or a stream that never matches), the ring is emptied and the bytes counted as overflowed, so reading never stops.
+ *
+ * Something must be running the port's `io_context` (see `main.cpp`).
+ */
+class Downlink {
+    public:
+        /**
+         * @brief Number of frames kept for `::recent`.
+         */
+        static constexpr size_t history = 256;
+
+        Downlink(boost::asio::serial_port& port, std::unique_ptr<Framer> framer, size_t capacity);
+
+        /**
+         * @brief Start reading. Raw bytes are logged to `log_path`, unless it's empty.
+         *
+         * @param error set to a description of the problem if the log couldn't be opened.
+         */
+        bool start(const std::string& log_path, std::string& error);
+        /**
+         * @brief Stop reading and close the log. Call from any thread but the I/O thread, before the `io_context` stops.
+         */
+        void stop();
+
+        /**
+         * @brief Up to `::history` frames, oldest first.
+         */
+        std::deque<DownlinkFrame> recent();
+        const Framer& framing() const { return *framer; }
+        const BinaryLog& log() const { return raw_log; }
+
+        std::atomic<uint64_t> bytes_read;
+        std::atomic<uint64_t> frames;
+        // bytes dropped by the framer to resync
+        std::atomic<uint64_t> skipped;
+        // bytes dropped because the ring filled up without a frame
+        std::atomic<uint64_t> overflowed;
+        std::atomic<uint64_t> errors;
+        /**
+         * @brief The last read error, if reading stopped because of one.
+         */
+        std::string last_error();
+
+    private:
+        void read();
+        void extract(int64_t time);
+
+        boost::asio::serial_port& port;
+        std::unique_ptr<Framer> framer;
+        ByteRing ring;
+        BinaryLog raw_log;
+        std::atomic<bool> running;
+
+        std::mutex frame_mutex;
+        std::deque<DownlinkFrame> frame_history;
+        std::string error_text;
+};
+
+#endif
@@ -2,13 +2,21 @@
 #include "json.hpp"
 #include "uart.h"
 #include "util.h"
-
-#include <boost/filesystem.hpp>
+#include "trace.h"
+#include "deckcache.h"
+#include "deckload.h"
+#include "builtin.h"
+#include "script.h"
 
 #include <exception>
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <sstream>
+#include <iomanip>
+#include <thread>
+#include <chrono>
+#include <algorithm>
 
 
 Line::Line(int argc, char** argv, boost::asio::io_context& context): options("options"), port(context) {
@@ -17,6 +25,20 @@ Line::Line(int argc, char** argv, boost::asio::io_context& context): options("op
         ("timepix,t",                                                           "use timepix UART config")
         ("config,c",    boost::program_options::value<std::string>(),       "config file with options")
         ("port,p",      boost::program_options::value<std::string>(),       "serial port")
+        ("trace",       boost::program_options::value<std::string>(),       "write a Chrome trace-event file")
+        ("cache",       boost::program_options::value<std::string>(),       "deck cache file")
+        ("no-cache",                                                            "always load the deck from JSON")
+        ("builtin-deck",                                                        "use the deck compiled into foxsicmd")
+        ("framer",      boost::program_options::value<std::string>()->default_value("raw"), "how to split downlink bytes into frames")
+        ("downlink-log", boost::program_options::value<std::string>(),      "raw downlink log file")
+        ("no-downlink",                                                         "don't read from the serial port")
+        ("script",      boost::program_options::value<std::string>(),       "run a command script without the UI")
+        ("script-report", boost::program_options::value<std::string>(),     "CSV file for the script's send times")
+        ("min-gap",     boost::program_options::value<std::string>()->default_value("0"), "quiet time between uplink commands")
+        ("system-rate", boost::program_options::value<double>()->default_value(0), "commands per second to each system")
+        ("burst",       boost::program_options::value<uint32_t>()->default_value(4), "commands a system may get back to back")
+        ("no-pacing",                                                           "write uplink commands as fast as possible")
+        ("latency-report",                                                      "measure write-to-wire latency of each command")
     ;
     boost::program_options::store(boost::program_options::command_line_parser(argc, argv).options(options).run(), vm);
     boost::program_options::notify(vm);
@@ -34,6 +56,40 @@ Line::Line(int argc, char** argv, boost::asio::io_context& context): options("op
                                             config file.
         --timepix,t                         Use the serial port definition for the timepix
                                             system in the config file instead of gse + uplink.
+        --trace                             Record command sends, config loading, and renders
+                                            to a Chrome trace-event JSON file (view it in
+                                            https://ui.perfetto.dev), written on exit.
+        --cache                             Use this file as the compiled deck cache instead of
+                                            the default one under ~/.cache/foxsicmd/.
+        --no-cache                          Don't read or write the deck cache; always load the
+                                            deck and UART settings from JSON.
+        --builtin-deck                      Use the command deck and UART settings compiled into
+                                            foxsicmd from foxsi4-commands at build time, instead
+                                            of a config file. Reads no files.
+        --framer                            How to split bytes read from the serial port into
+                                            frames for display: raw (default; as they arrive),
+                                            fixed:N, delim:HEX (e.g. delim:0d0a), or
+                                            length:OFFSET,WIDTH[,be|le[,HEADER[,ADJUST]]].
+        --downlink-log                      Log raw bytes read from the serial port to this
+                                            file instead of log/downlink_<time>.bin.
+        --no-downlink                       Don't read from the serial port at all.
+        --script                            Run a command script without showing the UI, and
+                                            print when each command was actually sent. Lines
+                                            are `send SYSTEM COMMAND [repeat N] [every 10ms]`,
+                                            `wait 5ms`, or `at 1.5s` (from the script start).
+        --script-report                     Also write the script's send times to this CSV file.
+        --min-gap                           Leave at least this long (e.g. 2ms) between the end
+                                            of one uplink command on the wire and the start of
+                                            the next. Default 0: commands are only held until
+                                            the previous one has had time to go out at the
+                                            configured baud rate.
+        --system-rate                       Limit each system to this many commands per second,
+                                            after a burst of --burst (default 4) back to back.
+                                            Default 0: no limit.
+        --no-pacing                         Write uplink commands as fast as the port takes them.
+        --latency-report                    Measure how long each command takes from the start
+                                            of its write until the driver has sent every byte,
+                                            shown in the status line and script report.
     )";
 
     // handle all the options:
@@ -42,25 +98,83 @@ Line::Line(int argc, char** argv, boost::asio::io_context& context): options("op
         exit(0);
     }
 
-    // set up a serial port and commands using config file:
-    if(vm.count("config")) {
-        std::cout << "loading config from " << vm["config"].as<std::string>() << "\n";
-        try {
-            std::string path = vm["config"].as<std::string>();
-            this->pull_uplink(path, vm.count("timepix"));
-        } catch(std::exception& e) {
-            std::cerr << "failed to define a UART interface: " << e.what() << "\n";
+    this->downlink = !vm.count("no-downlink");
+    this->framer_spec = vm["framer"].as<std::string>();
+    this->downlink_log = vm.count("downlink-log") ? vm["downlink-log"].as<std::string>() : "log/downlink_" + util::get_now_string() + ".bin";
+
+    this->script_path = vm.count("script") ? vm["script"].as<std::string>() : "";
+    this->script_report = vm.count("script-report") ? vm["script-report"].as<std::string>() : "";
+
+    this->pacing.enabled = !vm.count("no-pacing");
+    this->latency_report = vm.count("latency-report");
+    if (!script::parse_duration(vm["min-gap"].as<std::string>(), this->pacing.min_gap)) {
+        std::cerr << "--min-gap needs a duration, like 2ms\n";
+        exit(1);
+    }
+    this->pacing.system_rate = vm["system-rate"].as<double>();
+    this->pacing.burst = vm["burst"].as<uint32_t>();
+    if (this->pacing.system_rate < 0 || this->pacing.burst == 0) {
+        std::cerr << "--system-rate can't be negative, and --burst must be at least 1\n";
+        exit(1);
+    }
+
+    // start tracing first, so config loading is recorded too:
+    if(vm.count("trace")) {
+        if (!trace::start(vm["trace"].as<std::string>())) {
             exit(1);
         }
+        trace::set_thread_name("ui");
+    }
 
-        try {
-            this->pull_deck(vm["config"].as<std::string>());
-        } catch(std::exception& e) {
-            std::cerr << "failed to create command deck: " << e.what() << "\n";
+    // set up a serial port and commands using the compiled-in deck, or the config file:
+    if(vm.count("builtin-deck")) {
+        trace::Span span("load builtin deck", "config");
+        std::string error;
+        if (!builtin_deck::load(vm.count("timepix"), this->interface, this->deck, error)) {
+            std::cerr << "can't use --builtin-deck: " << error << "\n";
             exit(1);
         }
+        std::cout << "using built-in deck from " << builtin_deck::source() << "\n";
+    } else if(vm.count("config")) {
+        std::string path = vm["config"].as<std::string>();
+        std::cout << "loading config from " << path << "\n";
+
+        // a compiled copy of the deck, if nothing changed since it was written, saves parsing every JSON file:
+        bool use_cache = !vm.count("no-cache");
+        std::string cache_path = vm.count("cache") ? vm["cache"].as<std::string>() : deck_cache::default_path(path);
+        bool cached = false;
+        if (use_cache) {
+            trace::Span span("load deck cache", "config", cache_path);
+            std::string reason;
+            cached = deck_cache::load(cache_path, path, vm.count("timepix"), this->interface, this->deck, reason);
+            if (cached) {
+                std::cout << "loaded deck from cache " << cache_path << "\n";
+            } else {
+                std::cout << "not using deck cache: " << reason << "\n";
+            }
+        }
+
+        if (!cached) {
+            bool complete = false;
+            try {
+                complete = this->pull_config(path, vm.count("timepix"));
+            } catch(std::exception& e) {
+                std::cerr << "failed to create command deck: " << e.what() << "\n";
+                exit(1);
+            }
+
+            if (use_cache && !complete) {
+                std::cout << "not saving deck cache: some command files are missing or broken\n";
+            } else if (use_cache) {
+                trace::Span span("save deck cache", "config", cache_path);
+                std::string error;
+                if (!deck_cache::save(cache_path, this->deck_sources, vm.count("timepix"), this->interface, this->deck, error)) {
+                    std::cerr << "couldn't save deck cache: " << error << "\n";
+                }
+            }
+        }
     } else {
-        std::cerr << "--config option is required!\n";
+        std::cerr << "--config (or --builtin-deck) option is required!\n";
         exit(1);
     }
 
@@ -77,8 +191,9 @@ Line::Line(int argc, char** argv, boost::asio::io_context& context): options("op
     this->start_port();
 }
 
-void Line::pull_uplink(std::string path, int timepix) {
-    this->interface = UARTInfo();
+bool Line::pull_config(std::string path, int timepix) {
+    trace::Span span("load config", "config", path);
+    auto start = std::chrono::steady_clock::now();
 
     std::ifstream sys_file;
     sys_file.open(path);
@@ -87,120 +202,63 @@ void Line::pull_uplink(std::string path, int timepix) {
         exit(1);
     }
 
-    // parse the systems file:
+    // parse the systems file once, for both the UART settings and the deck:
     nlohmann::json systems_data = nlohmann::json::parse(sys_file);
     sys_file.close();
-    
-    for(auto& this_entry: systems_data.items()) {
-        std::string sys_name = this_entry.value()["name"];
-        std::string sys_hex_str = this_entry.value()["hex"];
-        if (timepix) {
-            if (sys_name == "timepix") {
-                try {
-                    this->interface.port_name = this_entry.value()["uart_interface"]["tty_path"];
-                    this->interface.baud_rate = this_entry.value()["uart_interface"]["baud_rate"];
-                    this->interface.data_bits = this_entry.value()["uart_interface"]["data_bits"];
-                    this->interface.stop_bits = this_entry.value()["uart_interface"]["stop_bits"];
-                    this->interface.parity = this_entry.value()["uart_interface"]["parity_bits"];
-                    break;
-                } catch(std::exception& e) {
-                    std::cerr << "failed to find uplink UART configuration in config file.\n";
-                    exit(1);
-                }
-            }
-        } else {
-            if (sys_name == "gse") {
-                try {
-                    this->interface.port_name = this_entry.value()["logger_interface"]["uplink_device"];
-                } catch(std::exception& e) {
-                    std::cerr << "couldn't find uplink device in config file.\n";
-                    exit(1);
-                }
-            }
-            if (sys_name == "uplink") {
-                try {
-                    this->interface.baud_rate = this_entry.value()["uart_interface"]["baud_rate"];
-                    this->interface.data_bits = this_entry.value()["uart_interface"]["data_bits"];
-                    this->interface.stop_bits = this_entry.value()["uart_interface"]["stop_bits"];
-                    this->interface.parity = this_entry.value()["uart_interface"]["parity_bits"];
-                } catch(std::exception& e) {
-                    std::cerr << "failed to find uplink UART configuration in config file.\n";
-                }
-            }
+
+    std::string uart_error;
+    this->interface = UARTInfo();
+    try {
+        if (!deck_load::uplink_from(systems_data, timepix, this->interface, uart_error)) {
+            std::cerr << "failed to define a UART interface: " << uart_error << ".\n";
+            exit(1);
         }
+    } catch(std::exception& e) {
+        std::cerr << "failed to define a UART interface: " << e.what() << "\n";
+        exit(1);
     }
-}
 
-void Line::pull_deck(std::string path) {
-    this->deck = Deck();
+    // find every command file first, so they can all be parsed at once:
+    std::vector<System> listed;
+    std::vector<std::string> cmd_fnames;
+    deck_load::list_command_files(systems_data, path, listed, cmd_fnames);
 
-    std::ifstream sys_file;
+    size_t threads = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, 4);
+    auto loads = deck_load::load_command_files(cmd_fnames, threads);
 
-    // try to open the systems file
-    sys_file.open(path);
-    if(!sys_file.is_open()) {
-        std::cerr << "couldn't open settings file.\n";
-        exit(1);
+    std::vector<System> systems;
+    std::vector<std::vector<Command>> system_commands;
+    std::vector<size_t> counts(loads.size(), 0);
+    this->deck_sources = {path};
+    bool complete = true;
+    for (size_t k = 0; k < loads.size(); ++k) {
+        counts[k] = loads[k].commands.size();
+        if (!loads[k].opened) {
+            std::cerr << "couldn't open command file for " << listed[k].name << ": " << loads[k].path << "\n";
+            complete = false;
+            continue;
+        }
+        if (loads[k].error != "") {
+            std::cerr << "couldn't parse command file for " << listed[k].name << ": " << loads[k].error << "\n";
+            complete = false;
+        }
+        this->deck_sources.push_back(loads[k].path);
+        systems.push_back(listed[k]);
+        system_commands.push_back(std::move(loads[k].commands));
     }
 
-    // parse the systems file:
-    nlohmann::json systems_data = nlohmann::json::parse(sys_file);
-    sys_file.close();
-
-    boost::filesystem::path source(path);
-
-    for(auto& this_entry: systems_data.items()) {
-        std::string sys_name = this_entry.value()["name"];
-        std::string sys_hex_str = this_entry.value()["hex"];
-        uint8_t sys_hex = strtol(sys_hex_str.c_str(), NULL, 16);
-
-        try{
-            std::string this_command_path = this_entry.value().at("commands");
-            std::string this_command_type = this_entry.value().at("command_type");
-            
-            boost::filesystem::path cmd_path = boost::filesystem::canonical(source.parent_path() / ".." / this_command_path);
-            std::string cmd_fname = cmd_path.string();
-            // std::cout << "reading commands from " << cmd_fname << "\n";
-            
-            std::ifstream cmd_file;
-            cmd_file.open(cmd_fname);
-            if(!cmd_file.is_open()) {
-                std::cerr << "couldn't open command file for " << sys_name << "\n";
-                continue;
-            }
-            
-            // save data for this system to the command deck:
-            this->deck.systems.push_back(System(sys_hex, sys_name, this_command_type));
-            
-            nlohmann::json commands_data = nlohmann::json::parse(cmd_file);
-            cmd_file.close();
-
-            std::vector<Command> commands;
-
-            // load each command for this system:
-            for(auto& cmd_entry: commands_data.items()) {
-                std::string cmd_name = cmd_entry.value()["name"];
-                std::string cmd_hex_str = cmd_entry.value()["hex"];
-                std::string write_value_str = cmd_entry.value()["write_value"];
-                std::string order_str = cmd_entry.value()["order"];
-                std::string color_str = cmd_entry.value()["color"];
-
-                uint8_t cmd_hex = strtol(cmd_hex_str.c_str(), NULL, 16);
-                auto write_value = util::string_to_bytes(write_value_str);
-                uint32_t color = strtoul(color_str.c_str(), NULL, 16);
-                uint32_t order = strtoul(order_str.c_str(), NULL, 10);
-                
-                Command this_cmd(cmd_hex, cmd_name, color, order, write_value);
-
-                commands.push_back((this_cmd));
-            }
-
-            this->deck.add(sys_hex, commands);
+    // index everything once, now that it's all loaded:
+    this->deck = Deck(systems, system_commands);
 
-        } catch(std::exception &e) {}
+    double total = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::stringstream report;
+    report << std::fixed << std::setprecision(2);
+    report << "loaded " << this->deck.size() << " commands for " << systems.size() << " systems in " << total << " ms (" << threads << " threads):\n";
+    for (size_t k = 0; k < loads.size(); ++k) {
+        report << "\t" << std::setw(8) << loads[k].milliseconds << " ms\t" << std::setw(4) << counts[k] << " commands\t" << loads[k].path << "\n";
     }
-
-    // std::cout << "loaded systems: " << deck.to_string();
+    std::cout << report.str();
+    return complete;
 }
 
 void Line::start_port() {
@@ -241,4 +299,32 @@ void Line::start_port() {
             std::cerr << "unhandled UARTInfo::stop_bits value: " << std::to_string(this->interface.stop_bits) << ".\n";
             exit(1);
     }
+    switch(this->interface.flow_control) {
+        case 0:
+            this->port.set_option(boost::asio::serial_port_base::flow_control(boost::asio::serial_port_base::flow_control::none));
+            break;
+        case 1:
+            this->port.set_option(boost::asio::serial_port_base::flow_control(boost::asio::serial_port_base::flow_control::software));
+            break;
+        case 2:
+            this->port.set_option(boost::asio::serial_port_base::flow_control(boost::asio::serial_port_base::flow_control::hardware));
+            break;
+        default:
+            std::cerr << "unhandled UARTInfo::flow_control value: " << std::to_string(this->interface.flow_control) << ".\n";
+            exit(1);
+    }
+
+    // VMIN/VTIME, low latency and buffer sizes, where the port supports them:
+    std::vector<std::string> notes;
+    if (!this->interface.apply_tuning(this->port.native_handle(), notes)) {
+        std::cerr << "failed to tune serial port at " << this->interface.port_name << ": " << notes.back() << "\n";
+        exit(1);
+    }
+    for (auto& note: notes) {
+        std::cout << "serial port: " << note << "\n";
+    }
+    int timer = this->interface.read_latency_timer();
+    if (timer >= 0) {
+        std::cout << "serial port: adapter latency timer is " << timer << " ms\n";
+    }
 }
\ No newline at end of file
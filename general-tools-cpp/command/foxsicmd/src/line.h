@@ -3,9 +3,11 @@
 
 #include "uart.h"
 #include "commands.h"
+#include "pacing.h"
 #include <boost/program_options.hpp>
 #include <boost/asio.hpp>
 #include <string>
+#include <vector>
 
 
 class Line {
@@ -15,10 +17,38 @@ class Line {
 
         UARTInfo interface;
         Deck deck;
+        /**
+         * @brief Files the deck was loaded from by `::pull_config`: the systems file, then each command file.
+         */
+        std::vector<std::string> deck_sources;
+
+        /**
+         * @brief Downlink settings from the command line: whether to read the port, how to split what's read into frames (see `make_framer`), and where to log the raw bytes.
+         */
+        bool downlink;
+        std::string framer_spec;
+        std::string downlink_log;
+        /**
+         * @brief Script to run headless instead of showing the UI (see `script::parse`), and where to write its report. Empty if not set.
+         */
+        std::string script_path;
+        std::string script_report;
+        /**
+         * @brief Uplink rate limits from the command line (see `Pacer`).
+         */
+        PacingSettings pacing;
+        /**
+         * @brief Measure each command's write-to-wire latency (see `Uplink::measure_wire`).
+         */
+        bool latency_report;
 
         void start_port();
-        void pull_uplink(std::string path, int timepix);
-        void pull_deck(std::string path);
+        /**
+         * @brief Read the systems file once for the UART settings and the deck, parsing every command file it lists in parallel. Prints how long each file took.
+         *
+         * @return false if any command file the systems file lists couldn't be opened or parsed. A missing file's system is left out of the deck and a broken file's system has no commands; either way the deck shouldn't be cached, since it isn't the deck the files describe.
+         */
+        bool pull_config(std::string path, int timepix);
 
     private:
         boost::program_options::options_description options;
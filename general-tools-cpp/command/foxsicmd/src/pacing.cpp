@@ -0,0 +1,98 @@
+#include "pacing.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <iomanip>
+
+std::string PacingStats::to_string() const {
+    std::stringstream text;
+    text << std::fixed << std::setprecision(2);
+    text << commands << " commands, " << delayed << " paced";
+    if (delayed > 0) {
+        text << " (mean " << total_delay / 1e6 / delayed << " ms, max " << max_delay / 1e6 << " ms)";
+    }
+    if (elapsed > 0) {
+        text << std::setprecision(0) << ", line " << 100.0 * busy / elapsed << "% busy";
+    }
+    bool first = true;
+    for (size_t system = 0; system < throttled.size(); ++system) {
+        if (throttled[system] > 0) {
+            text << (first ? ", throttled " : ", ") << "0x" << std::hex << std::setw(2) << std::setfill('0') << system << std::dec << ": " << throttled[system];
+            first = false;
+        }
+    }
+    return text.str();
+}
+
+Pacer::Pacer(const UARTInfo& uart, PacingSettings settings): config(settings), baud(uart.baud_rate), link_free(0), first_start(0) {
+    bits = 1 + uart.data_bits + (uart.parity != 0 ? 1 : 0) + uart.stop_bits;
+    config.burst = std::max<uint32_t>(config.burst, 1);
+    tokens.fill(config.burst);
+    refilled.fill(0);
+    bucket_bound.fill(false);
+}
+
+int64_t Pacer::wire_ns(size_t bytes) const {
+    if (baud == 0) {
+        return 0;
+    }
+    return static_cast<int64_t>(std::llround(1e9 * double(bytes) * bits / baud));
+}
+
+void Pacer::refill(uint8_t system, int64_t now) {
+    if (refilled[system] == 0) {
+        refilled[system] = now;
+        return;
+    }
+    double earned = (now - refilled[system]) / 1e9 * config.system_rate;
+    tokens[system] = std::min<double>(config.burst, tokens[system] + earned);
+    refilled[system] = now;
+}
+
+int64_t Pacer::ready_at(uint8_t system, int64_t now) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!config.enabled) {
+        return now;
+    }
+    int64_t link_ready = link_free == 0 ? now : link_free + config.min_gap;
+    int64_t system_ready = now;
+    if (config.system_rate > 0) {
+        refill(system, now);
+        if (tokens[system] < 1) {
+            system_ready = now + static_cast<int64_t>(std::ceil((1 - tokens[system]) / config.system_rate * 1e9));
+        }
+    }
+    bucket_bound[system] = system_ready > std::max(now, link_ready);
+    return std::max({now, link_ready, system_ready});
+}
+
+void Pacer::commit(uint8_t system, size_t bytes, int64_t start, int64_t delay) {
+    std::lock_guard<std::mutex> lock(mutex);
+    int64_t wire = wire_ns(bytes);
+    if (config.system_rate > 0) {
+        refill(system, start);
+        tokens[system] = std::max(0.0, tokens[system] - 1);
+    }
+    link_free = std::max(link_free, start) + wire;
+    if (first_start == 0) {
+        first_start = start;
+    }
+
+    counters.commands += 1;
+    counters.busy += wire;
+    counters.elapsed = link_free - first_start;
+    if (delay > 0) {
+        counters.delayed += 1;
+        counters.total_delay += delay;
+        counters.max_delay = std::max(counters.max_delay, delay);
+        if (bucket_bound[system]) {
+            counters.throttled[system] += 1;
+        }
+    }
+    bucket_bound[system] = false;
+}
+
+PacingStats Pacer::stats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
@@ -0,0 +1,105 @@
+#ifndef PACING_H
+#define PACING_H
+
+#include "uart.h"
+#include <array>
+#include <string>
+#include <mutex>
+#include <cstdint>
+
+/**
+ * @brief Limits on how fast the uplink sends, from the command line.
+ */
+struct PacingSettings {
+    /**
+     * @brief Turn all pacing off, including waiting for the previous command to clear the wire.
+     */
+    bool enabled = true;
+    /**
+     * @brief Quiet time on the line between the end of one command and the start of the next, in nanoseconds.
+     */
+    int64_t min_gap = 0;
+    /**
+     * @brief Sustained commands per second allowed to each system, or 0 for no limit.
+     */
+    double system_rate = 0;
+    /**
+     * @brief Commands a system may get back to back (at link speed) before `system_rate` applies.
+     */
+    uint32_t burst = 4;
+};
+
+/**
+ * @brief Pacing counters, copied out by `Pacer::stats`.
+ */
+struct PacingStats {
+    uint64_t commands = 0;
+    // commands held back, and for how long in total and at most (ns)
+    uint64_t delayed = 0;
+    int64_t total_delay = 0;
+    int64_t max_delay = 0;
+    // commands held back by each system's limit rather than the link
+    std::array<uint64_t, 256> throttled = {};
+    // time the line spent carrying commands, and since the first one started (ns)
+    int64_t busy = 0;
+    int64_t elapsed = 0;
+
+    /**
+     * @brief One line like "40 commands, 12 paced (mean 1.20 ms, max 3.10 ms), line 35% busy, throttled 0x0a: 12".
+     */
+    std::string to_string() const;
+};
+
+/**
+ * @brief Decides when the next uplink command may start, so commands never go out faster than the line (or the Formatter) can take them.
+ *
+ * Two limits apply, and a command waits for whichever is later:
+ * - the link: a command can't start until the previous one is off the wire (its wire time, from the UART settings), plus `PacingSettings::min_gap`;
+ * - its system: a token bucket per system code, holding up to `PacingSettings::burst` commands and refilled at `PacingSettings::system_rate` per second.
+ *
+ * Wire time is `bytes × (1 start + data + parity + stop bits) / baud`. `::ready_at` and `::commit` are called from the uplink's I/O thread; `::stats` from anywhere.
+ */
+class Pacer {
+    public:
+        Pacer(const UARTInfo& uart, PacingSettings settings);
+
+        /**
+         * @brief Time to send `bytes` bytes at the configured baud rate and framing, in nanoseconds.
+         */
+        int64_t wire_ns(size_t bytes) const;
+        /**
+         * @brief Bits on the line per byte: start, data, parity and stop bits.
+         */
+        uint32_t bits_per_byte() const { return bits; }
+
+        /**
+         * @brief The earliest `steady_clock` time (ns) the next command for `system` may start, which may be `now`.
+         */
+        int64_t ready_at(uint8_t system, int64_t now);
+        /**
+         * @brief Record that a command started going out at `start`, having been held back for `delay` ns.
+         */
+        void commit(uint8_t system, size_t bytes, int64_t start, int64_t delay);
+
+        PacingStats stats();
+        const PacingSettings& settings() const { return config; }
+
+    private:
+        // refill `system`'s bucket up to `now`
+        void refill(uint8_t system, int64_t now);
+
+        PacingSettings config;
+        uint32_t baud;
+        uint32_t bits;
+
+        std::mutex mutex;
+        int64_t link_free;
+        int64_t first_start;
+        std::array<double, 256> tokens;
+        std::array<int64_t, 256> refilled;
+        // whether the last wait for each system was set by its bucket
+        std::array<bool, 256> bucket_bound;
+        PacingStats counters;
+};
+
+#endif
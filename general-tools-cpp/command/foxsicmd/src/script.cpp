@@ -0,0 +1,244 @@
+#include "script.h"
+#include "trace.h"
+
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <unordered_map>
+#include <memory>
+#include <cstdlib>
+#include <cmath>
+
+namespace {
+    int64_t steady_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // sleep until close to `target`, then spin the rest of the way: sleeps alone overshoot by tens of microseconds or more.
+    // the spin yields, so the I/O thread still gets the CPU on a single-core machine.
+    void wait_until(int64_t target) {
+        const int64_t spin = 1000000;
+        int64_t now = steady_ns();
+        if (target - now > spin) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(target - now - spin));
+        }
+        while (steady_ns() < target) {
+            std::this_thread::yield();
+        }
+    }
+
+    // a system by name or hex code
+    const System& find_system(const Deck& deck, const std::string& token) {
+        if (token.substr(0, 2) == "0x" || token.substr(0, 2) == "0X") {
+            return deck.lookup(static_cast<uint8_t>(strtol(token.c_str(), NULL, 16)));
+        }
+        return deck.lookup(std::string_view(token));
+    }
+
+    const Command& find_command(const Deck& deck, const System& system, const std::string& token) {
+        if (token.substr(0, 2) == "0x" || token.substr(0, 2) == "0X") {
+            return deck.lookup(system.hex, static_cast<uint8_t>(strtol(token.c_str(), NULL, 16)));
+        }
+        return deck.lookup(std::string_view(system.name), std::string_view(token));
+    }
+}
+
+bool script::parse_duration(const std::string& text, int64_t& ns) {
+    char* end = nullptr;
+    double value = strtod(text.c_str(), &end);
+    if (end == text.c_str() || value < 0 || !std::isfinite(value)) {
+        return false;
+    }
+    std::string unit(end);
+    double scale;
+    if (unit == "ns") {
+        scale = 1;
+    } else if (unit == "us") {
+        scale = 1e3;
+    } else if (unit == "ms") {
+        scale = 1e6;
+    } else if (unit == "s") {
+        scale = 1e9;
+    } else if (unit == "" && value == 0) {
+        scale = 0;
+    } else {
+        return false;
+    }
+    ns = static_cast<int64_t>(std::llround(value * scale));
+    return true;
+}
+
+bool script::parse(std::istream& in, const Deck& deck, std::vector<Step>& steps, std::string& error) {
+    steps.clear();
+    // time of the previous send, from the start of the script
+    int64_t cursor = 0;
+    std::string text;
+    for (size_t line = 1; std::getline(in, text); ++line) {
+        text = text.substr(0, text.find('#'));
+        std::stringstream words(text);
+        std::vector<std::string> tokens;
+        for (std::string word; words >> word;) {
+            tokens.push_back(word);
+        }
+        if (tokens.empty()) {
+            continue;
+        }
+        auto fail = [&](std::string message) {
+            error = "line " + std::to_string(line) + ": " + message;
+            return false;
+        };
+
+        int64_t duration;
+        if (tokens[0] == "wait" || tokens[0] == "at") {
+            if (tokens.size() != 2 || !parse_duration(tokens[1], duration)) {
+                return fail(tokens[0] + " needs one duration, like 10ms");
+            }
+            if (tokens[0] == "wait") {
+                cursor += duration;
+            } else if (duration < cursor) {
+                return fail("at " + tokens[1] + " is before the previous send");
+            } else {
+                cursor = duration;
+            }
+        } else if (tokens[0] == "send") {
+            if (tokens.size() < 3) {
+                return fail("send needs a system and a command");
+            }
+            const System& system = find_system(deck, tokens[1]);
+            if (system.name == "") {
+                return fail("no system " + tokens[1] + " in the deck");
+            }
+            const Command& command = find_command(deck, system, tokens[2]);
+            if (command.name == "") {
+                return fail("no command " + tokens[2] + " for " + system.name);
+            }
+            long repeat = 1;
+            int64_t every = 0;
+            for (size_t k = 3; k < tokens.size(); k += 2) {
+                if (k + 1 >= tokens.size()) {
+                    return fail(tokens[k] + " needs a value");
+                }
+                if (tokens[k] == "repeat") {
+                    char* end = nullptr;
+                    repeat = strtol(tokens[k + 1].c_str(), &end, 10);
+                    if (*end != '\0' || repeat < 1) {
+                        return fail("repeat needs a count of at least 1");
+                    }
+                } else if (tokens[k] == "every") {
+                    if (!parse_duration(tokens[k + 1], every)) {
+                        return fail("every needs a duration, like 10ms");
+                    }
+                } else {
+                    return fail("unknown option " + tokens[k]);
+                }
+            }
+            for (long r = 0; r < repeat; ++r) {
+                if (r > 0) {
+                    cursor += every;
+                }
+                Step step;
+                step.line = line;
+                step.system = system.name;
+                step.command = command.name;
+                step.bytes = {system.hex, command.hex};
+                step.offset = cursor;
+                steps.push_back(step);
+            }
+        } else {
+            return fail("unknown instruction " + tokens[0] + " (use send, wait or at)");
+        }
+    }
+    return true;
+}
+
+std::vector<script::Result> script::run(const std::vector<Step>& steps, Uplink& uplink, int64_t lead) {
+    // shared with the uplink's callback, which may still be called after a drain times out and this returns
+    struct Sink {
+        std::vector<Result> results;
+        std::unordered_map<uint64_t, size_t> by_id;
+        std::mutex mutex;
+    };
+    auto sink = std::make_shared<Sink>();
+    sink->results.resize(steps.size());
+
+    // collect every finished write, not just the uplink's recent history. The callback this replaces is handed back from the I/O thread, and put back afterwards:
+    auto previous = uplink.set_on_done([sink](const UplinkRecord& record) {
+        std::lock_guard<std::mutex> lock(sink->mutex);
+        auto found = sink->by_id.find(record.id);
+        if (found != sink->by_id.end()) {
+            sink->results[found->second].record = record;
+        }
+    });
+
+    int64_t start = steady_ns() + lead;
+    for (size_t k = 0; k < steps.size(); ++k) {
+        Result& result = sink->results[k];
+        result.step = steps[k];
+        result.scheduled = start + steps[k].offset;
+        wait_until(result.scheduled);
+        result.released = steady_ns();
+        std::lock_guard<std::mutex> lock(sink->mutex);
+        sink->by_id[uplink.send(steps[k].bytes[0], steps[k].bytes, steps[k].system + " > " + steps[k].command)] = k;
+    }
+    trace::Span span("script drain", "uplink");
+    bool drained = uplink.drain(std::chrono::seconds(10));
+    uplink.set_on_done(previous.get());
+
+    std::lock_guard<std::mutex> lock(sink->mutex);
+    std::vector<Result> results = sink->results;
+    if (!drained) {
+        for (auto& result: results) {
+            if (result.record.id == 0) {
+                result.record.error = "not written";
+            }
+        }
+    }
+    return results;
+}
+
+std::string script::report(const std::vector<Result>& results) {
+    int64_t start = results.empty() ? 0 : results[0].scheduled - results[0].step.offset;
+    std::stringstream out;
+    out << std::fixed << std::setprecision(1);
+    out << "step,line,system,command,scheduled us,released us,started us,done us,late us,paced us,wire us,to wire us,ok\n";
+    std::vector<double> late;
+    std::vector<double> to_wire;
+    size_t failed = 0;
+    for (size_t k = 0; k < results.size(); ++k) {
+        const Result& r = results[k];
+        auto us = [&](int64_t time) { return (time - start) / 1e3; };
+        double late_us = (r.record.started - r.scheduled) / 1e3;
+        // a send that was never written has no start time to be late by
+        if (r.record.id != 0) {
+            late.push_back(late_us);
+        }
+        if (r.record.drained != 0) {
+            to_wire.push_back(r.record.to_wire_ns() / 1e3);
+        }
+        failed += r.record.ok ? 0 : 1;
+        out << k << "," << r.step.line << "," << r.step.system << "," << r.step.command << ",";
+        out << us(r.scheduled) << "," << us(r.released) << "," << us(r.record.started) << "," << us(r.record.done) << ",";
+        out << late_us << "," << r.record.paced / 1e3 << "," << r.record.wire_ns() / 1e3 << "," << r.record.to_wire_ns() / 1e3 << "," << (r.record.ok ? "yes" : r.record.error) << "\n";
+    }
+    // mean, median, p99 and max of `values`
+    auto summary = [](std::vector<double>& values) {
+        std::sort(values.begin(), values.end());
+        double sum = 0;
+        for (double value: values) {
+            sum += value;
+        }
+        std::stringstream text;
+        text << std::fixed << std::setprecision(1);
+        text << "mean " << sum / values.size() << ", median " << values[values.size() / 2] << ", p99 " << values[std::min(values.size() - 1, values.size() * 99 / 100)] << ", max " << values.back();
+        return text.str();
+    };
+    if (!late.empty()) {
+        out << "\n# " << results.size() << " sends, " << failed << " failed. lateness (start of write - scheduled), us: " << summary(late) << "\n";
+    }
+    if (!to_wire.empty()) {
+        out << "# write-to-wire latency (start of write - output queue empty), us: " << summary(to_wire) << "\n";
+    }
+    return out.str();
+}
@@ -0,0 +1,71 @@
+#ifndef SCRIPT_H
+#define SCRIPT_H
+
+#include "commands.h"
+#include "uplink.h"
+#include <istream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief Batch uplink from a text script, for `foxsicmd --script`.
+ *
+ * A script is one instruction per line; `#` starts a comment. Systems and commands are names from the deck, or hex codes like `0x0a`. Durations are a number and a unit: `ns`, `us`, `ms` or `s`.
+ * - `send SYSTEM COMMAND [repeat N] [every DURATION]`: send the command (as the GSE would, system code then command code) N times, DURATION apart.
+ * - `wait DURATION`: the next send is DURATION after the previous one.
+ * - `at DURATION`: the next send is DURATION after the script started.
+ *
+ * Every send gets an absolute time from the start of the script before anything is sent, so a late send doesn't push the rest of the script later.
+ */
+namespace script {
+    struct Step {
+        // line of the script this came from, counting from 1
+        size_t line = 0;
+        std::string system;
+        std::string command;
+        std::vector<uint8_t> bytes;
+        // when to send, in nanoseconds from the start of the script
+        int64_t offset = 0;
+    };
+
+    struct Result {
+        Step step;
+        // `steady_clock` nanoseconds the step was due, and when the scheduler handed it to the uplink
+        int64_t scheduled = 0;
+        int64_t released = 0;
+        UplinkRecord record;
+    };
+
+    /**
+     * @brief Parse a duration like `250us` or `1.5s`.
+     *
+     * @return false if `text` isn't a duration.
+     */
+    bool parse_duration(const std::string& text, int64_t& ns);
+
+    /**
+     * @brief Read a script, resolving names through `deck` and expanding repeats.
+     *
+     * @param error set to a description of the problem, with its line number, if the script is invalid.
+     * @return true if every line was understood.
+     */
+    bool parse(std::istream& in, const Deck& deck, std::vector<Step>& steps, std::string& error);
+
+    /**
+     * @brief Send every step through `uplink` at its time, then wait for all of them to be written.
+     *
+     * Each step is released to the uplink at its absolute time: the scheduler sleeps until just before it, then spins, to be accurate to well under a millisecond. Nothing else should send through `uplink` meanwhile.
+     *
+     * @param lead delay before the first step, so the first sends aren't late while everything starts.
+     * @return one result per step.
+     */
+    std::vector<Result> run(const std::vector<Step>& steps, Uplink& uplink, int64_t lead);
+
+    /**
+     * @brief A CSV table of every result (times in microseconds from the start of the script), then a summary of how late sends were. Sends held back by the uplink's `Pacer` count as late, and their `paced` column says by how much. With `Uplink::measure_wire`, it also summarises write-to-wire latency.
+     */
+    std::string report(const std::vector<Result>& results);
+};
+
+#endif
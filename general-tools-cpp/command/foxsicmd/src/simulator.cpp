@@ -0,0 +1,158 @@
+#include "simulator.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <termios.h>
+
+namespace {
+    int64_t steady_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+SerialSim::SerialSim(SimSettings settings):
+    settings(settings),
+    bytes_in(0),
+    commands(0),
+    partial(0),
+    replies_dropped(0),
+    master(-1),
+    slave(-1),
+    running(false),
+    pending_time(0),
+    line_free(0) {}
+
+SerialSim::~SerialSim() {
+    stop();
+    if (slave >= 0) {
+        close(slave);
+    }
+    if (master >= 0) {
+        close(master);
+    }
+}
+
+bool SerialSim::open(std::string& error) {
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        error = std::string("couldn't create a pseudo-terminal: ") + std::strerror(errno);
+        return false;
+    }
+    device_path = ptsname(master);
+
+    // hold the other end open too, so the pseudo-terminal doesn't hang up while foxsicmd isn't connected.
+    // it must be raw, or replies would be echoed straight back as if they were commands.
+    slave = ::open(device_path.c_str(), O_RDWR | O_NOCTTY);
+    termios raw;
+    if (slave < 0 || tcgetattr(slave, &raw) != 0) {
+        error = "couldn't open " + device_path + ": " + std::strerror(errno);
+        return false;
+    }
+    cfmakeraw(&raw);
+    tcsetattr(slave, TCSANOW, &raw);
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+    return true;
+}
+
+void SerialSim::start() {
+    if (running.exchange(true)) {
+        return;
+    }
+    thread = std::thread(&SerialSim::run, this);
+}
+
+void SerialSim::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+    thread.join();
+}
+
+void SerialSim::run() {
+    trace::set_thread_name("simulator");
+    uint8_t buffer[4096];
+    while (running) {
+        pollfd ready = {master, POLLIN, 0};
+        if (poll(&ready, 1, 10) > 0 && (ready.revents & POLLIN)) {
+            int64_t now = steady_ns();
+            ssize_t count = read(master, buffer, sizeof(buffer));
+            if (count > 0) {
+                bytes_in.fetch_add(count);
+                for (ssize_t k = 0; k < count; ++k) {
+                    take(buffer[k], now);
+                }
+            }
+        }
+        // a first byte left waiting too long is dropped, as the Formatter would
+        if (!pending.empty() && steady_ns() - pending_time > settings.byte_timeout) {
+            partial.fetch_add(pending.size());
+            pending.clear();
+        }
+    }
+}
+
+void SerialSim::take(uint8_t byte, int64_t time) {
+    if (settings.baud_rate > 0) {
+        // the byte can't finish arriving before the previous one has, plus its own time on the wire
+        int64_t wire = 1000000000ll * settings.bits_per_byte / settings.baud_rate;
+        time = std::max(time, line_free) + wire;
+        line_free = time;
+        std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(time)));
+    }
+    if (!pending.empty() && time - pending_time > settings.byte_timeout) {
+        partial.fetch_add(pending.size());
+        pending.clear();
+    }
+    if (pending.empty()) {
+        pending_time = time;
+    }
+    pending.push_back(byte);
+    size_t length = settings.mode == SimMode::formatter ? 2 : 1;
+    if (pending.size() < length) {
+        return;
+    }
+
+    SimArrival arrival;
+    arrival.index = commands.load();
+    arrival.time = time;
+    arrival.bytes = std::move(pending);
+    pending.clear();
+    reply(arrival.bytes);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        received.push_back(std::move(arrival));
+        commands.fetch_add(1);
+    }
+    arrived.notify_all();
+}
+
+void SerialSim::reply(const std::vector<uint8_t>& bytes) {
+    if (settings.reply == SimReply::none) {
+        return;
+    }
+    std::vector<uint8_t> out;
+    if (settings.reply == SimReply::ack) {
+        out.push_back(0x06);
+    }
+    out.insert(out.end(), bytes.begin(), bytes.end());
+    ssize_t written = write(master, out.data(), out.size());
+    if (written < static_cast<ssize_t>(out.size())) {
+        replies_dropped.fetch_add(out.size() - std::max<ssize_t>(written, 0));
+    }
+}
+
+bool SerialSim::wait_for(size_t count, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex);
+    return arrived.wait_for(lock, timeout, [&] { return received.size() >= count; });
+}
+
+std::vector<SimArrival> SerialSim::arrivals() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return received;
+}
@@ -0,0 +1,125 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @brief How `SerialSim` reads commands: as the Formatter does (two bytes, system code then command code), or as Timepix does when the Formatter is bypassed (one byte per command).
+ */
+enum class SimMode {
+    formatter,
+    timepix
+};
+
+/**
+ * @brief What `SerialSim` writes back for each command: nothing, the command's own bytes, or an ack (0x06 followed by the command's bytes).
+ */
+enum class SimReply {
+    none,
+    echo,
+    ack
+};
+
+struct SimSettings {
+    SimMode mode = SimMode::formatter;
+    SimReply reply = SimReply::none;
+    /**
+     * @brief Line speed to model, or 0 for bytes to arrive as fast as the pseudo-terminal passes them.
+     */
+    uint32_t baud_rate = 0;
+    /**
+     * @brief Bits on the line per byte (start, data, parity and stop bits), for `baud_rate`.
+     */
+    uint32_t bits_per_byte = 10;
+    /**
+     * @brief How long the Formatter waits for the second byte of a command before dropping the first, in nanoseconds.
+     */
+    int64_t byte_timeout = 10000000;
+};
+
+/**
+ * @brief One command the simulator received, in order, with the `steady_clock` time (ns) its last byte arrived.
+ */
+struct SimArrival {
+    uint64_t index = 0;
+    int64_t time = 0;
+    std::vector<uint8_t> bytes;
+};
+
+/**
+ * @brief A stand-in for the Formatter (or Timepix) on the other end of a pseudo-terminal, for testing foxsicmd without hardware.
+ *
+ * `::open` creates a pseudo-terminal pair; foxsicmd opens `::device` as its serial port (`--port`). A thread reads the other end and parses commands as `SimSettings::mode` says, timestamping each one and replying as `SimSettings::reply` says.
+ *
+ * With a `SimSettings::baud_rate`, each byte arrives no sooner than the previous one plus its time on the wire, and the simulator waits until then before handling it, so a fast sender backs up as it would on a real UART. Arrival times are `steady_clock`, so a benchmark in the same process (or on the same machine) can compare them with send times directly.
+ */
+class SerialSim {
+    public:
+        SerialSim(SimSettings settings);
+        ~SerialSim();
+
+        /**
+         * @brief Create the pseudo-terminal pair.
+         *
+         * @param error set to a description of the problem if it couldn't be created.
+         */
+        bool open(std::string& error);
+        /**
+         * @brief Path of the end for foxsicmd to open, like /dev/pts/3.
+         */
+        const std::string& device() const { return device_path; }
+
+        void start();
+        void stop();
+
+        /**
+         * @brief Wait until at least `count` commands have arrived, or `timeout` passes.
+         */
+        bool wait_for(size_t count, std::chrono::milliseconds timeout);
+        /**
+         * @brief Every command received so far.
+         */
+        std::vector<SimArrival> arrivals();
+
+        /**
+         * @brief Set before `::start`.
+         */
+        SimSettings settings;
+
+        std::atomic<uint64_t> bytes_in;
+        std::atomic<uint64_t> commands;
+        // first bytes of commands dropped because the second byte came too late
+        std::atomic<uint64_t> partial;
+        // reply bytes that didn't fit in the pseudo-terminal because nothing was reading them
+        std::atomic<uint64_t> replies_dropped;
+
+    private:
+        void run();
+        // handle one byte that arrived at `time`
+        void take(uint8_t byte, int64_t time);
+        void reply(const std::vector<uint8_t>& bytes);
+
+        int master;
+        int slave;
+        std::string device_path;
+        std::thread thread;
+        std::atomic<bool> running;
+
+        // only touched on the simulator thread:
+        std::vector<uint8_t> pending;
+        int64_t pending_time;
+        int64_t line_free;
+
+        std::mutex mutex;
+        std::condition_variable arrived;
+        std::vector<SimArrival> received;
+};
+
+#endif
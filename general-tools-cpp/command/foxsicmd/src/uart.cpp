@@ -1,5 +1,26 @@
 #include "uart.h"
 #include <sstream>
+#include <fstream>
+#include <filesystem>
+#include <cstring>
+#include <cerrno>
+#include <termios.h>
+#include <sys/ioctl.h>
+#ifdef __linux__
+#include <linux/serial.h>
+#endif
+
+namespace {
+    // sysfs file for the latency timer of the USB-serial adapter behind `port_name`, e.g. /sys/class/tty/ttyUSB0/device/latency_timer
+    std::string latency_timer_path(const std::string& port_name) {
+        std::error_code err;
+        std::filesystem::path device = std::filesystem::canonical(port_name, err);
+        if (err) {
+            return "";
+        }
+        return "/sys/class/tty/" + device.filename().string() + "/device/latency_timer";
+    }
+}
 
 UARTInfo::UARTInfo(std::string port_name, uint32_t baud_rate, uint8_t data_bits, uint8_t stop_bits, uint8_t parity): port_name(port_name), baud_rate(baud_rate), data_bits(data_bits), stop_bits(stop_bits), parity(parity) {};
 
@@ -12,7 +33,74 @@ std::string UARTInfo::to_string() {
     result << "\n\t" << "data_bits:\t" << std::to_string(data_bits);;
     result << "\n\t" << "stop_bits:\t" << std::to_string(stop_bits);
     result << "\n\t" << "parity:\t\t" << std::to_string(parity);
+    result << "\n\t" << "flow_control:\t" << std::to_string(flow_control);
+    result << "\n\t" << "vmin, vtime:\t" << std::to_string(read_min) << ", " << std::to_string(read_timeout);
+    result << "\n\t" << "low_latency:\t" << (low_latency ? "yes" : "no");
+    if (latency_timer != 0) {
+        result << "\n\t" << "latency_timer:\t" << std::to_string(latency_timer) << " ms";
+    }
+    if (xmit_fifo != 0) {
+        result << "\n\t" << "xmit_fifo:\t" << std::to_string(xmit_fifo);
+    }
     result << "\n";
 
     return result.str();
-}
\ No newline at end of file
+}
+
+bool UARTInfo::apply_tuning(int fd, std::vector<std::string>& notes) const {
+    termios settings;
+    if (tcgetattr(fd, &settings) != 0) {
+        notes.push_back(std::string("couldn't read termios settings: ") + std::strerror(errno));
+        return false;
+    }
+    settings.c_cc[VMIN] = read_min;
+    settings.c_cc[VTIME] = read_timeout;
+    if (tcsetattr(fd, TCSANOW, &settings) != 0) {
+        notes.push_back(std::string("couldn't set VMIN/VTIME: ") + std::strerror(errno));
+        return false;
+    }
+
+#if defined(__linux__) && defined(TIOCGSERIAL)
+    if (low_latency || xmit_fifo != 0) {
+        serial_struct serial;
+        if (ioctl(fd, TIOCGSERIAL, &serial) != 0) {
+            notes.push_back(std::string("no serial driver settings (ASYNC_LOW_LATENCY, xmit_fifo) on this port: ") + std::strerror(errno));
+        } else {
+            if (low_latency) {
+                serial.flags |= ASYNC_LOW_LATENCY;
+            }
+            if (xmit_fifo != 0) {
+                serial.xmit_fifo_size = xmit_fifo;
+            }
+            if (ioctl(fd, TIOCSSERIAL, &serial) != 0) {
+                notes.push_back(std::string("couldn't set ASYNC_LOW_LATENCY or xmit_fifo: ") + std::strerror(errno));
+            }
+        }
+    }
+#else
+    if (low_latency || xmit_fifo != 0) {
+        notes.push_back("ASYNC_LOW_LATENCY and xmit_fifo are only supported on Linux");
+    }
+#endif
+
+    if (latency_timer != 0) {
+        std::string path = latency_timer_path(port_name);
+        std::ofstream timer(path);
+        timer << std::to_string(latency_timer) << "\n";
+        timer.close();
+        if (path == "" || !timer) {
+            notes.push_back("couldn't set the latency timer" + (path == "" ? std::string("") : " (" + path + ")") + ": not an FTDI adapter, or no permission");
+        }
+    }
+    return true;
+}
+
+int UARTInfo::read_latency_timer() const {
+    std::string path = latency_timer_path(port_name);
+    std::ifstream timer(path);
+    int ms = -1;
+    if (path == "" || !(timer >> ms)) {
+        return -1;
+    }
+    return ms;
+}
@@ -2,6 +2,8 @@
 #define UART_H
 
 #include <string>
+#include <vector>
+#include <cstdint>
 
 class UARTInfo {
     
@@ -10,12 +12,49 @@ class UARTInfo {
         UARTInfo(std::string port_name, uint32_t baud_rate, uint8_t data_bits, uint8_t stop_bits, uint8_t parity);
 
         std::string port_name;
-        uint32_t baud_rate;
-        uint8_t data_bits;
-        uint8_t stop_bits;
-        uint8_t parity;
+        uint32_t baud_rate = 0;
+        uint8_t data_bits = 0;
+        uint8_t stop_bits = 0;
+        uint8_t parity = 0;
+
+        /**
+         * @brief Flow control: 0 for none, 1 for software (XON/XOFF), 2 for hardware (RTS/CTS).
+         */
+        uint8_t flow_control = 0;
+        /**
+         * @brief termios `VMIN` and `VTIME`: a blocking read returns after `read_min` bytes, or `read_timeout` tenths of a second after the last byte.
+         *
+         * These only affect blocking reads of the port. The downlink's reads are Boost.Asio async reads on a non-blocking descriptor, which return whatever has arrived whatever these are set to.
+         */
+        uint8_t read_min = 1;
+        uint8_t read_timeout = 0;
+        /**
+         * @brief Set `ASYNC_LOW_LATENCY` on the port. On FTDI adapters this drops the latency timer from 16 ms to 1 ms. Off unless the config asks for it, so the port is left as the driver set it up.
+         */
+        bool low_latency = false;
+        /**
+         * @brief FTDI latency timer to write through sysfs, in ms, or 0 to leave it.
+         */
+        uint8_t latency_timer = 0;
+        /**
+         * @brief Driver transmit FIFO size (`serial_struct::xmit_fifo_size`), or 0 to leave it.
+         */
+        uint32_t xmit_fifo = 0;
 
         std::string to_string();
+
+        /**
+         * @brief Apply the settings Boost.Asio's `serial_port` options don't cover to an open port: `VMIN`/`VTIME`, `ASYNC_LOW_LATENCY`, the transmit FIFO size and the latency timer.
+         *
+         * Settings this platform or driver doesn't support (a pseudo-terminal has no `serial_struct`, and only FTDI adapters have a latency timer) are skipped, with a line in `notes` for each.
+         *
+         * @return false if the port's termios settings couldn't be changed at all.
+         */
+        bool apply_tuning(int fd, std::vector<std::string>& notes) const;
+        /**
+         * @brief The adapter's latency timer in ms, read from sysfs, or -1 if it has none.
+         */
+        int read_latency_timer() const;
 };
 
-#endif
\ No newline at end of file
+#endif
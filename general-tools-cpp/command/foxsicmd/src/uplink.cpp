@@ -0,0 +1,164 @@
+#include "uplink.h"
+#include "trace.h"
+#include <memory>
+#include <utility>
+#include <sys/ioctl.h>
+
+namespace {
+    int64_t steady_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // bytes written to `fd` but not yet sent by the driver, or -1 if the platform can't tell
+    int output_queued(int fd) {
+#ifdef TIOCOUTQ
+        int count = 0;
+        if (ioctl(fd, TIOCOUTQ, &count) == 0) {
+            return count;
+        }
+#endif
+        return -1;
+    }
+}
+
+Uplink::Uplink(boost::asio::serial_port& port, const UARTInfo& uart, PacingSettings pacing):
+    sent(0),
+    failed(0),
+    bytes_sent(0),
+    pacer(uart, pacing),
+    port(port),
+    next_id(1),
+    queued(0),
+    writing(false),
+    pace_timer(port.get_executor()) {}
+
+uint64_t Uplink::send(uint8_t system, std::vector<uint8_t> bytes, std::string label) {
+    UplinkRecord record;
+    record.id = next_id.fetch_add(1);
+    record.system = system;
+    record.label = std::move(label);
+    record.bytes = std::move(bytes);
+    record.queued = steady_ns();
+    queued.fetch_add(1);
+
+    uint64_t id = record.id;
+    boost::asio::post(port.get_executor(), [this, record = std::move(record)]() mutable {
+        waiting.push_back(std::move(record));
+        if (!writing) {
+            write_next();
+        }
+    });
+    return id;
+}
+
+std::future<std::function<void(const UplinkRecord&)>> Uplink::set_on_done(std::function<void(const UplinkRecord&)> callback) {
+    auto replaced = std::make_shared<std::promise<std::function<void(const UplinkRecord&)>>>();
+    auto previous = replaced->get_future();
+    // dispatch rather than post, so a call made on the I/O thread swaps at once rather than leaving its future to wait on that thread
+    boost::asio::dispatch(port.get_executor(), [this, replaced, callback = std::move(callback)]() mutable {
+        replaced->set_value(std::exchange(on_done, std::move(callback)));
+    });
+    return previous;
+}
+
+void Uplink::write_next() {
+    if (waiting.empty()) {
+        writing = false;
+        return;
+    }
+    writing = true;
+    const UplinkRecord& front = waiting.front();
+    int64_t now = steady_ns();
+    int64_t ready = pacer.ready_at(front.system, now);
+    if (ready <= now) {
+        write_front(0);
+        return;
+    }
+    // nothing else is written meanwhile, so the queue stays in order
+    pace_timer.expires_after(std::chrono::nanoseconds(ready - now));
+    pace_timer.async_wait([this, now](const boost::system::error_code&) {
+        write_front(steady_ns() - now);
+    });
+}
+
+void Uplink::write_front(int64_t delay) {
+    UplinkRecord& front = waiting.front();
+    front.started = steady_ns();
+    front.paced = delay;
+    pacer.commit(front.system, front.bytes.size(), front.started, delay);
+    boost::asio::async_write(port, boost::asio::buffer(waiting.front().bytes), [this](const boost::system::error_code& err, size_t written) {
+        UplinkRecord& front = waiting.front();
+        front.done = steady_ns();
+        front.ok = !err;
+        if (err) {
+            front.error = err.message();
+        }
+        bytes_sent.fetch_add(written);
+        if (measure_wire && front.ok && output_queued(port.native_handle()) >= 0) {
+            // look first when the bytes should be out at the baud rate
+            wait_on_wire(front.started + pacer.wire_ns(front.bytes.size()));
+            return;
+        }
+        finish_front();
+    });
+}
+
+void Uplink::wait_on_wire(int64_t at) {
+    pace_timer.expires_at(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(at)));
+    pace_timer.async_wait([this](const boost::system::error_code&) {
+        UplinkRecord& front = waiting.front();
+        int64_t now = steady_ns();
+        int left = output_queued(port.native_handle());
+        if (left > 0 && now - front.done < wire_timeout) {
+            wait_on_wire(now + wire_poll);
+            return;
+        }
+        if (left == 0) {
+            front.drained = now;
+        }
+        finish_front();
+    });
+}
+
+void Uplink::finish_front() {
+    UplinkRecord record = std::move(waiting.front());
+    waiting.pop_front();
+    if (record.ok) {
+        sent.fetch_add(1);
+    } else {
+        failed.fetch_add(1);
+    }
+    trace::complete("uplink write", "uplink", record.started, record.wire_ns(), record.label.c_str());
+    if (record.drained != 0) {
+        trace::complete("uplink on wire", "uplink", record.started, record.to_wire_ns(), record.label.c_str());
+    }
+
+    if (on_done) {
+        on_done(record);
+    }
+    {
+        std::lock_guard<std::mutex> lock(done_mutex);
+        finished.push_back(std::move(record));
+        if (finished.size() > history) {
+            finished.pop_front();
+        }
+        queued.fetch_sub(1);
+    }
+    done_changed.notify_all();
+    write_next();
+}
+
+bool Uplink::drain(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(done_mutex);
+    return done_changed.wait_for(lock, timeout, [this] { return queued.load() == 0; });
+}
+
+UplinkRecord Uplink::last() {
+    std::lock_guard<std::mutex> lock(done_mutex);
+    return finished.empty() ? UplinkRecord() : finished.back();
+}
+
+std::deque<UplinkRecord> Uplink::recent() {
+    std::lock_guard<std::mutex> lock(done_mutex);
+    return finished;
+}
@@ -0,0 +1,142 @@
+#ifndef UPLINK_H
+#define UPLINK_H
+
+#include "pacing.h"
+#include <boost/asio.hpp>
+#include <vector>
+#include <deque>
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @brief One command through the uplink queue, with when it was queued, started going out, and finished.
+ *
+ * Times are `steady_clock` nanoseconds. `wire_ns()` is how long the write itself took, which only means the kernel has the bytes; `to_wire_ns()` is how long until the driver had sent them all (write-to-wire latency), when measured. `wait_ns()` is how long the command sat behind earlier ones.
+ */
+struct UplinkRecord {
+    uint64_t id = 0;
+    // system the command is for, which `Pacer` limits separately
+    uint8_t system = 0;
+    std::string label;
+    std::vector<uint8_t> bytes;
+    int64_t queued = 0;
+    int64_t started = 0;
+    int64_t done = 0;
+    // how long `Pacer` held the command back before it started
+    int64_t paced = 0;
+    // when the driver's output queue emptied after the write, if `Uplink::measure_wire` is set (0 if not measured)
+    int64_t drained = 0;
+    bool ok = false;
+    std::string error;
+
+    int64_t wait_ns() const { return started - queued; }
+    int64_t wire_ns() const { return done - started; }
+    int64_t to_wire_ns() const { return drained != 0 ? drained - started : 0; }
+};
+
+/**
+ * @brief Writes commands to the serial port in order, off the UI thread, and always writes the whole of each one.
+ *
+ * `::send` only hands the bytes to the port's `io_context` and returns, so pressing Send never blocks, even if the UART is backed up. On the I/O thread, commands are written one at a time with `boost::asio::async_write`, which keeps writing until every byte is out (unlike `write_some`). The next command starts when the previous one finishes, so bytes of different commands never interleave.
+ *
+ * Something must be running the port's `io_context` (see `main.cpp`).
+ */
+class Uplink {
+    public:
+        /**
+         * @brief Number of finished commands kept for `::recent`.
+         */
+        static constexpr size_t history = 64;
+
+        /**
+         * @param uart the port's settings, for wire times.
+         * @param pacing limits on how fast to send (see `Pacer`).
+         */
+        Uplink(boost::asio::serial_port& port, const UARTInfo& uart, PacingSettings pacing);
+
+        /**
+         * @brief Queue `bytes` to be written after everything already queued.
+         *
+         * @param system the system code the command is for, for per-system pacing.
+         * @param label shown with the command in the UI and the trace.
+         * @return the command's ID, counting from 1.
+         */
+        uint64_t send(uint8_t system, std::vector<uint8_t> bytes, std::string label);
+
+        /**
+         * @brief Wait until every queued command has been written, or `timeout` passes.
+         *
+         * @return true if the queue is empty.
+         */
+        bool drain(std::chrono::milliseconds timeout);
+
+        /**
+         * @brief Number of commands queued or being written.
+         */
+        size_t depth() const { return queued.load(std::memory_order_relaxed); }
+        /**
+         * @brief The most recently finished command, or a record with ID 0 if none has finished.
+         */
+        UplinkRecord last();
+        /**
+         * @brief Up to `::history` finished commands, oldest first.
+         */
+        std::deque<UplinkRecord> recent();
+
+        /**
+         * @brief Replace `::on_done` from any thread, even while commands are going out. The change is made on the I/O thread, so it takes effect after commands already sent have started, and `callback` may be called after this returns.
+         *
+         * @return the callback that was replaced, once the I/O thread has made the swap. Only wait on it while the I/O context is running.
+         */
+        std::future<std::function<void(const UplinkRecord&)>> set_on_done(std::function<void(const UplinkRecord&)> callback);
+
+        /**
+         * @brief Called on the I/O thread after each command finishes (or fails). Set before sending, or use `::set_on_done`.
+         */
+        std::function<void(const UplinkRecord&)> on_done;
+        /**
+         * @brief After each write, poll the driver's output queue (`TIOCOUTQ`) until it's empty, to measure write-to-wire latency in `UplinkRecord::drained`. The next command waits for the poll. Set before sending.
+         */
+        bool measure_wire = false;
+        /**
+         * @brief How often to poll the output queue, and when to give up on it, in nanoseconds.
+         */
+        static constexpr int64_t wire_poll = 100000;
+        static constexpr int64_t wire_timeout = 100000000;
+
+        std::atomic<uint64_t> sent;
+        std::atomic<uint64_t> failed;
+        std::atomic<uint64_t> bytes_sent;
+
+        Pacer pacer;
+
+    private:
+        // wait for `pacer` if needed, then write the front of `waiting`
+        void write_next();
+        void write_front(int64_t delay);
+        // poll the output queue from `at` until it's empty, then finish the front command
+        void wait_on_wire(int64_t at);
+        // count, report and drop the front command, then start the next
+        void finish_front();
+
+        boost::asio::serial_port& port;
+        std::atomic<uint64_t> next_id;
+        std::atomic<size_t> queued;
+
+        // only touched on the I/O thread:
+        std::deque<UplinkRecord> waiting;
+        bool writing;
+        boost::asio::steady_timer pace_timer;
+
+        std::mutex done_mutex;
+        std::condition_variable done_changed;
+        std::deque<UplinkRecord> finished;
+};
+
+#endif
@@ -2,6 +2,8 @@
 
 #include <sstream>
 #include <iomanip>
+#include <chrono>
+#include <ctime>
 
 namespace util{
     std::vector<uint8_t> string_to_bytes(std::string hex_str) {
@@ -40,4 +42,13 @@ namespace util{
         res << "0x" << std::hex << std::setfill('0') << std::setw(2) << static_cast<int>(hex);
         return res.str();
     }
+
+    std::string get_now_string() {
+        std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+        std::tm local;
+        localtime_r(&now, &local);
+        std::stringstream res;
+        res << std::put_time(&local, "%Y-%m-%d_%H-%M-%S");
+        return res.str();
+    }
 }
\ No newline at end of file
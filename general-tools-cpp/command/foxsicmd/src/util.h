@@ -8,5 +8,7 @@ namespace util{
     std::vector<uint8_t> string_to_bytes(std::string hex_str);
     std::string bytes_to_string(std::vector<uint8_t> hex);
     std::string byte_to_string(uint8_t hex);
+    // current local time like "2024-04-12_14-03-59", for log file names
+    std::string get_now_string();
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,20 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <iostream>
+#include <string>
+
+/**
+ * @brief For tests: print `what` as a failure if `condition` doesn't hold.
+ *
+ * @return 1 if `condition` is false, 0 if it is true, so a test can add up its failures.
+ */
+inline int check(bool condition, std::string what) {
+    if (!condition) {
+        std::cout << "FAILED: " << what << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,59 @@
+#include "commands.h"
+#include "check.h"
+#include <string>
+#include <vector>
+
+/**
+ * @brief Check `Deck` lookups by code and by name, what a missing system or command returns, duplicate codes, ordering by `order`, and that the name index survives a move.
+ */
+int main() {
+    int failures = 0;
+
+    std::vector<System> systems = {System(0x09, "cdte1", "spw"), System(0x02, "housekeeping", "uart")};
+    std::vector<std::vector<Command>> commands = {
+        {Command(0x12, "stop", 0, 2), Command(0x10, "start", 0xff0000, 0, {0x01, 0x02}), Command(0x11, "pause", 0, 1)},
+        {Command(0x01, "reset", 0, 0), Command(0x01, "reset again", 0, 1)},
+    };
+    Deck deck(systems, commands);
+
+    failures += check(deck.systems().size() == 2 && deck.size() == 4, "every system and command listed");
+    failures += check(deck.lookup(uint8_t(0x02)).name == "housekeeping", "system by code");
+    failures += check(deck.lookup(std::string_view("cdte1")).hex == 0x09, "system by name");
+
+    const Command& start = deck.lookup(0x09, 0x10);
+    failures += check(start.name == "start" && start.color == 0xff0000, "command by codes");
+    failures += check(start.write_value == std::vector<uint8_t>({0x01, 0x02}), "command keeps its write value");
+    failures += check(&deck.lookup(std::string_view("cdte1"), std::string_view("start")) == &start, "name and code lookups return the same command");
+    failures += check(deck.contains(0x09, 0x11) && !deck.contains(0x09, 0x13), "contains");
+    failures += check(deck.lookup(0x02, 0x01).name == "reset again", "last command keeps a repeated code");
+
+    failures += check(deck.lookup(uint8_t(0x7f)).name == "" && deck.lookup(uint8_t(0x7f)).hex == 0, "missing system code is empty");
+    failures += check(deck.lookup(std::string_view("nope")).name == "", "missing system name is empty");
+    failures += check(deck.lookup(0x09, 0x7f).name == "", "missing command code is empty");
+    failures += check(deck.lookup(std::string_view("cdte1"), std::string_view("nope")).name == "", "missing command name is empty");
+    failures += check(deck.lookup(std::string_view("nope"), std::string_view("start")).name == "", "command of a missing system is empty");
+    failures += check(deck.lookup(std::string_view("housekeeping"), std::string_view("start")).name == "", "command names are per system");
+
+    auto ordered = deck.lookup_commands(uint8_t(0x09));
+    failures += check(ordered.size() == 3 && ordered[0].name == "start" && ordered[1].name == "pause" && ordered[2].name == "stop", "commands sorted by order");
+    failures += check(deck.lookup_commands_str(std::string_view("cdte1")) == std::vector<std::string>({"start", "pause", "stop"}), "command names sorted by order");
+    failures += check(deck.lookup_commands(uint8_t(0x7f)).empty() && deck.lookup_commands(std::string_view("nope")).empty(), "no commands for a missing system");
+
+    // the name index holds views into the deck's own strings, so it has to move with them:
+    Deck moved(std::move(deck));
+    failures += check(moved.lookup(std::string_view("cdte1"), std::string_view("pause")).hex == 0x11, "name lookup after a move");
+    Deck assigned;
+    assigned = std::move(moved);
+    failures += check(assigned.lookup(std::string_view("housekeeping")).hex == 0x02, "name lookup after a move assignment");
+
+    // a repeated system code keeps the first system, with the last list of commands given for it:
+    Deck repeated({System(0x09, "cdte1", "spw"), System(0x09, "shadow", "spw")}, {{Command(0x10, "start", 0, 0)}, {Command(0x20, "hidden", 0, 0)}});
+    failures += check(repeated.systems().size() == 1 && repeated.lookup(uint8_t(0x09)).name == "cdte1", "first system keeps a repeated code");
+    failures += check(repeated.lookup(std::string_view("shadow")).name == "", "the later system isn't indexed");
+    failures += check(repeated.lookup(0x09, 0x20).name == "hidden" && !repeated.contains(0x09, 0x10), "last command list for a repeated code");
+
+    Deck empty;
+    failures += check(empty.size() == 0 && empty.lookup(uint8_t(0)).name == "" && empty.lookup(std::string_view("cdte1"), std::string_view("start")).name == "", "empty deck");
+
+    return failures == 0 ? 0 : 1;
+}
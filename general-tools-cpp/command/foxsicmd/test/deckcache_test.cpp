@@ -0,0 +1,113 @@
+#include "deckcache.h"
+#include "deckload.h"
+#include "check.h"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+void write_file(const std::string& path, const std::string& text) {
+    std::ofstream file(path, std::ios::trunc);
+    file << text;
+}
+
+// load the systems file at `config` the way `Line::pull_config` does, and cache the result
+bool build_cache(const std::string& config, const std::string& cache, bool timepix, std::string& error) {
+    std::ifstream file(config);
+    nlohmann::json systems_data = nlohmann::json::parse(file);
+    UARTInfo interface;
+    if (!deck_load::uplink_from(systems_data, timepix, interface, error)) {
+        return false;
+    }
+    std::vector<System> systems;
+    std::vector<std::string> files;
+    deck_load::list_command_files(systems_data, config, systems, files);
+    auto loads = deck_load::load_command_files(files, 1);
+    std::vector<std::string> sources = {config};
+    std::vector<std::vector<Command>> commands;
+    for (auto& load: loads) {
+        sources.push_back(load.path);
+        commands.push_back(load.commands);
+    }
+    Deck deck(systems, commands);
+    return deck_cache::save(cache, sources, timepix, interface, deck, error);
+}
+
+/**
+ * @brief Check that the deck cache round-trips, survives a touch, and is thrown away when a source's content changes, a source goes missing, `--timepix` flips or the config is another file. Also check that a missing command file is still listed, so callers know not to cache.
+ */
+int main() {
+    int failures = 0;
+    const std::filesystem::path directory = "/tmp/deckcache_test_" + std::to_string(getpid());
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory / "config");
+    std::filesystem::create_directories(directory / "commands");
+    const std::string config = std::filesystem::weakly_canonical(directory / "config" / "systems.json").string();
+    const std::string commands = std::filesystem::weakly_canonical(directory / "commands" / "cdte.json").string();
+    const std::string cache = (directory / "cache" / "deck.bin").string();
+
+    write_file(config, R"([
+        {"name": "gse", "hex": "0x00", "logger_interface": {"uplink_device": "/dev/ttyUSB0"}},
+        {"name": "uplink", "hex": "0x01", "uart_interface": {"baud_rate": 9600, "data_bits": 8, "stop_bits": 1, "parity_bits": 0}},
+        {"name": "timepix", "hex": "0x0a", "uart_interface": {"tty_path": "/dev/ttyUSB1", "baud_rate": 115200, "data_bits": 8, "stop_bits": 1, "parity_bits": 0}},
+        {"name": "cdte1", "hex": "0x09", "commands": "commands/cdte.json", "command_type": "spw"}
+    ])");
+    write_file(commands, R"([
+        {"name": "start", "hex": "0x10", "write_value": "0x01", "order": "0", "color": "ff0000"},
+        {"name": "stop", "hex": "0x11", "write_value": "0x00", "order": "1", "color": "00ff00"}
+    ])");
+
+    std::string error, reason;
+    failures += check(build_cache(config, cache, false, error), "cache saved: " + error);
+
+    UARTInfo interface;
+    Deck deck;
+    failures += check(deck_cache::load(cache, config, false, interface, deck, reason), "fresh cache loads: " + reason);
+    failures += check(interface.port_name == "/dev/ttyUSB0" && interface.baud_rate == 9600, "UART settings round trip");
+    failures += check(deck.size() == 2 && deck.lookup(0x09, 0x11).name == "stop" && deck.lookup(0x09, 0x10).write_value == std::vector<uint8_t>({0x01}), "deck round trip");
+
+    failures += check(!deck_cache::load(cache, config, true, interface, deck, reason) && reason.find("without --timepix") != std::string::npos, "cache without --timepix isn't used with it");
+    failures += check(build_cache(config, cache, true, error), "timepix cache saved: " + error);
+    failures += check(deck_cache::load(cache, config, true, interface, deck, reason) && interface.baud_rate == 115200, "timepix cache loads: " + reason);
+    failures += check(!deck_cache::load(cache, config, false, interface, deck, reason) && reason.find("for --timepix") != std::string::npos, "cache for --timepix isn't used without it");
+
+    failures += check(build_cache(config, cache, false, error), "cache saved again: " + error);
+    const std::string other = (directory / "config" / "other.json").string();
+    std::filesystem::copy_file(config, other);
+    failures += check(!deck_cache::load(cache, other, false, interface, deck, reason) && reason.find("built from") != std::string::npos, "cache of another config isn't used");
+
+    // a new modification time alone isn't a change:
+    std::filesystem::last_write_time(commands, std::filesystem::last_write_time(commands) + std::chrono::seconds(5));
+    failures += check(deck_cache::load(cache, config, false, interface, deck, reason), "touched file keeps the cache: " + reason);
+
+    // same size, different content, new modification time:
+    std::string text;
+    {
+        std::ifstream file(commands);
+        text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    text.replace(text.find("ff0000"), 6, "0000ff");
+    write_file(commands, text);
+    std::filesystem::last_write_time(commands, std::filesystem::last_write_time(commands) + std::chrono::seconds(10));
+    failures += check(!deck_cache::load(cache, config, false, interface, deck, reason) && reason == commands + " changed", "edited command file invalidates the cache: " + reason);
+
+    failures += check(build_cache(config, cache, false, error), "cache rebuilt: " + error);
+    failures += check(deck_cache::load(cache, config, false, interface, deck, reason) && deck.lookup(0x09, 0x10).color == 0x0000ff, "rebuilt cache has the edit: " + reason);
+
+    std::filesystem::remove(commands);
+    failures += check(!deck_cache::load(cache, config, false, interface, deck, reason) && reason == commands + " is gone", "missing command file invalidates the cache: " + reason);
+
+    // a system whose command file is missing is still listed, and fails to open:
+    std::ifstream file(config);
+    nlohmann::json systems_data = nlohmann::json::parse(file);
+    std::vector<System> systems;
+    std::vector<std::string> files;
+    deck_load::list_command_files(systems_data, config, systems, files);
+    failures += check(systems.size() == 1 && systems[0].name == "cdte1" && files.size() == 1 && files[0] == commands, "system with a missing command file is listed");
+    auto loads = deck_load::load_command_files(files, 1);
+    failures += check(loads.size() == 1 && !loads[0].opened && loads[0].commands.empty(), "missing command file isn't opened");
+
+    std::filesystem::remove_all(directory);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,75 @@
+#include "deckload.h"
+#include "check.h"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+// parse `text`, expecting it to fail with an error containing `expected`
+int check_error(std::string text, std::string expected, std::string what) {
+    std::vector<Command> commands = {Command(0x01, "stale")};
+    std::string error;
+    bool ok = deck_load::parse_commands(text, commands, error);
+    return check(!ok && error.find(expected) != std::string::npos && commands.empty(), what + ": " + error);
+}
+
+/**
+ * @brief Check the SAX command-file parser on good files, in both layouts, and on every way it can fail; and that loading files in parallel keeps their order and reports each one's problem.
+ */
+int main() {
+    int failures = 0;
+    std::vector<Command> commands;
+    std::string error;
+
+    std::string text = R"([
+        {"name": "start", "hex": "0x10", "write_value": "0x0102", "order": "2", "color": "ff0000", "note": "ignored"},
+        {"name": "stop", "hex": "0x11", "write_value": "", "order": "1", "color": "00ff00", "extra": {"name": "not this", "hex": "0x99"}, "list": ["a", 1, null]}
+    ])";
+    failures += check(deck_load::parse_commands(text, commands, error), "array file parses: " + error);
+    failures += check(commands.size() == 2 && commands[0].name == "start" && commands[0].hex == 0x10 && commands[0].order == 2 && commands[0].color == 0xff0000, "first entry's fields");
+    failures += check(commands[0].write_value == std::vector<uint8_t>({0x01, 0x02}), "write value bytes");
+    failures += check(commands[1].name == "stop" && commands[1].hex == 0x11 && commands[1].write_value.empty(), "nested fields are skipped");
+
+    text = R"({"a": {"name": "reset", "hex": "0x01", "write_value": "0x00", "order": "0", "color": "000000"}})";
+    failures += check(deck_load::parse_commands(text, commands, error) && commands.size() == 1 && commands[0].name == "reset", "object file parses: " + error);
+
+    text = "[]";
+    failures += check(deck_load::parse_commands(text, commands, error) && commands.empty(), "empty array has no commands");
+
+    failures += check_error(R"([{"name": "start", "hex": "0x10", "write_value": "0x01", "order": "0"}])", "entry 0 has no string \"color\"", "missing field");
+    failures += check_error(R"([{"name": "a", "hex": "0x10", "write_value": "", "order": "0", "color": "0"}, {"name": "b", "hex": 17, "write_value": "", "order": "0", "color": "0"}])", "entry 1 has no string \"hex\"", "number where a string belongs");
+    failures += check_error(R"([{"name": "start", "hex": "0x10",)", "parse error", "truncated file");
+    failures += check_error("", "parse error", "empty file");
+    failures += check_error(R"([{"name": "start" "hex": "0x10"}])", "parse error", "missing comma");
+
+    // several files over two threads, in order, with each one's outcome:
+    const std::filesystem::path directory = "/tmp/deckload_test_" + std::to_string(getpid());
+    std::filesystem::create_directories(directory);
+    std::vector<std::string> paths;
+    for (size_t k = 0; k < 5; ++k) {
+        paths.push_back((directory / ("commands_" + std::to_string(k) + ".json")).string());
+        std::ofstream file(paths.back());
+        if (k == 2) {
+            file << "[{\"name\": \"broken\"";
+        } else if (k != 3) {
+            file << "[{\"name\": \"c" << k << "\", \"hex\": \"0x0" << k << "\", \"write_value\": \"\", \"order\": \"0\", \"color\": \"0\"}]";
+        }
+    }
+    std::filesystem::remove(paths[3]);
+    auto loads = deck_load::load_command_files(paths, 2);
+    failures += check(loads.size() == paths.size(), "one load per file");
+    for (size_t k = 0; k < loads.size() && k < paths.size(); ++k) {
+        failures += check(loads[k].path == paths[k], "load " + std::to_string(k) + " in order");
+        if (k == 2) {
+            failures += check(loads[k].opened && loads[k].error != "" && loads[k].commands.empty(), "broken file reports an error");
+        } else if (k == 3) {
+            failures += check(!loads[k].opened && loads[k].commands.empty(), "missing file isn't opened");
+        } else {
+            failures += check(loads[k].opened && loads[k].error == "" && loads[k].commands.size() == 1 && loads[k].commands[0].name == "c" + std::to_string(k), "file " + std::to_string(k) + " loads");
+        }
+    }
+    std::filesystem::remove_all(directory);
+
+    return failures == 0 ? 0 : 1;
+}
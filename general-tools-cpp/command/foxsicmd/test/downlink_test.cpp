@@ -0,0 +1,216 @@
+#include "downlink.h"
+#include "check.h"
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+
+// append `bytes` to `ring` the way a serial read does, through `write_space`; false if they don't all fit
+bool push(ByteRing& ring, const std::vector<uint8_t>& bytes) {
+    size_t done = 0;
+    while (done < bytes.size()) {
+        boost::asio::mutable_buffer space = ring.write_space();
+        size_t count = std::min(space.size(), bytes.size() - done);
+        if (count == 0) {
+            return false;
+        }
+        std::copy(bytes.begin() + done, bytes.begin() + done + count, static_cast<uint8_t*>(space.data()));
+        ring.commit(count);
+        done += count;
+    }
+    return true;
+}
+
+// take every complete frame out of `ring`, as `Downlink` does, counting resync skips in `skipped`
+std::vector<std::vector<uint8_t>> frames(Framer& framer, ByteRing& ring, size_t& skipped) {
+    std::vector<std::vector<uint8_t>> found;
+    while (ring.size() > 0) {
+        size_t skip = 0;
+        size_t length = framer.next(ring, skip);
+        if (skip > 0) {
+            ring.consume(skip);
+            skipped += skip;
+            continue;
+        }
+        if (length == 0) {
+            break;
+        }
+        found.emplace_back(length);
+        ring.copy(0, length, found.back().data());
+        ring.consume(length);
+    }
+    return found;
+}
+
+std::vector<uint8_t> text_bytes(const std::string& text) {
+    return std::vector<uint8_t>(text.begin(), text.end());
+}
+
+int check_ring() {
+    int failures = 0;
+    ByteRing ring(10);
+    failures += check(ring.capacity() == 16 && ring.size() == 0 && ring.free() == 16, "capacity rounds up to a power of two");
+
+    std::vector<uint8_t> first;
+    for (uint8_t k = 0; k < 12; ++k) {
+        first.push_back(k);
+    }
+    failures += check(push(ring, first) && ring.size() == 12 && ring.free() == 4, "fill");
+    ring.consume(10);
+    failures += check(ring.size() == 2 && ring.peek(0) == 10 && ring.peek(1) == 11, "consume");
+
+    // free space now runs to the end of the buffer, then wraps to the start:
+    failures += check(ring.write_space().size() == 4, "free space up to the end of the buffer");
+    std::vector<uint8_t> second = {20, 21, 22, 23, 24, 25, 26, 27};
+    failures += check(push(ring, second) && ring.size() == 10, "write across the wrap");
+    failures += check(ring.peek(2) == 20 && ring.peek(5) == 23 && ring.peek(6) == 24 && ring.peek(9) == 27, "peek across the wrap");
+    std::vector<uint8_t> copied(9);
+    ring.copy(1, 9, copied.data());
+    failures += check(copied == std::vector<uint8_t>({11, 20, 21, 22, 23, 24, 25, 26, 27}), "copy across the wrap");
+
+    std::vector<uint8_t> rest(6, 0xaa);
+    failures += check(push(ring, rest) && ring.free() == 0 && ring.write_space().size() == 0, "full ring has no free space");
+    failures += check(!push(ring, {0xbb}), "full ring takes nothing more");
+    ring.clear();
+    failures += check(ring.size() == 0 && ring.free() == 16, "clear");
+    return failures;
+}
+
+int check_specs() {
+    int failures = 0;
+    std::string error;
+    auto describe = [&](const std::string& spec) {
+        error = "";
+        auto framer = make_framer(spec, 64, error);
+        return framer ? framer->describe() : "error: " + error;
+    };
+    failures += check(describe("raw") == "raw", "raw spec");
+    failures += check(describe("fixed:4") == "fixed 4 bytes", "fixed spec");
+    failures += check(describe("fixed:0x10") == "fixed 16 bytes", "fixed spec in hex");
+    failures += check(describe("delim:0d0a") == "ending in 0x0d0a", "delimiter spec: " + describe("delim:0d0a"));
+    failures += check(describe("delim:0x0a") == "ending in 0x0a", "delimiter spec with 0x: " + describe("delim:0x0a"));
+    failures += check(describe("length:1,2") == "2-byte big-endian length at 1, 3-byte header", "length spec defaults");
+    failures += check(describe("length:0,1,le,2,-1") == "1-byte little-endian length at 0, 2-byte header, -1", "full length spec");
+
+    for (std::string bad: {"", "raw:1", "fixed", "fixed:0", "fixed:65", "fixed:4x", "delim", "delim:", "delim:zz", "length:0", "length:0,3", "length:-1,1", "length:0,2,xx", "length:2,2,be,3", "length:0,1,be,1,x", "length:0,1,be,1,0,0", "packet:4"}) {
+        error = "";
+        failures += check(!make_framer(bad, 64, error) && error != "", "bad spec \"" + bad + "\" is refused");
+    }
+    return failures;
+}
+
+int check_framing() {
+    int failures = 0;
+    std::string error;
+    size_t skipped = 0;
+
+    ByteRing ring(16);
+    auto fixed = make_framer("fixed:4", 64, error);
+    push(ring, {1, 2, 3, 4, 5, 6, 7, 8, 9, 10});
+    auto found = frames(*fixed, ring, skipped);
+    failures += check(found.size() == 2 && found[1] == std::vector<uint8_t>({5, 6, 7, 8}) && ring.size() == 2, "fixed frames, leaving the partial one");
+
+    // a delimiter split over two reads, with the frames wrapping around the ring:
+    ring.clear();
+    auto delimited = make_framer("delim:0d0a", 64, error);
+    push(ring, text_bytes("ab\r"));
+    failures += check(frames(*delimited, ring, skipped).empty(), "no frame before the delimiter is complete");
+    push(ring, text_bytes("\nxyz\r\nlong"));
+    found = frames(*delimited, ring, skipped);
+    failures += check(found.size() == 2 && found[0] == text_bytes("ab\r\n") && found[1] == text_bytes("xyz\r\n") && ring.size() == 4, "delimited frames include the delimiter");
+    push(ring, text_bytes("er\r\n"));
+    found = frames(*delimited, ring, skipped);
+    failures += check(found.size() == 1 && found[0] == text_bytes("longer\r\n"), "delimited frame across the wrap");
+
+    // big-endian length at 1 with a 3-byte header and a 1-byte checksum the length doesn't count:
+    ring.clear();
+    auto big = make_framer("length:1,2,be,3,1", 16, error);
+    push(ring, {0xeb, 0x00, 0x02, 0xa1, 0xa2, 0xcc, 0xeb, 0x00});
+    found = frames(*big, ring, skipped);
+    failures += check(found.size() == 1 && found[0] == std::vector<uint8_t>({0xeb, 0x00, 0x02, 0xa1, 0xa2, 0xcc}) && ring.size() == 2, "big-endian length frame");
+    push(ring, {0x01, 0xb1, 0xcd});
+    found = frames(*big, ring, skipped);
+    failures += check(found.size() == 1 && found[0].size() == 5 && ring.size() == 0, "length frame completed by a later read");
+
+    ring.clear();
+    auto little = make_framer("length:0,2,le", 16, error);
+    push(ring, {0x03, 0x00, 1, 2, 3});
+    found = frames(*little, ring, skipped);
+    failures += check(found.size() == 1 && found[0].size() == 5, "little-endian length frame");
+
+    // a length longer than any frame means the stream is out of sync: drop bytes until it makes sense again
+    ring.clear();
+    skipped = 0;
+    push(ring, {0xff, 0xff, 0x02, 0x00, 7, 8});
+    found = frames(*little, ring, skipped);
+    failures += check(skipped == 2 && found.size() == 1 && found[0] == std::vector<uint8_t>({0x02, 0x00, 7, 8}), "resync after an unbelievable length");
+
+    ring.clear();
+    auto raw = make_framer("raw", 64, error);
+    push(ring, {1, 2, 3});
+    found = frames(*raw, ring, skipped);
+    failures += check(found.size() == 1 && found[0].size() == 3, "raw frame is everything read");
+    return failures;
+}
+
+// feed a `Downlink` through a pseudo-terminal until the ring overflows, then check it resyncs
+int check_overflow() {
+    int failures = 0;
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        return check(false, "open a pseudo-terminal");
+    }
+    termios settings;
+    tcgetattr(master, &settings);
+    cfmakeraw(&settings);
+    tcsetattr(master, TCSANOW, &settings);
+
+    boost::asio::io_context context;
+    boost::asio::serial_port port(context, ptsname(master));
+    tcgetattr(port.native_handle(), &settings);
+    cfmakeraw(&settings);
+    tcsetattr(port.native_handle(), TCSANOW, &settings);
+
+    std::string error;
+    Downlink downlink(port, make_framer("delim:0a", 32, error), 32);
+    failures += check(downlink.start("", error), "downlink starts: " + error);
+    auto guard = boost::asio::make_work_guard(context);
+    std::thread io([&] { context.run(); });
+
+    auto send = [&](const std::string& text, uint64_t total) {
+        if (write(master, text.data(), text.size()) != ssize_t(text.size())) {
+            return false;
+        }
+        for (int k = 0; k < 200 && downlink.bytes_read.load() < total; ++k) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return downlink.bytes_read.load() == total;
+    };
+    failures += check(send(std::string(40, 'x'), 40), "noise read");
+    failures += check(downlink.overflowed.load() >= 32 && downlink.frames.load() == 0, "a full ring with no frame is dropped");
+    failures += check(send("ok\n", 43), "frame read");
+    auto recent = downlink.recent();
+    failures += check(!recent.empty() && recent.back().bytes.size() <= 32 && recent.back().bytes.back() == '\n', "frames are found again after an overflow");
+
+    downlink.stop();
+    guard.reset();
+    context.stop();
+    io.join();
+    close(master);
+    return failures;
+}
+
+/**
+ * @brief Check `ByteRing` wrapping and filling up, every `make_framer` spec (and bad ones), how each framer splits a stream, and that `Downlink` drops a ring that fills without a frame and then finds frames again.
+ */
+int main() {
+    int failures = 0;
+    failures += check_ring();
+    failures += check_specs();
+    failures += check_framing();
+    failures += check_overflow();
+    return failures == 0 ? 0 : 1;
+}
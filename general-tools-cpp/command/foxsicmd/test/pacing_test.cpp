@@ -0,0 +1,73 @@
+#include "pacing.h"
+#include "check.h"
+#include <string>
+
+/**
+ * @brief Check `Pacer`'s wire times for different UART framings, the link limit with and without a minimum gap, each system's token bucket (burst, refill, cap) and the counters, all on made-up clock times.
+ */
+int main() {
+    int failures = 0;
+    // any nonzero start time: the pacer treats 0 as "never"
+    const int64_t t0 = 1000000000;
+    const int64_t ms = 1000000;
+
+    UARTInfo uart("", 9600, 8, 1, 0);
+    PacingSettings settings;
+    Pacer plain(uart, settings);
+    failures += check(plain.bits_per_byte() == 10, "8N1 is 10 bits a byte");
+    failures += check(plain.wire_ns(2) == 2083333 && plain.wire_ns(0) == 0, "wire time at 9600 baud");
+    failures += check(Pacer(UARTInfo("", 115200, 8, 2, 1), settings).bits_per_byte() == 12, "8E2 is 12 bits a byte");
+    failures += check(Pacer(UARTInfo("", 0, 8, 1, 0), settings).wire_ns(100) == 0, "no wire time without a baud rate");
+
+    // the link: the next command waits for the previous one to clear the wire
+    failures += check(plain.ready_at(0x09, t0) == t0, "first command goes at once");
+    plain.commit(0x09, 2, t0, 0);
+    failures += check(plain.ready_at(0x02, t0) == t0 + 2083333, "next command waits for the wire, whatever its system");
+    failures += check(plain.ready_at(0x02, t0 + 3 * ms) == t0 + 3 * ms, "no wait once the wire is clear");
+    plain.commit(0x02, 4, t0 + 2083333, 2083333);
+    failures += check(plain.ready_at(0x09, t0 + 2083333) == t0 + 2083333 + 4166667, "waits queue up back to back");
+
+    settings.min_gap = 1 * ms;
+    Pacer gapped(uart, settings);
+    gapped.commit(0x09, 2, t0, 0);
+    failures += check(gapped.ready_at(0x09, t0) == t0 + 2083333 + 1 * ms, "minimum gap after the wire clears");
+
+    settings.enabled = false;
+    Pacer off(uart, settings);
+    off.commit(0x09, 2, t0, 0);
+    failures += check(off.ready_at(0x09, t0) == t0, "disabled pacer never waits");
+
+    // each system's bucket, with no link limit in the way: 10 commands a second, bursts of 2
+    PacingSettings bucket_settings;
+    bucket_settings.system_rate = 10;
+    bucket_settings.burst = 2;
+    Pacer bucket(UARTInfo("", 0, 8, 1, 0), bucket_settings);
+    for (int k = 0; k < 2; ++k) {
+        failures += check(bucket.ready_at(0x09, t0) == t0, "burst command " + std::to_string(k) + " goes at once");
+        bucket.commit(0x09, 2, t0, 0);
+    }
+    failures += check(bucket.ready_at(0x09, t0) == t0 + 100 * ms, "empty bucket waits one token");
+    failures += check(bucket.ready_at(0x02, t0) == t0, "other systems have their own bucket");
+    failures += check(bucket.ready_at(0x09, t0 + 50 * ms) == t0 + 100 * ms, "half a token earned, half still to wait");
+    bucket.commit(0x09, 2, t0 + 100 * ms, 100 * ms);
+    failures += check(bucket.ready_at(0x09, t0 + 100 * ms) == t0 + 200 * ms, "each token is spent");
+    bucket.commit(0x09, 2, t0 + 200 * ms, 0);
+
+    // a long quiet spell refills only up to the burst:
+    int64_t later = t0 + 10000 * ms;
+    for (int k = 0; k < 2; ++k) {
+        failures += check(bucket.ready_at(0x09, later) == later, "refilled burst command " + std::to_string(k));
+        bucket.commit(0x09, 2, later, 0);
+    }
+    failures += check(bucket.ready_at(0x09, later) == later + 100 * ms, "refill stops at the burst");
+
+    PacingStats stats = bucket.stats();
+    failures += check(stats.commands == 6 && stats.delayed == 1 && stats.total_delay == 100 * ms && stats.max_delay == 100 * ms, "delay counters");
+    failures += check(stats.throttled[0x09] == 1 && stats.throttled[0x02] == 0, "delay set by the bucket counts as throttled");
+    failures += check(stats.to_string() == "6 commands, 1 paced (mean 100.00 ms, max 100.00 ms), line 0% busy, throttled 0x09: 1", "summary line: " + stats.to_string());
+
+    stats = plain.stats();
+    failures += check(stats.commands == 2 && stats.busy == 2083333 + 4166667 && stats.elapsed == 2083333 + 4166667 && stats.throttled[0x02] == 0, "busy and elapsed line time");
+
+    return failures == 0 ? 0 : 1;
+}
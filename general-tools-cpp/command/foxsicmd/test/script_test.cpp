@@ -0,0 +1,88 @@
+#include "script.h"
+#include "check.h"
+#include <sstream>
+#include <string>
+#include <vector>
+
+// parse `text`, expecting it to fail with an error containing `expected`
+int check_error(const Deck& deck, std::string text, std::string expected) {
+    std::stringstream in(text);
+    std::vector<script::Step> steps;
+    std::string error;
+    bool ok = script::parse(in, deck, steps, error);
+    return check(!ok && error.find(expected) != std::string::npos, "\"" + text + "\" is refused with \"" + expected + "\": " + error);
+}
+
+/**
+ * @brief Check `script::parse_duration` and `script::parse`: names and hex codes, comments, repeats, `wait` and `at` timing, and every error, with its line number. Also check that `script::report` leaves unwritten sends out of the lateness summary.
+ */
+int main() {
+    int failures = 0;
+    int64_t ns = -1;
+
+    failures += check(script::parse_duration("250us", ns) && ns == 250000, "microseconds");
+    failures += check(script::parse_duration("1.5s", ns) && ns == 1500000000, "fractional seconds");
+    failures += check(script::parse_duration("10ms", ns) && ns == 10000000, "milliseconds");
+    failures += check(script::parse_duration("7ns", ns) && ns == 7, "nanoseconds");
+    failures += check(script::parse_duration("0", ns) && ns == 0, "bare zero");
+    for (std::string bad: {"", "5", "ms", "-1ms", "10 ms", "10min", "infs", "nanms"}) {
+        failures += check(!script::parse_duration(bad, ns), "\"" + bad + "\" isn't a duration");
+    }
+
+    std::vector<System> systems = {System(0x09, "cdte1", "spw"), System(0x02, "housekeeping", "uart")};
+    std::vector<std::vector<Command>> commands = {{Command(0x10, "start", 0, 0), Command(0x11, "stop", 0, 1)}, {Command(0x01, "reset", 0, 0)}};
+    Deck deck(systems, commands);
+
+    std::stringstream in(
+        "# warm up\n"
+        "send cdte1 start\n"
+        "\n"
+        "wait 2ms   # settle\n"
+        "send 0x02 0x01 repeat 3 every 500us\n"
+        "at 10ms\n"
+        "send housekeeping reset\n"
+        "send cdte1 0X11\n");
+    std::vector<script::Step> steps;
+    std::string error;
+    failures += check(script::parse(in, deck, steps, error), "script parses: " + error);
+    failures += check(steps.size() == 6, "repeats are expanded");
+    if (steps.size() == 6) {
+        failures += check(steps[0].line == 2 && steps[0].system == "cdte1" && steps[0].command == "start" && steps[0].offset == 0, "first send");
+        failures += check(steps[0].bytes == std::vector<uint8_t>({0x09, 0x10}), "system code then command code");
+        failures += check(steps[1].system == "housekeeping" && steps[1].command == "reset" && steps[1].line == 5, "hex codes resolve to names");
+        failures += check(steps[1].offset == 2000000 && steps[2].offset == 2500000 && steps[3].offset == 3000000, "wait, then repeat every");
+        failures += check(steps[4].offset == 10000000 && steps[4].line == 7, "at is from the start of the script");
+        failures += check(steps[5].offset == 10000000 && steps[5].command == "stop", "a send without a wait goes at the same time");
+    }
+
+    std::stringstream empty("# nothing\n\n");
+    failures += check(script::parse(empty, deck, steps, error) && steps.empty(), "empty script");
+
+    failures += check_error(deck, "send cdte1", "line 1: send needs a system and a command");
+    failures += check_error(deck, "\nsend nope start", "line 2: no system nope");
+    failures += check_error(deck, "send cdte1 reset", "no command reset for cdte1");
+    failures += check_error(deck, "send 0x7f 0x01", "no system 0x7f");
+    failures += check_error(deck, "send cdte1 start repeat 0", "repeat needs a count of at least 1");
+    failures += check_error(deck, "send cdte1 start repeat two", "repeat needs a count");
+    failures += check_error(deck, "send cdte1 start every", "every needs a value");
+    failures += check_error(deck, "send cdte1 start every 5", "every needs a duration");
+    failures += check_error(deck, "send cdte1 start after 5ms", "unknown option after");
+    failures += check_error(deck, "wait", "wait needs one duration");
+    failures += check_error(deck, "wait 1ms 2ms", "wait needs one duration");
+    failures += check_error(deck, "at 1s\nat 500ms", "line 2: at 500ms is before the previous send");
+    failures += check_error(deck, "sleep 1s", "unknown instruction sleep");
+
+    // a send that never went out has no start time, so it isn't counted as late:
+    std::vector<script::Result> results(2);
+    results[0].scheduled = 1000;
+    results[0].record.id = 1;
+    results[0].record.started = 3000;
+    results[0].record.ok = true;
+    results[1].scheduled = 2000;
+    results[1].record.error = "not written";
+    std::string report = script::report(results);
+    failures += check(report.find("# 2 sends, 1 failed.") != std::string::npos, "report counts the unwritten send as failed");
+    failures += check(report.find("mean 2.0, median 2.0, p99 2.0, max 2.0") != std::string::npos, "lateness leaves out the unwritten send: " + report);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,149 @@
+#include "alarm.h"
+#include "timestamp.h"
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <iomanip>
+
+// limits with every check disabled
+static AlarmLimit unlimited() {
+    double inf = std::numeric_limits<double>::infinity();
+    return AlarmLimit{-inf, -inf, inf, inf, 0.0, 1};
+}
+
+// read any limits present in `node` over the top of `base`
+static AlarmLimit read_limit(const boost::property_tree::ptree& node, AlarmLimit base) {
+    base.red_low = node.get<double>("red_low", base.red_low);
+    base.yellow_low = node.get<double>("yellow_low", base.yellow_low);
+    base.yellow_high = node.get<double>("yellow_high", base.yellow_high);
+    base.red_high = node.get<double>("red_high", base.red_high);
+    base.hysteresis = node.get<double>("hysteresis", base.hysteresis);
+    base.persistence = std::max<uint32_t>(1, node.get<uint32_t>("persistence", base.persistence));
+    return base;
+}
+
+std::string alarm_level_name(AlarmLevel level) {
+    switch (level) {
+        case AlarmLevel::nominal:
+            return "nominal";
+        case AlarmLevel::yellow:
+            return "yellow";
+        case AlarmLevel::red:
+            return "red";
+    }
+    return "unknown";
+}
+
+AlarmEngine::AlarmEngine(std::vector<std::string> names, std::string log_path):
+        names(names),
+        events(64),
+        limits(names.size(), unlimited()),
+        states(names.size(), AlarmState{AlarmLevel::nominal, AlarmLevel::nominal, 0})
+{
+    if (log_path != "") {
+        log_file.open(log_path, std::ios::out | std::ios::app);
+    }
+}
+
+bool AlarmEngine::load(const std::string& path, std::string& error) {
+    boost::property_tree::ptree root;
+    try {
+        boost::property_tree::read_json(path, root);
+    } catch (std::exception& e) {
+        error = e.what();
+        return false;
+    }
+
+    std::vector<AlarmLimit> loaded(names.size(), unlimited());
+    try {
+        AlarmLimit base = unlimited();
+        auto defaults = root.get_child_optional("default");
+        if (defaults) {
+            base = read_limit(*defaults, base);
+        }
+        std::fill(loaded.begin(), loaded.end(), base);
+
+        auto channels = root.get_child_optional("channels");
+        if (channels) {
+            for (auto& entry: *channels) {
+                std::string name = entry.second.get<std::string>("name");
+                auto found = std::find(names.begin(), names.end(), name);
+                if (found == names.end()) {
+                    error = "unknown channel in alarm file: " + name;
+                    return false;
+                }
+                loaded[found - names.begin()] = read_limit(entry.second, base);
+            }
+        }
+    } catch (std::exception& e) {
+        error = e.what();
+        return false;
+    }
+
+    limits = loaded;
+    return true;
+}
+
+AlarmLevel AlarmEngine::check(size_t channel, double value) {
+    const AlarmLimit& l = limits[channel];
+    AlarmState& s = states[channel];
+
+    // level against the limits as given, and against the limits pulled in by the hysteresis band:
+    int entered = ((value < l.yellow_low) | (value > l.yellow_high)) + ((value < l.red_low) | (value > l.red_high));
+    int held = ((value < l.yellow_low + l.hysteresis) | (value > l.yellow_high - l.hysteresis))
+        + ((value < l.red_low + l.hysteresis) | (value > l.red_high - l.hysteresis));
+    // escalate as soon as a limit is crossed, but only step down once clear of the hysteresis band:
+    int current = static_cast<int>(s.level);
+    AlarmLevel target = static_cast<AlarmLevel>(std::max(entered, std::min(current, held)));
+
+    if (target == s.level) {
+        s.count = 0;
+        return s.level;
+    }
+    if (target != s.candidate) {
+        s.candidate = target;
+        s.count = 0;
+    }
+    if (++s.count < l.persistence) {
+        return s.level;
+    }
+
+    AlarmEvent event{std::chrono::system_clock::now(), channel, s.level, target, value};
+    s.level = target;
+    s.count = 0;
+    events.push(event);
+    if (log_file.is_open()) {
+        log_file << describe(event) << "\n";
+        log_file.flush();
+    }
+    if (on_event) {
+        on_event(event);
+    }
+    return s.level;
+}
+
+AlarmLevel AlarmEngine::level(size_t channel) const {
+    return states[channel].level;
+}
+
+const AlarmLimit& AlarmEngine::limit(size_t channel) const {
+    return limits[channel];
+}
+
+AlarmLevel AlarmEngine::worst() const {
+    AlarmLevel result = AlarmLevel::nominal;
+    for (auto& s: states) {
+        result = std::max(result, s.level);
+    }
+    return result;
+}
+
+std::string AlarmEngine::describe(const AlarmEvent& event) const {
+    std::stringstream result;
+    result << format_time(event.time) << " " << names[event.channel] << ": ";
+    result << alarm_level_name(event.from) << " -> " << alarm_level_name(event.to);
+    result << " (" << std::fixed << std::setprecision(3) << event.value << ")";
+    return result.str();
+}
@@ -0,0 +1,139 @@
+#pragma once
+#ifndef ALARM_H
+#define ALARM_H
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <cstdint>
+#include "ring.h"
+
+/**
+ * @brief Alarm severity for a channel. Ordered, so levels can be compared and combined with `std::max`.
+ */
+enum class AlarmLevel: uint8_t {
+    nominal = 0,
+    yellow = 1,
+    red = 2
+};
+
+/**
+ * @brief Limits and debouncing settings for one channel.
+ *
+ * A value outside `[yellow_low, yellow_high]` is yellow, outside `[red_low, red_high]` is red. To return to a lower level, the value must come back inside the limits by at least `hysteresis`. A level change only takes effect after `persistence` consecutive samples agree on it.
+ */
+struct AlarmLimit {
+    double red_low;
+    double yellow_low;
+    double yellow_high;
+    double red_high;
+    double hysteresis;
+    uint32_t persistence;
+};
+
+/**
+ * @brief A change in alarm level for one channel.
+ */
+struct AlarmEvent {
+    std::chrono::system_clock::time_point time;
+    size_t channel;
+    AlarmLevel from;
+    AlarmLevel to;
+    double value;
+};
+
+/**
+ * @brief Table-driven limit checking for a set of channels.
+ *
+ * Limits are loaded from a JSON file into a flat array indexed by channel, so checking a sample is a handful of comparisons and no lookups. Level changes are kept in a short in-memory event list and appended to an event log file.
+ *
+ * The JSON file looks like this. Channels are matched by name; `default` applies to any channel not listed, and any limit left out is disabled:
+ * ```json
+ * {
+ *     "default": {"hysteresis": 0.0, "persistence": 1},
+ *     "channels": [
+ *         {"name": "28 V", "red_low": 24.0, "yellow_low": 26.0, "yellow_high": 30.0, "red_high": 32.0, "hysteresis": 0.2, "persistence": 3}
+ *     ]
+ * }
+ * ```
+ */
+class AlarmEngine {
+    public:
+        /**
+         * @brief Construct a new AlarmEngine object with every limit disabled.
+         *
+         * @param names name of each channel, matched against the `name` field in the JSON file.
+         * @param log_path file to append alarm events to. Empty to disable the event log.
+         */
+        AlarmEngine(std::vector<std::string> names, std::string log_path);
+
+        /**
+         * @brief Load limits from a JSON file, replacing the current ones.
+         *
+         * @param path the JSON file to read.
+         * @param error set to a description of the problem if loading fails.
+         * @return true if the file was loaded.
+         * @return false if the file couldn't be read or parsed. Current limits are kept.
+         */
+        bool load(const std::string& path, std::string& error);
+
+        /**
+         * @brief Check a new sample for one channel, updating its alarm level.
+         *
+         * @param channel index into `::names`.
+         * @param value the sample value.
+         * @return AlarmLevel the channel's level after this sample.
+         */
+        AlarmLevel check(size_t channel, double value);
+
+        /**
+         * @brief The current alarm level of `channel`.
+         */
+        AlarmLevel level(size_t channel) const;
+        /**
+         * @brief The highest current alarm level of any channel.
+         */
+        AlarmLevel worst() const;
+        /**
+         * @brief The limits in use for `channel`, disabled (infinite) if none were loaded for it.
+         */
+        const AlarmLimit& limit(size_t channel) const;
+
+        /**
+         * @brief Format an event for display or logging.
+         */
+        std::string describe(const AlarmEvent& event) const;
+
+        std::vector<std::string> names;
+        /**
+         * @brief Most recent alarm level changes, oldest first.
+         */
+        RingBuffer<AlarmEvent> events;
+        /**
+         * @brief Called with each level change as it happens, on the thread calling `::check`. Empty by default.
+         */
+        std::function<void(const AlarmEvent&)> on_event;
+
+    private:
+        /**
+         * @brief Per-channel debouncing state.
+         */
+        struct AlarmState {
+            AlarmLevel level;
+            AlarmLevel candidate;
+            uint32_t count;
+        };
+
+        std::vector<AlarmLimit> limits;
+        std::vector<AlarmState> states;
+        std::ofstream log_file;
+};
+
+/**
+ * @brief Short name for an alarm level.
+ */
+std::string alarm_level_name(AlarmLevel level);
+
+#endif
@@ -0,0 +1,472 @@
+#include "attach.h"
+#include "timestamp.h"
+#include <cstring>
+#include <cmath>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+template <typename T>
+static void append(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static T take(const std::string& in, size_t offset) {
+    T value;
+    std::memcpy(&value, in.data() + offset, sizeof(T));
+    return value;
+}
+
+static void append_name(std::string& out, const std::string& name) {
+    std::string padded = name.substr(0, attach_protocol::name_size - 1);
+    padded.resize(attach_protocol::name_size, '\0');
+    out += padded;
+}
+
+static std::string take_name(const std::string& in, size_t offset) {
+    const char* text = in.data() + offset;
+    return std::string(text, strnlen(text, attach_protocol::name_size));
+}
+
+static std::shared_ptr<const std::string> make_frame(attach_protocol::Type type, const std::string& payload) {
+    auto out = std::make_shared<std::string>();
+    out->reserve(attach_protocol::header_size + payload.size());
+    append<uint32_t>(*out, static_cast<uint32_t>(payload.size()));
+    append<uint8_t>(*out, static_cast<uint8_t>(type));
+    *out += payload;
+    return out;
+}
+
+/**
+ * @brief One attached client, kept alive by the handlers that reference it.
+ */
+struct AttachServer::Session {
+    Session(boost::asio::local::stream_protocol::socket socket): socket(std::move(socket)), id(0), writing(false) {}
+    boost::asio::local::stream_protocol::socket socket;
+    uint64_t id;
+    std::deque<std::shared_ptr<const std::string>> queue;
+    bool writing;
+    std::array<char, attach_protocol::header_size> header;
+    std::string payload;
+};
+
+AttachServer::AttachServer(std::string node, std::vector<std::string> names):
+        clients(0),
+        dropped(0),
+        node(node),
+        names(names),
+        running(false),
+        sample_count(0),
+        socket_device(0),
+        socket_inode(0),
+        acceptor(context),
+        next_session(1) {}
+
+AttachServer::~AttachServer() {
+    stop();
+}
+
+bool AttachServer::start(std::string path, std::string& error) {
+    try {
+        boost::asio::local::stream_protocol::endpoint endpoint(path);
+        // a socket file left behind by a process that didn't exit cleanly would make bind fail, so remove it, but only if nothing is serving on it:
+        boost::system::error_code probe_error;
+        boost::asio::local::stream_protocol::socket probe(context);
+        probe.connect(endpoint, probe_error);
+        if (!probe_error) {
+            error = path + ": already in use";
+            return false;
+        }
+        if (probe_error == boost::asio::error::connection_refused) {
+            ::unlink(path.c_str());
+        } else if (probe_error != boost::system::errc::no_such_file_or_directory) {
+            error = path + ": " + probe_error.message();
+            return false;
+        }
+        acceptor.open(endpoint.protocol());
+        acceptor.bind(endpoint);
+        acceptor.listen();
+    } catch (std::exception& e) {
+        error = path + ": " + e.what();
+        if (acceptor.is_open()) {
+            acceptor.close();
+        }
+        return false;
+    }
+    this->path = path;
+    struct stat info;
+    if (::stat(path.c_str(), &info) == 0) {
+        socket_device = info.st_dev;
+        socket_inode = info.st_ino;
+    }
+
+    const TimeAnchor& anchor = session_anchor();
+    std::string payload;
+    append<uint32_t>(payload, attach_protocol::version);
+    append<uint32_t>(payload, static_cast<uint32_t>(names.size()));
+    append<int64_t>(payload, anchor.steady);
+    append<int64_t>(payload, std::chrono::duration_cast<std::chrono::nanoseconds>(anchor.wall.time_since_epoch()).count());
+    append_name(payload, node);
+    for (auto& name: names) {
+        append_name(payload, name);
+    }
+    hello = make_frame(attach_protocol::Type::hello, payload);
+
+    accept();
+    running.store(true, std::memory_order_relaxed);
+    thread = std::thread([this] { context.run(); });
+    return true;
+}
+
+void AttachServer::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+    context.stop();
+    if (thread.joinable()) {
+        thread.join();
+    }
+    boost::system::error_code ignored;
+    acceptor.close(ignored);
+    for (auto& entry: sessions) {
+        entry.second->socket.close(ignored);
+    }
+    sessions.clear();
+    clients.store(0);
+    // another server may have replaced the file since (after deciding ours was stale); leave theirs alone.
+    struct stat info;
+    if (::stat(path.c_str(), &info) == 0 && info.st_dev == socket_device && info.st_ino == socket_inode) {
+        ::unlink(path.c_str());
+    }
+}
+
+void AttachServer::accept() {
+    acceptor.async_accept([this](const boost::system::error_code& err, boost::asio::local::stream_protocol::socket peer) {
+        if (err) {
+            return;
+        }
+        auto session = std::make_shared<Session>(std::move(peer));
+        session->id = next_session++;
+        sessions[session->id] = session;
+        clients.store(sessions.size());
+
+        // catch the new client up: who we are, what has alarmed recently, and where things stand now.
+        send(session, hello);
+        for (auto& alarm: recent_alarms) {
+            send(session, alarm);
+        }
+        if (last_sample) {
+            send(session, last_sample);
+        }
+        read_header(session);
+        accept();
+    });
+}
+
+void AttachServer::read_header(std::shared_ptr<Session> session) {
+    boost::asio::async_read(session->socket, boost::asio::buffer(session->header), [this, session](const boost::system::error_code& err, size_t) {
+        if (err) {
+            close(session, false);
+            return;
+        }
+        uint32_t length;
+        std::memcpy(&length, session->header.data(), sizeof(length));
+        auto type = static_cast<attach_protocol::Type>(session->header[4]);
+        if (type != attach_protocol::Type::command || length < sizeof(uint32_t) || length > attach_protocol::max_payload) {
+            close(session, true);
+            return;
+        }
+        session->payload.resize(length);
+        boost::asio::async_read(session->socket, boost::asio::buffer(session->payload), [this, session](const boost::system::error_code& err, size_t) {
+            if (err) {
+                close(session, false);
+                return;
+            }
+            AttachCommand command;
+            command.client = session->id;
+            command.id = take<uint32_t>(session->payload, 0);
+            command.bytes.assign(session->payload.begin() + sizeof(uint32_t), session->payload.end());
+            {
+                std::lock_guard<std::mutex> lock(command_mutex);
+                commands.push_back(command);
+            }
+            read_header(session);
+        });
+    });
+}
+
+void AttachServer::send(std::shared_ptr<Session> session, std::shared_ptr<const std::string> frame) {
+    if (session->queue.size() >= max_queued) {
+        close(session, true);
+        return;
+    }
+    session->queue.push_back(frame);
+    if (!session->writing) {
+        write_next(session);
+    }
+}
+
+void AttachServer::write_next(std::shared_ptr<Session> session) {
+    if (session->queue.empty()) {
+        session->writing = false;
+        return;
+    }
+    session->writing = true;
+    boost::asio::async_write(session->socket, boost::asio::buffer(*session->queue.front()), [this, session](const boost::system::error_code& err, size_t) {
+        if (err) {
+            close(session, false);
+            return;
+        }
+        session->queue.pop_front();
+        write_next(session);
+    });
+}
+
+void AttachServer::close(std::shared_ptr<Session> session, bool misbehaved) {
+    if (sessions.erase(session->id) == 0) {
+        return;
+    }
+    boost::system::error_code ignored;
+    session->socket.close(ignored);
+    session->queue.clear();
+    clients.store(sessions.size());
+    if (misbehaved) {
+        dropped.fetch_add(1);
+    }
+}
+
+void AttachServer::broadcast(std::shared_ptr<const std::string> frame) {
+    // `send` may close (and erase) a session, so don't iterate the map itself:
+    std::vector<std::shared_ptr<Session>> targets;
+    for (auto& entry: sessions) {
+        targets.push_back(entry.second);
+    }
+    for (auto& session: targets) {
+        send(session, frame);
+    }
+}
+
+void AttachServer::publish_sample(int64_t time, const std::vector<double>& values, const std::vector<AlarmLevel>& levels) {
+    if (!is_open()) {
+        return;
+    }
+    std::string payload;
+    payload.reserve(16 + names.size() * (sizeof(double) + 1));
+    append<int64_t>(payload, time);
+    append<uint64_t>(payload, sample_count++);
+    for (size_t k = 0; k < names.size(); ++k) {
+        append<double>(payload, k < values.size() ? values[k] : std::nan(""));
+    }
+    for (size_t k = 0; k < names.size(); ++k) {
+        append<uint8_t>(payload, static_cast<uint8_t>(k < levels.size() ? levels[k] : AlarmLevel::nominal));
+    }
+    auto frame = make_frame(attach_protocol::Type::sample, payload);
+    boost::asio::post(context, [this, frame] {
+        last_sample = frame;
+        broadcast(frame);
+    });
+}
+
+void AttachServer::publish_alarm(const AlarmEvent& event) {
+    if (!is_open()) {
+        return;
+    }
+    std::string payload;
+    append<int64_t>(payload, std::chrono::duration_cast<std::chrono::nanoseconds>(event.time.time_since_epoch()).count());
+    append<uint32_t>(payload, static_cast<uint32_t>(event.channel));
+    append<uint8_t>(payload, static_cast<uint8_t>(event.from));
+    append<uint8_t>(payload, static_cast<uint8_t>(event.to));
+    append<double>(payload, event.value);
+    auto frame = make_frame(attach_protocol::Type::alarm, payload);
+    boost::asio::post(context, [this, frame] {
+        recent_alarms.push_back(frame);
+        if (recent_alarms.size() > replayed_alarms) {
+            recent_alarms.pop_front();
+        }
+        broadcast(frame);
+    });
+}
+
+bool AttachServer::next_command(AttachCommand& out) {
+    std::lock_guard<std::mutex> lock(command_mutex);
+    if (commands.empty()) {
+        return false;
+    }
+    out = std::move(commands.front());
+    commands.pop_front();
+    return true;
+}
+
+void AttachServer::reply(const AttachCommand& command, attach_protocol::Status status, std::string message) {
+    if (!is_open()) {
+        return;
+    }
+    std::string payload;
+    append<uint32_t>(payload, command.id);
+    append<uint8_t>(payload, static_cast<uint8_t>(status));
+    payload += message;
+    auto frame = make_frame(attach_protocol::Type::result, payload);
+    uint64_t client = command.client;
+    boost::asio::post(context, [this, frame, client] {
+        auto found = sessions.find(client);
+        if (found != sessions.end()) {
+            send(found->second, frame);
+        }
+    });
+}
+
+AttachClient::AttachClient(): socket(context), next_id(1) {}
+
+AttachClient::~AttachClient() {
+    detach();
+}
+
+bool AttachClient::attach(std::string path, std::string& error) {
+    boost::system::error_code err;
+    socket.connect(boost::asio::local::stream_protocol::endpoint(path), err);
+    if (err) {
+        error = path + ": " + err.message();
+        return false;
+    }
+    attach_protocol::Type type;
+    std::string payload;
+    if (!read_frame(type, payload) || type != attach_protocol::Type::hello || payload.size() < 8 || take<uint32_t>(payload, 0) != attach_protocol::version) {
+        error = path + " didn't say hello with protocol version " + std::to_string(attach_protocol::version);
+        socket.close(err);
+        return false;
+    }
+    apply(type, payload);
+    thread = std::thread([this] { receive(); });
+    return true;
+}
+
+void AttachClient::detach() {
+    if (!socket.is_open()) {
+        return;
+    }
+    // wakes the receiving thread from its blocking read:
+    ::shutdown(socket.native_handle(), SHUT_RDWR);
+    if (thread.joinable()) {
+        thread.join();
+    }
+    boost::system::error_code ignored;
+    socket.close(ignored);
+}
+
+uint32_t AttachClient::command(const std::vector<uint8_t>& bytes) {
+    std::lock_guard<std::mutex> lock(write_mutex);
+    uint32_t id = next_id++;
+    std::string payload;
+    append<uint32_t>(payload, id);
+    payload.append(bytes.begin(), bytes.end());
+    auto frame = make_frame(attach_protocol::Type::command, payload);
+    boost::system::error_code err;
+    boost::asio::write(socket, boost::asio::buffer(*frame), err);
+    return err ? 0 : id;
+}
+
+AttachState AttachClient::snapshot() {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    return state;
+}
+
+bool AttachClient::read_frame(attach_protocol::Type& type, std::string& payload) {
+    std::array<char, attach_protocol::header_size> header;
+    boost::system::error_code err;
+    boost::asio::read(socket, boost::asio::buffer(header), err);
+    if (err) {
+        return false;
+    }
+    uint32_t length;
+    std::memcpy(&length, header.data(), sizeof(length));
+    if (length > attach_protocol::max_payload) {
+        return false;
+    }
+    type = static_cast<attach_protocol::Type>(header[4]);
+    payload.resize(length);
+    boost::asio::read(socket, boost::asio::buffer(payload), err);
+    return !err;
+}
+
+void AttachClient::receive() {
+    attach_protocol::Type type;
+    std::string payload;
+    while (read_frame(type, payload)) {
+        apply(type, payload);
+        if (on_update) {
+            on_update();
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        state.connected = false;
+    }
+    if (on_update) {
+        on_update();
+    }
+}
+
+void AttachClient::apply(attach_protocol::Type type, const std::string& payload) {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    size_t n = state.names.size();
+    switch (type) {
+        case attach_protocol::Type::hello: {
+            size_t count = take<uint32_t>(payload, 4);
+            size_t names_offset = 24 + attach_protocol::name_size;
+            if (payload.size() < names_offset + count * attach_protocol::name_size) {
+                return;
+            }
+            state.node = take_name(payload, 24);
+            state.names.clear();
+            for (size_t k = 0; k < count; ++k) {
+                state.names.push_back(take_name(payload, names_offset + k * attach_protocol::name_size));
+            }
+            state.values.assign(count, std::nan(""));
+            state.levels.assign(count, AlarmLevel::nominal);
+            state.connected = true;
+            break;
+        }
+        case attach_protocol::Type::sample: {
+            if (payload.size() < 16 + n * (sizeof(double) + 1)) {
+                return;
+            }
+            state.time = take<int64_t>(payload, 0);
+            state.index = take<uint64_t>(payload, 8);
+            for (size_t k = 0; k < n; ++k) {
+                state.values[k] = take<double>(payload, 16 + k * sizeof(double));
+                state.levels[k] = static_cast<AlarmLevel>(take<uint8_t>(payload, 16 + n * sizeof(double) + k));
+            }
+            ++state.samples;
+            break;
+        }
+        case attach_protocol::Type::alarm: {
+            if (payload.size() < 22) {
+                return;
+            }
+            AlarmEvent event;
+            event.time = std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(take<int64_t>(payload, 0))));
+            event.channel = take<uint32_t>(payload, 8);
+            event.from = static_cast<AlarmLevel>(take<uint8_t>(payload, 12));
+            event.to = static_cast<AlarmLevel>(take<uint8_t>(payload, 13));
+            event.value = take<double>(payload, 14);
+            state.alarms.push_back(event);
+            if (state.alarms.size() > AttachServer::replayed_alarms) {
+                state.alarms.pop_front();
+            }
+            break;
+        }
+        case attach_protocol::Type::result: {
+            if (payload.size() < 5) {
+                return;
+            }
+            auto status = static_cast<attach_protocol::Status>(take<uint8_t>(payload, 4));
+            std::string label = status == attach_protocol::Status::sent ? "sent" : status == attach_protocol::Status::rejected ? "rejected" : "failed";
+            std::string message = payload.substr(5);
+            state.last_result = "#" + std::to_string(take<uint32_t>(payload, 0)) + " " + label + (message.empty() ? "" : ": " + message);
+            break;
+        }
+        default:
+            break;
+    }
+}
@@ -0,0 +1,259 @@
+#pragma once
+#ifndef ATTACH_H
+#define ATTACH_H
+
+#include <boost/asio.hpp>
+#include "alarm.h"
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <functional>
+#include <cstdint>
+#include <sys/types.h>
+
+/**
+ * @brief Wire format between an acquisition daemon (`AttachServer`) and its UI clients (`AttachClient`), version 1.
+ *
+ * Both ends are on the same machine, so integers and doubles are in native byte order. Every message is a frame:
+ * | offset | type        | field                                              |
+ * |--------|-------------|----------------------------------------------------|
+ * | 0      | uint32      | payload length `p`, not counting these 5 bytes     |
+ * | 4      | uint8       | message type                                       |
+ * | 5      | byte[p]     | payload                                            |
+ *
+ * Payloads, by message type:
+ * | type        | from   | payload                                                                                     |
+ * |-------------|--------|---------------------------------------------------------------------------------------------|
+ * | 1 hello     | server | uint32 version, uint32 channel count `n`, int64 anchor steady ns, int64 anchor Unix ns, char[32] node name, `n` × char[32] channel names |
+ * | 2 sample    | server | int64 steady ns, uint64 sample number, `n` × double value, `n` × uint8 alarm level            |
+ * | 3 alarm     | server | int64 Unix ns, uint32 channel, uint8 from level, uint8 to level, double value               |
+ * | 4 command   | client | uint32 request ID (chosen by the client), then the raw bytes to send to the board            |
+ * | 5 result    | server | uint32 request ID, uint8 `attach_protocol::Status`, then a UTF-8 message                     |
+ *
+ * On connecting, a client gets the hello, the most recent alarms, then the latest sample, and after that every new sample and alarm as they happen. Names are NUL-padded.
+ */
+namespace attach_protocol {
+    static constexpr uint32_t version = 1;
+    static constexpr size_t header_size = 5;
+    static constexpr size_t name_size = 32;
+    /**
+     * @brief Largest payload either end accepts; anything longer is a protocol error and closes the connection.
+     */
+    static constexpr uint32_t max_payload = 1 << 20;
+
+    enum class Type: uint8_t {
+        hello = 1,
+        sample = 2,
+        alarm = 3,
+        command = 4,
+        result = 5
+    };
+
+    enum class Status: uint8_t {
+        sent = 0,
+        rejected = 1,
+        failed = 2
+    };
+};
+
+/**
+ * @brief A command received from a client, waiting to be run by the acquisition thread.
+ */
+struct AttachCommand {
+    uint64_t client;
+    uint32_t id;
+    std::vector<uint8_t> bytes;
+};
+
+/**
+ * @brief Serves decoded samples and alarms from one acquisition process to any number of local UI clients over a Unix-domain socket, and collects their commands.
+ *
+ * The server runs its own `io_context` on its own thread, like `MetricsServer`. Publishing encodes a frame once and hands it to that thread, so the polling thread never waits on a client, and board load doesn't depend on how many clients are attached. A client that falls more than `::max_queued` frames behind is disconnected rather than buffered without limit.
+ *
+ * Commands from every client go into one queue that the acquisition thread drains with `::next_command` (between polls), so they reach the board one at a time, in the order they arrived. The protocol is documented in `attach_protocol`.
+ */
+class AttachServer {
+    public:
+        static constexpr size_t max_queued = 256;
+        static constexpr size_t replayed_alarms = 64;
+
+        /**
+         * @brief Construct a new AttachServer object. Nothing is served until `::start` succeeds; publishing before then does nothing.
+         *
+         * @param node name of the acquisition node, sent to clients.
+         * @param names name of each channel, sent to clients.
+         */
+        AttachServer(std::string node, std::vector<std::string> names);
+        ~AttachServer();
+
+        /**
+         * @brief Listen on the Unix-domain socket `path` and start serving. A stale socket file at `path` (one nothing accepts connections on) is replaced.
+         *
+         * @param error set to a description of the problem if listening failed, including "already in use" if another server is live on `path`.
+         * @return true if the server is running.
+         */
+        bool start(std::string path, std::string& error);
+        /**
+         * @brief Disconnect every client, stop serving, and remove the socket file.
+         */
+        void stop();
+        /**
+         * @brief Check whether the server is running.
+         */
+        bool is_open() const { return running.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Send a sample to every client. Samples are numbered in the order they're published, so publish them from one thread.
+         *
+         * @param time sample time, in `steady_clock` nanoseconds (see `steady_ns`).
+         * @param values one value per channel, NaN where there is none.
+         * @param levels current alarm level of each channel.
+         */
+        void publish_sample(int64_t time, const std::vector<double>& values, const std::vector<AlarmLevel>& levels);
+        /**
+         * @brief Send an alarm level change to every client.
+         */
+        void publish_alarm(const AlarmEvent& event);
+
+        /**
+         * @brief Take the oldest waiting command, if there is one.
+         *
+         * @return false if no command is waiting.
+         */
+        bool next_command(AttachCommand& out);
+        /**
+         * @brief Tell the client that sent `command` what happened to it.
+         */
+        void reply(const AttachCommand& command, attach_protocol::Status status, std::string message);
+
+        /**
+         * @brief Number of clients attached.
+         */
+        std::atomic<uint64_t> clients;
+        /**
+         * @brief Number of clients disconnected for falling behind or breaking the protocol.
+         */
+        std::atomic<uint64_t> dropped;
+        /**
+         * @brief Path of the socket being served, or empty.
+         */
+        std::string path;
+
+    private:
+        struct Session;
+
+        void accept();
+        void read_header(std::shared_ptr<Session> session);
+        void send(std::shared_ptr<Session> session, std::shared_ptr<const std::string> frame);
+        void write_next(std::shared_ptr<Session> session);
+        void close(std::shared_ptr<Session> session, bool misbehaved);
+        void broadcast(std::shared_ptr<const std::string> frame);
+
+        std::string node;
+        std::vector<std::string> names;
+        std::atomic<bool> running;
+        uint64_t sample_count;
+        // identity of the socket file bound by `::start`, so `::stop` only removes it if it's still ours
+        dev_t socket_device;
+        ino_t socket_inode;
+
+        boost::asio::io_context context;
+        boost::asio::local::stream_protocol::acceptor acceptor;
+        std::thread thread;
+
+        // only touched on the server thread:
+        std::map<uint64_t, std::shared_ptr<Session>> sessions;
+        uint64_t next_session;
+        std::shared_ptr<const std::string> hello;
+        std::shared_ptr<const std::string> last_sample;
+        std::deque<std::shared_ptr<const std::string>> recent_alarms;
+
+        std::mutex command_mutex;
+        std::deque<AttachCommand> commands;
+};
+
+/**
+ * @brief What a client knows about the acquisition node, copied out by `AttachClient::snapshot`.
+ */
+struct AttachState {
+    bool connected = false;
+    std::string node;
+    std::vector<std::string> names;
+
+    /**
+     * @brief Samples received since attaching.
+     */
+    uint64_t samples = 0;
+    uint64_t index = 0;
+    int64_t time = 0;
+    std::vector<double> values;
+    std::vector<AlarmLevel> levels;
+
+    /**
+     * @brief Recent alarm level changes, oldest first.
+     */
+    std::deque<AlarmEvent> alarms;
+    /**
+     * @brief Result of the most recent command, like "#3 sent".
+     */
+    std::string last_result;
+};
+
+/**
+ * @brief Attaches to an `AttachServer`, keeping an up-to-date copy of its latest sample and alarms and sending commands to it.
+ */
+class AttachClient {
+    public:
+        AttachClient();
+        ~AttachClient();
+
+        /**
+         * @brief Connect to the server at `path`, wait for its hello, and start receiving in the background.
+         *
+         * @param error set to a description of the problem if attaching failed.
+         * @return true if attached.
+         */
+        bool attach(std::string path, std::string& error);
+        /**
+         * @brief Disconnect and stop the receiving thread.
+         */
+        void detach();
+
+        /**
+         * @brief Ask the server to send `bytes` to the board. The outcome arrives later, in `AttachState::last_result`.
+         *
+         * @return the request ID, or 0 if the command couldn't be sent to the server.
+         */
+        uint32_t command(const std::vector<uint8_t>& bytes);
+
+        /**
+         * @brief Copy of everything received so far.
+         */
+        AttachState snapshot();
+
+        /**
+         * @brief Called on the receiving thread after each message is applied (and once when the server goes away). Set before `::attach`.
+         */
+        std::function<void()> on_update;
+
+    private:
+        bool read_frame(attach_protocol::Type& type, std::string& payload);
+        void apply(attach_protocol::Type type, const std::string& payload);
+        void receive();
+
+        boost::asio::io_context context;
+        boost::asio::local::stream_protocol::socket socket;
+        std::thread thread;
+        std::mutex write_mutex;
+        uint32_t next_id;
+
+        std::mutex state_mutex;
+        AttachState state;
+};
+
+#endif
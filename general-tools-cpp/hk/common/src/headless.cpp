@@ -0,0 +1,157 @@
+#include "headless.h"
+#include "trace.h"
+#include <iostream>
+#include <thread>
+#include <cstring>
+#include <stdexcept>
+
+HeadlessRunner::HeadlessRunner(std::string program, std::string task, std::chrono::milliseconds period, std::string alarm_path):
+        options("options"),
+        period(period),
+        poll_task(0),
+        program(program),
+        task(task),
+        retry(0),
+        next_connect(std::chrono::steady_clock::time_point::min()),
+        up(false)
+{
+    options.add_options()
+        ("help,h",                                                                          "output help message")
+        ("local",       boost::program_options::value<std::string>(),                       "local IP address to bind")
+        ("local-port",  boost::program_options::value<unsigned short>(),                    "local port to bind")
+        ("remote",      boost::program_options::value<std::string>()->default_value("192.168.1.16"), "Housekeeping board IP address")
+        ("remote-port", boost::program_options::value<unsigned short>()->default_value(7777), "Housekeeping board port")
+        ("alarms",      boost::program_options::value<std::string>()->default_value(alarm_path), "alarm limits file")
+        ("poll-period", boost::program_options::value<unsigned long>()->default_value(period.count()), "milliseconds between polls")
+        ("trace",       boost::program_options::value<std::string>(),                       "write a Chrome trace-event file on exit")
+        ("metrics",     boost::program_options::value<unsigned short>(),                    "serve metrics on 127.0.0.1 at this port")
+        ("status",      boost::program_options::value<double>()->default_value(60.0),       "seconds between status lines (0 for none)")
+        ("retry",       boost::program_options::value<double>()->default_value(5.0),        "seconds between connection attempts")
+    ;
+}
+
+bool HeadlessRunner::parse(int argc, char** argv, int& status) {
+    boost::program_options::positional_options_description positional;
+    positional.add("local", 1).add("local-port", 1);
+    try {
+        boost::program_options::store(boost::program_options::command_line_parser(argc, argv).options(options).positional(positional).run(), vm);
+        boost::program_options::notify(vm);
+    } catch (std::exception& e) {
+        std::cerr << e.what() << "\n";
+        status = 1;
+        return false;
+    }
+
+    if (vm.count("help") || !vm.count("local") || !vm.count("local-port")) {
+        std::cout << "use like this:\n\t> ./" << program << " 192.168.1.118 9999 [--remote 192.168.1.16] [--remote-port 7777] [--poll-period ms] [--status seconds]\n\n";
+        std::cout << options << "\n";
+        status = vm.count("help") ? 0 : 1;
+        return false;
+    }
+
+    if (vm.count("trace")) {
+        if (!trace::start(vm["trace"].as<std::string>())) {
+            status = 1;
+            return false;
+        }
+        trace::set_thread_name("main");
+    }
+
+    try {
+        local = boost::asio::ip::tcp::endpoint(boost::asio::ip::make_address_v4(vm["local"].as<std::string>()), vm["local-port"].as<unsigned short>());
+        remote = boost::asio::ip::tcp::endpoint(boost::asio::ip::make_address_v4(vm["remote"].as<std::string>()), vm["remote-port"].as<unsigned short>());
+    } catch (std::exception& e) {
+        std::cerr << "bad address: " << e.what() << "\n";
+        status = 1;
+        return false;
+    }
+    period = std::chrono::milliseconds(vm["poll-period"].as<unsigned long>());
+    if (period.count() == 0) {
+        std::cerr << "--poll-period must be at least 1 ms\n";
+        status = 1;
+        return false;
+    }
+    retry = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(vm["retry"].as<double>()));
+    return true;
+}
+
+bool HeadlessRunner::serve_metrics(MetricsRegistry& registry, std::string& error) {
+    if (!vm.count("metrics")) {
+        return true;
+    }
+    metrics_server = std::make_unique<MetricsServer>(registry);
+    return metrics_server->start(vm["metrics"].as<unsigned short>(), error);
+}
+
+void HeadlessRunner::fail(std::chrono::steady_clock::time_point now) {
+    disconnect();
+    up = false;
+    next_connect = now + retry;
+}
+
+void HeadlessRunner::cycle(std::chrono::steady_clock::time_point deadline) {
+    scheduler.record(poll_task, deadline);
+    auto now = std::chrono::steady_clock::now();
+    if (between) {
+        between();
+    }
+    if (!up) {
+        if (now < next_connect) {
+            return;
+        }
+        bool connected = false;
+        try {
+            connected = connect();
+        } catch (std::exception& e) {
+            std::cout << "connect error: " << e.what() << "\n";
+        }
+        if (!connected) {
+            fail(now);
+            return;
+        }
+        up = true;
+        std::cout << time_tag() << " connected to " << remote << "\n";
+    }
+    try {
+        if (!poll()) {
+            throw std::runtime_error("no reply from the board");
+        }
+    } catch (std::exception& e) {
+        std::cout << time_tag() << " poll error: " << e.what() << ", reconnecting\n";
+        fail(now);
+    }
+}
+
+int HeadlessRunner::run() {
+    // connect if needed, then poll, all on the scheduler thread. Any failure closes the link and retries later.
+    poll_task = scheduler.add(task, period, [this](std::chrono::steady_clock::time_point deadline) {
+        cycle(deadline);
+    });
+
+    // a periodic one-line summary, so a log of stdout shows the run is healthy:
+    if (vm["status"].as<double>() > 0) {
+        auto status_period = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(vm["status"].as<double>()));
+        scheduler.add("status", status_period, [this](std::chrono::steady_clock::time_point) {
+            std::cout << time_tag() << (up ? " polling" : " waiting") << ": " << status() << ", " << scheduler.tasks[poll_task].missed.load() << " missed\n";
+            std::cout.flush();
+        });
+    }
+
+    std::thread polling([this] { scheduler.run(); });
+    std::cout << "polling " << remote << " from " << local << ", stop with ctrl-C or SIGTERM\n";
+    std::cout.flush();
+
+    int received = stop_signal.wait();
+    std::cout << time_tag() << " " << strsignal(received) << ", stopping\n";
+    scheduler.stop();
+    // a poll blocked waiting for the board would hold up the join, so wake it:
+    interrupt();
+    polling.join();
+    if (metrics_server) {
+        metrics_server->stop();
+    }
+    trace::stop();
+
+    std::cout << scheduler.summary(poll_task) << "\n";
+    return 0;
+}
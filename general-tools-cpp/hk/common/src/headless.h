@@ -0,0 +1,129 @@
+#pragma once
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <string>
+#include <chrono>
+#include <memory>
+#include <functional>
+#include <boost/asio.hpp>
+#include <boost/program_options.hpp>
+#include "scheduler.h"
+#include "signals.h"
+#include "metrics.h"
+
+/**
+ * @brief The board-independent part of a headless polling daemon like `ptuid` or `rtuid`: command-line options, connecting and reconnecting, status lines, metrics, tracing, and clean shutdown on SIGINT or SIGTERM.
+ *
+ * Construct it at the top of `main`, before any other thread starts (it holds the `ShutdownSignal`). Then add any extra options to `::options`, call `::parse`, build the node on `::local`, set the hooks and call `::run`:
+ * ```cpp
+ * HeadlessRunner runner("ptuid", "ADC poll", config::adc_poll_period, config::alarm_path);
+ * int status = 0;
+ * if (!runner.parse(argc, argv, status)) {
+ *     return status;
+ * }
+ * HKADCNode node(runner.local, context, runner.period);
+ * runner.poll = [&] { return node.poll_adc(); };
+ * ...
+ * return runner.run();
+ * ```
+ * Every hook but `::interrupt` is called on the polling thread, so they never run at the same time as each other.
+ */
+class HeadlessRunner {
+    public:
+        /**
+         * @brief Construct a new HeadlessRunner object, blocking SIGINT and SIGTERM in this thread.
+         *
+         * @param program executable name, for the usage line, like "ptuid".
+         * @param task name of the poll task, like "ADC poll".
+         * @param period default for `--poll-period`, the time between polls.
+         * @param alarm_path default for `--alarms`.
+         */
+        HeadlessRunner(std::string program, std::string task, std::chrono::milliseconds period, std::string alarm_path);
+
+        /**
+         * @brief Parse the command line, start tracing if asked, and resolve `::local`, `::remote` and `::period`.
+         *
+         * @param status set to the exit status for `main` if this returns false.
+         * @return false if the program should exit now: help was asked for, or the command line was bad.
+         */
+        bool parse(int argc, char** argv, int& status);
+        /**
+         * @brief Serve `registry` to Prometheus on the `--metrics` port, if one was given. Stopped by `::run`.
+         *
+         * @param error set to a description of the problem if the server couldn't start.
+         * @return false if the server couldn't start.
+         */
+        bool serve_metrics(MetricsRegistry& registry, std::string& error);
+        /**
+         * @brief Poll (connecting first, and again after any failure) until SIGINT or SIGTERM arrives, then stop polling, metrics and tracing.
+         *
+         * @return the exit status for `main`.
+         */
+        int run();
+
+        /**
+         * @brief Whether the last connect succeeded and no poll has failed since.
+         */
+        bool connected() const { return up.load(); }
+
+        boost::program_options::options_description options;
+        boost::program_options::variables_map vm;
+        boost::asio::ip::tcp::endpoint local;
+        boost::asio::ip::tcp::endpoint remote;
+        /**
+         * @brief Time between polls, from `--poll-period`. Pass it to the node too, so buffers sized in seconds hold the right number of readings.
+         */
+        std::chrono::milliseconds period;
+
+        /**
+         * @brief Connect to `::remote`. Return true once connected, or false (or throw) to try again after `--retry` seconds.
+         */
+        std::function<bool()> connect;
+        /**
+         * @brief Close the link after a failed connect or poll, ready to connect again.
+         */
+        std::function<void()> disconnect;
+        /**
+         * @brief Poll the board once. Return false (or throw) if it didn't answer; the link is then closed and reconnected.
+         */
+        std::function<bool()> poll;
+        /**
+         * @brief Called before every poll, connected or not, for work that has to reach the board between polls. Optional.
+         */
+        std::function<void()> between;
+        /**
+         * @brief Link counters and latency for the status line, like "1200 replies, 0 short, 2 timeouts, 1 reconnects, median 1.2 ms".
+         */
+        std::function<std::string()> status;
+        /**
+         * @brief Wake a poll blocked on the board, at shutdown. Called on the main thread while polling may still be running.
+         */
+        std::function<void()> interrupt;
+        /**
+         * @brief The current time for log lines, in the application's log time format (`util::get_now_string`).
+         */
+        std::function<std::string()> time_tag;
+
+        PeriodicScheduler scheduler;
+        /**
+         * @brief Index of the poll task in `::scheduler`, once `::run` has started.
+         */
+        size_t poll_task;
+
+    private:
+        // one scheduled poll: connect if needed, then poll, closing the link on any failure
+        void cycle(std::chrono::steady_clock::time_point deadline);
+        // close the link and wait `retry` before connecting again
+        void fail(std::chrono::steady_clock::time_point now);
+
+        ShutdownSignal stop_signal;
+        std::string program;
+        std::string task;
+        std::chrono::steady_clock::duration retry;
+        std::chrono::steady_clock::time_point next_connect;
+        std::atomic<bool> up;
+        std::unique_ptr<MetricsServer> metrics_server;
+};
+
+#endif
@@ -0,0 +1,130 @@
+#include "history.h"
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+DecimatedHistory::DecimatedHistory(size_t capacity, size_t factor, size_t levels):
+        factor(factor > 1 ? factor : 2),
+        pending(levels > 0 ? levels : 1),
+        pending_count(levels > 0 ? levels : 1, 0)
+{
+    for (size_t k = 0; k < pending.size(); ++k) {
+        this->levels.emplace_back(capacity);
+    }
+}
+
+void DecimatedHistory::add(std::chrono::steady_clock::time_point time, double value) {
+    push(0, HistoryBin{time, value, value});
+}
+
+void DecimatedHistory::push(size_t level, const HistoryBin& bin) {
+    levels[level].push(bin);
+    size_t up = level + 1;
+    if (up >= levels.size()) {
+        return;
+    }
+
+    if (pending_count[up] == 0) {
+        pending[up] = bin;
+    } else {
+        pending[up].min = std::min(pending[up].min, bin.min);
+        pending[up].max = std::max(pending[up].max, bin.max);
+    }
+    ++pending_count[up];
+
+    if (pending_count[up] == factor) {
+        pending_count[up] = 0;
+        push(up, pending[up]);
+    }
+}
+
+size_t DecimatedHistory::first_after(size_t level, std::chrono::steady_clock::time_point time) const {
+    const RingBuffer<HistoryBin>& ring = levels[level];
+    size_t lo = 0;
+    size_t hi = ring.size();
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (ring[mid].start <= time) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+std::vector<std::pair<double, double>> DecimatedHistory::envelope(std::chrono::steady_clock::time_point now, std::chrono::nanoseconds span, size_t columns) const {
+    double nan = std::numeric_limits<double>::quiet_NaN();
+    std::vector<std::pair<double, double>> result(columns, std::make_pair(nan, nan));
+    if (columns == 0 || span.count() <= 0 || levels[0].size() == 0) {
+        return result;
+    }
+    auto begin = now - span;
+
+    // use the finest level that reaches back to `begin` without needing too many bins.
+    size_t chosen = levels.size() - 1;
+    for (size_t k = 0; k < levels.size(); ++k) {
+        const RingBuffer<HistoryBin>& ring = levels[k];
+        bool covers = !ring.full() || ring[0].start <= begin;
+        size_t in_span = ring.size() - first_after(k, begin);
+        if (covers && in_span <= factor * columns) {
+            chosen = k;
+            break;
+        }
+    }
+
+    auto fold = [&](const HistoryBin& bin) {
+        double offset = std::chrono::duration<double>(bin.start - begin).count() / std::chrono::duration<double>(span).count();
+        if (offset > 1.0) {
+            return;
+        }
+        // slices are half-open, (begin, begin + span/columns], ...
+        size_t col = static_cast<size_t>(std::clamp(std::ceil(offset * columns) - 1.0, 0.0, static_cast<double>(columns - 1)));
+        auto& slot = result[col];
+        if (std::isnan(slot.first)) {
+            slot = std::make_pair(bin.min, bin.max);
+        } else {
+            slot.first = std::min(slot.first, bin.min);
+            slot.second = std::max(slot.second, bin.max);
+        }
+    };
+
+    const RingBuffer<HistoryBin>& ring = levels[chosen];
+    for (size_t k = first_after(chosen, begin); k < ring.size(); ++k) {
+        fold(ring[k]);
+    }
+    // the newest samples are still in partial bins at and below the chosen level:
+    for (size_t k = chosen; k > 0; --k) {
+        if (pending_count[k] > 0) {
+            fold(pending[k]);
+        }
+    }
+    return result;
+}
+
+std::string DecimatedHistory::sparkline(std::chrono::steady_clock::time_point now, std::chrono::nanoseconds span, size_t columns) const {
+    static const std::vector<std::string> blocks = {"▁", "▂", "▃", "▄", "▅", "▆", "▇", "█"};
+
+    auto env = envelope(now, span, columns);
+    double lo = std::numeric_limits<double>::infinity();
+    double hi = -std::numeric_limits<double>::infinity();
+    for (auto& col: env) {
+        if (!std::isnan(col.first)) {
+            lo = std::min(lo, col.first);
+            hi = std::max(hi, col.second);
+        }
+    }
+
+    std::string result;
+    for (auto& col: env) {
+        if (std::isnan(col.first)) {
+            result += " ";
+        } else if (hi <= lo) {
+            result += blocks[blocks.size() / 2];
+        } else {
+            size_t level = static_cast<size_t>((col.second - lo) / (hi - lo) * (blocks.size() - 1) + 0.5);
+            result += blocks[std::min(level, blocks.size() - 1)];
+        }
+    }
+    return result;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <utility>
+#include "ring.h"
+
+/**
+ * @brief The extrema of all samples starting at a given time.
+ */
+struct HistoryBin {
+    std::chrono::steady_clock::time_point start;
+    double min;
+    double max;
+};
+
+/**
+ * @brief A bounded-memory, multi-resolution min/max history of one channel.
+ *
+ * Level 0 holds raw samples. Every `factor` bins in one level are combined into a single min/max bin in the next level up, so each level spans `factor` times more time than the one below with the same number of bins. Adding a sample is amortized O(1), memory is fixed at `levels * capacity` bins, and the oldest data is only dropped once the coarsest level wraps.
+ *
+ * Queries pick the finest level that covers the requested span with a bounded number of bins, so drawing a trace costs O(columns) no matter how long the session has been running.
+ */
+class DecimatedHistory {
+    public:
+        /**
+         * @brief Construct a new DecimatedHistory object.
+         *
+         * @param capacity number of bins kept at each level.
+         * @param factor number of bins combined into one bin at the next level.
+         * @param levels number of levels.
+         */
+        DecimatedHistory(size_t capacity = 1024, size_t factor = 4, size_t levels = 8);
+
+        /**
+         * @brief Add a new sample.
+         *
+         * @param time when the sample was observed.
+         * @param value the sample value.
+         */
+        void add(std::chrono::steady_clock::time_point time, double value);
+
+        /**
+         * @brief Get the min/max envelope of the span of time `(now - span, now]`.
+         *
+         * @param now the end of the span.
+         * @param span how far back from `now` to look.
+         * @param columns number of equal slices to divide `span` into.
+         * @return std::vector<std::pair<double, double>> {min, max} for each slice, oldest first. Slices with no data are NaN.
+         */
+        std::vector<std::pair<double, double>> envelope(std::chrono::steady_clock::time_point now, std::chrono::nanoseconds span, size_t columns) const;
+
+        /**
+         * @brief Draw the span of time ending at `now` as a line of block characters.
+         *
+         * @param now the end of the span.
+         * @param span how far back from `now` to look.
+         * @param columns number of characters to draw.
+         * @return std::string the sparkline, scaled between the extrema in the span.
+         */
+        std::string sparkline(std::chrono::steady_clock::time_point now, std::chrono::nanoseconds span, size_t columns) const;
+
+        /**
+         * @brief Total number of samples added.
+         */
+        uint64_t count() const { return levels[0].total(); }
+
+    private:
+        /**
+         * @brief Append a completed bin to `level` and fold it into the pending bin above.
+         */
+        void push(size_t level, const HistoryBin& bin);
+        /**
+         * @brief Index of the first bin in `level` starting after `time`.
+         */
+        size_t first_after(size_t level, std::chrono::steady_clock::time_point time) const;
+
+        size_t factor;
+        std::vector<RingBuffer<HistoryBin>> levels;
+        // partial bins under construction for each level (index 0 unused):
+        std::vector<HistoryBin> pending;
+        std::vector<size_t> pending_count;
+};
+
+#endif
@@ -0,0 +1,153 @@
+#include "latency.h"
+#include "timestamp.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include <bit>
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+void LatencyHistogram::reset() {
+    counts.fill(0);
+    total = 0;
+    largest = 0;
+    smallest = std::numeric_limits<int64_t>::max();
+    sum = 0.0;
+}
+
+size_t LatencyHistogram::bucket(uint64_t ns) {
+    // values below two sub-bucket ranges are counted exactly:
+    if (ns < 2 * sub_count) {
+        return static_cast<size_t>(ns);
+    }
+    // otherwise keep the top `sub_bits + 1` bits: the power of two, and which sixteenth of it.
+    int shift = (63 - std::countl_zero(ns)) - sub_bits;
+    uint64_t mantissa = ns >> shift;
+    return static_cast<size_t>((shift + 1) * sub_count + (mantissa - sub_count));
+}
+
+uint64_t LatencyHistogram::bucket_low(size_t k) {
+    if (k < 2 * sub_count) {
+        return k;
+    }
+    int shift = static_cast<int>(k / sub_count) - 1;
+    uint64_t mantissa = k % sub_count + sub_count;
+    return mantissa << shift;
+}
+
+uint64_t LatencyHistogram::bucket_high(size_t k) {
+    if (k + 1 >= bucket_count) {
+        return std::numeric_limits<uint64_t>::max();
+    }
+    return bucket_low(k + 1) - 1;
+}
+
+void LatencyHistogram::add(int64_t ns) {
+    ns = std::max<int64_t>(ns, 0);
+    ++counts[bucket(static_cast<uint64_t>(ns))];
+    ++total;
+    largest = std::max(largest, ns);
+    smallest = std::min(smallest, ns);
+    sum += ns;
+}
+
+int64_t LatencyHistogram::min() const {
+    return total > 0 ? smallest : 0;
+}
+
+double LatencyHistogram::mean() const {
+    return total > 0 ? sum / total : 0.0;
+}
+
+int64_t LatencyHistogram::percentile(double q) const {
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * total));
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    for (size_t k = 0; k < bucket_count; ++k) {
+        seen += counts[k];
+        if (seen >= rank) {
+            return std::min<int64_t>(static_cast<int64_t>(bucket_high(k)), largest);
+        }
+    }
+    return largest;
+}
+
+LatencyBank::LatencyBank(std::string node, std::vector<std::string> names, std::string summary_path):
+        node(node),
+        names(names),
+        histograms(names.size()),
+        summary_path(summary_path) {}
+
+LatencyBank::~LatencyBank() {
+    if (summary_path == "") {
+        return;
+    }
+    bool any = std::any_of(histograms.begin(), histograms.end(), [](const LatencyHistogram& h) { return h.count() > 0; });
+    if (!any) {
+        return;
+    }
+    std::ofstream out(summary_path, std::ios::out);
+    if (!out.is_open()) {
+        std::cout << "couldn't open latency summary " << summary_path << "\n";
+        return;
+    }
+    write_summary(out);
+}
+
+void LatencyBank::add(size_t request, int64_t sent, int64_t received) {
+    histograms[request].add(received - sent);
+}
+
+// format nanoseconds as milliseconds
+static std::string ms(int64_t ns) {
+    std::stringstream result;
+    result << std::fixed << std::setprecision(ns < 10000000 ? 2 : 1) << ns * 1e-6;
+    return result.str();
+}
+
+std::string LatencyBank::brief(size_t request) const {
+    const LatencyHistogram& h = histograms[request];
+    if (h.count() == 0) {
+        return names[request] + " -";
+    }
+    return names[request] + " p50 " + ms(h.percentile(0.5)) + " p99 " + ms(h.percentile(0.99)) + " max " + ms(h.max()) + " ms";
+}
+
+void LatencyBank::write_summary(std::ostream& out) const {
+    out << "# round-trip latency for " << node << ", written " << format_time(std::chrono::system_clock::now()) << "\n";
+    for (size_t r = 0; r < names.size(); ++r) {
+        const LatencyHistogram& h = histograms[r];
+        out << "\n[" << names[r] << "]\n";
+        out << "count " << h.count() << "\n";
+        if (h.count() == 0) {
+            continue;
+        }
+        out << "min_ms " << ms(h.min()) << "\n";
+        out << "mean_ms " << ms(static_cast<int64_t>(h.mean())) << "\n";
+        const std::vector<std::pair<std::string, double>> quantiles = {{"p50", 0.5}, {"p90", 0.9}, {"p99", 0.99}, {"p99.9", 0.999}};
+        for (auto& q: quantiles) {
+            out << q.first << "_ms " << ms(h.percentile(q.second)) << "\n";
+        }
+        out << "max_ms " << ms(h.max()) << "\n";
+
+        out << "bucket_low_ns,bucket_high_ns,count,cumulative_fraction\n";
+        uint64_t seen = 0;
+        for (size_t k = 0; k < LatencyHistogram::bucket_count; ++k) {
+            if (h.at(k) == 0) {
+                continue;
+            }
+            seen += h.at(k);
+            out << LatencyHistogram::bucket_low(k) << "," << LatencyHistogram::bucket_high(k) << "," << h.at(k) << ",";
+            out << std::fixed << std::setprecision(6) << static_cast<double>(seen) / h.count() << "\n";
+        }
+    }
+}
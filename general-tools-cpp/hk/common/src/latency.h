@@ -0,0 +1,117 @@
+#pragma once
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <vector>
+#include <array>
+#include <string>
+#include <cstdint>
+
+/**
+ * @brief A latency histogram with log-spaced buckets, in the style of HdrHistogram.
+ *
+ * Each power of two is split into 16 linear sub-buckets, so any recorded value is known to within about 6% however large it is, from nanoseconds to hours, in a fixed 8 kB of counters. Recording is a bit scan and an increment, cheap enough for every poll.
+ */
+class LatencyHistogram {
+    public:
+        /**
+         * @brief Number of sub-buckets in each power of two, as a power of two.
+         */
+        static constexpr int sub_bits = 4;
+        static constexpr uint64_t sub_count = uint64_t(1) << sub_bits;
+        static constexpr size_t bucket_count = (64 - sub_bits + 1) * sub_count;
+
+        LatencyHistogram();
+
+        /**
+         * @brief Record one latency, in nanoseconds. Negative values are counted as zero.
+         */
+        void add(int64_t ns);
+        /**
+         * @brief Forget all recorded values.
+         */
+        void reset();
+
+        uint64_t count() const { return total; }
+        /**
+         * @brief Largest value recorded, exactly, in nanoseconds.
+         */
+        int64_t max() const { return largest; }
+        /**
+         * @brief Smallest value recorded, exactly, in nanoseconds.
+         */
+        int64_t min() const;
+        double mean() const;
+        /**
+         * @brief The value at quantile `q` (0 to 1), in nanoseconds.
+         *
+         * Reported as the upper edge of the bucket the quantile falls in (but never more than `::max`), so it errs on the side of too slow.
+         */
+        int64_t percentile(double q) const;
+
+        /**
+         * @brief Bucket index for a value.
+         */
+        static size_t bucket(uint64_t ns);
+        /**
+         * @brief Smallest value that falls in bucket `k`.
+         */
+        static uint64_t bucket_low(size_t k);
+        /**
+         * @brief Largest value that falls in bucket `k`.
+         */
+        static uint64_t bucket_high(size_t k);
+
+        /**
+         * @brief Count in bucket `k`.
+         */
+        uint64_t at(size_t k) const { return counts[k]; }
+
+    private:
+        std::array<uint64_t, bucket_count> counts;
+        uint64_t total;
+        int64_t largest;
+        int64_t smallest;
+        double sum;
+};
+
+/**
+ * @brief Round-trip latency histograms for each request type a node sends, written out as a summary file at exit.
+ */
+class LatencyBank {
+    public:
+        /**
+         * @brief Construct a new LatencyBank object.
+         *
+         * @param node name of the node, for the summary file.
+         * @param names name of each request type.
+         * @param summary_path file to write the summary to when destroyed. Empty to skip it.
+         */
+        LatencyBank(std::string node, std::vector<std::string> names, std::string summary_path);
+        ~LatencyBank();
+
+        /**
+         * @brief Record the round trip for one request, from `sent` to `received` in `steady_clock` nanoseconds (see `steady_ns`).
+         *
+         * @param request index into `::names`.
+         */
+        void add(size_t request, int64_t sent, int64_t received);
+
+        /**
+         * @brief Short display string for one request type, like "request_adc p50 1.2 ms p99 3.4 ms max 8.0 ms".
+         */
+        std::string brief(size_t request) const;
+        /**
+         * @brief Write the percentile summary and the non-empty buckets of every histogram to `out`.
+         */
+        void write_summary(std::ostream& out) const;
+
+        std::string node;
+        std::vector<std::string> names;
+        std::vector<LatencyHistogram> histograms;
+
+    private:
+        std::string summary_path;
+};
+
+#endif
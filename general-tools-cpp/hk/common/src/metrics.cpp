@@ -0,0 +1,182 @@
+#include "metrics.h"
+#include <memory>
+#include <sstream>
+#include <cmath>
+#include <cstdio>
+
+// each thread's shard, assigned round-robin the first time it counts anything.
+static size_t local_shard() {
+    static std::atomic<size_t> next_shard{0};
+    thread_local size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % MetricCounter::shard_count;
+    return shard;
+}
+
+MetricCounter::MetricCounter() {
+    for (auto& s: shards) {
+        s.count.store(0, std::memory_order_relaxed);
+    }
+}
+
+void MetricCounter::add(uint64_t n) {
+    shards[local_shard()].count.fetch_add(n, std::memory_order_relaxed);
+}
+
+uint64_t MetricCounter::value() const {
+    uint64_t total = 0;
+    for (auto& s: shards) {
+        total += s.count.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+MetricsRegistry::MetricsRegistry(std::string node): node(node) {}
+
+MetricCounter& MetricsRegistry::counter(std::string name, std::string help) {
+    std::lock_guard<std::mutex> lock(mutex);
+    counters.emplace_back();
+    CounterEntry& entry = counters.back();
+    entry.name = name;
+    entry.help = help;
+    return entry.counter;
+}
+
+void MetricsRegistry::gauge(std::string name, std::string help, std::function<double()> read) {
+    std::lock_guard<std::mutex> lock(mutex);
+    gauges.push_back({name, help, read});
+}
+
+// sample values in the exposition format
+static std::string sample_value(double value) {
+    if (std::isnan(value)) {
+        return "NaN";
+    }
+    if (std::isinf(value)) {
+        return value > 0 ? "+Inf" : "-Inf";
+    }
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.17g", value);
+    return text;
+}
+
+std::string MetricsRegistry::render() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::stringstream out;
+    std::string labels = "{node=\"" + node + "\"}";
+    for (auto& c: counters) {
+        out << "# HELP " << c.name << " " << c.help << "\n";
+        out << "# TYPE " << c.name << " counter\n";
+        out << c.name << labels << " " << c.counter.value() << "\n";
+    }
+    for (auto& g: gauges) {
+        out << "# HELP " << g.name << " " << g.help << "\n";
+        out << "# TYPE " << g.name << " gauge\n";
+        out << g.name << labels << " " << sample_value(g.read()) << "\n";
+    }
+    return out.str();
+}
+
+LinkMetrics::LinkMetrics(MetricsRegistry& registry):
+        polls(registry.counter("hk_polls_total", "Poll cycles started.")),
+        replies(registry.counter("hk_replies_total", "Complete replies received from the board.")),
+        short_reads(registry.counter("hk_short_reads_total", "Replies shorter than expected.")),
+        timeouts(registry.counter("hk_timeouts_total", "Reads abandoned after the I/O timeout.")),
+        bytes_sent(registry.counter("hk_sent_bytes_total", "Bytes written to the board socket.")),
+        bytes_received(registry.counter("hk_received_bytes_total", "Bytes read from the board socket.")),
+        connects(registry.counter("hk_connects_total", "Successful connections to the board.")),
+        reconnects(registry.counter("hk_reconnects_total", "Successful connections after the first.")),
+        connect_errors(registry.counter("hk_connect_errors_total", "Failed connection attempts.")) {}
+
+MetricsServer::MetricsServer(MetricsRegistry& registry): scrapes(0), registry(registry), acceptor(context) {}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+bool MetricsServer::start(unsigned short port, std::string& error) {
+    try {
+        boost::asio::ip::tcp::endpoint endpoint(boost::asio::ip::make_address_v4("127.0.0.1"), port);
+        acceptor.open(endpoint.protocol());
+        acceptor.set_option(boost::asio::socket_base::reuse_address(true));
+        acceptor.bind(endpoint);
+        acceptor.listen();
+    } catch (std::exception& e) {
+        error = e.what();
+        if (acceptor.is_open()) {
+            acceptor.close();
+        }
+        return false;
+    }
+    accept();
+    thread = std::thread([this] { context.run(); });
+    return true;
+}
+
+void MetricsServer::stop() {
+    context.stop();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+unsigned short MetricsServer::port() const {
+    boost::system::error_code err;
+    auto endpoint = acceptor.local_endpoint(err);
+    return err ? 0 : endpoint.port();
+}
+
+namespace {
+    // one scrape connection, kept alive by the handlers that reference it.
+    struct Session {
+        Session(boost::asio::ip::tcp::socket socket): socket(std::move(socket)) {}
+        boost::asio::ip::tcp::socket socket;
+        boost::asio::streambuf request;
+        std::string response;
+    };
+}
+
+void MetricsServer::accept() {
+    acceptor.async_accept([this](const boost::system::error_code& err, boost::asio::ip::tcp::socket peer) {
+        if (err) {
+            return;
+        }
+        auto session = std::make_shared<Session>(std::move(peer));
+        boost::asio::async_read_until(session->socket, session->request, "\r\n\r\n", [this, session](const boost::system::error_code& err, size_t) {
+            if (err) {
+                return;
+            }
+            std::istream in(&session->request);
+            std::string request_line;
+            std::getline(in, request_line);
+            session->response = respond(request_line);
+            boost::asio::async_write(session->socket, boost::asio::buffer(session->response), [session](const boost::system::error_code&, size_t) {
+                boost::system::error_code ignored;
+                session->socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ignored);
+            });
+        });
+        accept();
+    });
+}
+
+std::string MetricsServer::respond(const std::string& request_line) {
+    std::string status = "200 OK";
+    std::string type = "text/plain; version=0.0.4; charset=utf-8";
+    std::string body;
+
+    std::istringstream words(request_line);
+    std::string method, target;
+    words >> method >> target;
+    if (method != "GET") {
+        status = "405 Method Not Allowed";
+        type = "text/plain";
+        body = "only GET is supported\n";
+    } else if (target == "/metrics") {
+        body = registry.render();
+        scrapes.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        status = "404 Not Found";
+        type = "text/plain";
+        body = "metrics are at /metrics\n";
+    }
+
+    return "HTTP/1.1 " + status + "\r\nContent-Type: " + type + "\r\nContent-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+}
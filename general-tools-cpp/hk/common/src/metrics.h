@@ -0,0 +1,154 @@
+#pragma once
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <boost/asio.hpp>
+#include <array>
+#include <deque>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <functional>
+#include <cstdint>
+
+/**
+ * @brief A monotonic counter that many threads can increment without contending.
+ *
+ * Each thread adds to its own cache-line-sized shard (threads are assigned shards round-robin, so up to `::shard_count` threads never share one), and the shards are only summed when the value is read, e.g. when the metrics page is scraped.
+ */
+class MetricCounter {
+    public:
+        static constexpr size_t shard_count = 8;
+
+        MetricCounter();
+
+        /**
+         * @brief Add `n` to the counter. Lock-free and wait-free.
+         */
+        void add(uint64_t n = 1);
+        /**
+         * @brief Current total over all threads.
+         */
+        uint64_t value() const;
+
+    private:
+        struct alignas(64) Shard {
+            std::atomic<uint64_t> count;
+        };
+        std::array<Shard, shard_count> shards;
+};
+
+/**
+ * @brief A named set of counters and gauges, rendered in the Prometheus text exposition format.
+ *
+ * Register metrics once at startup (registration takes a lock); after that, counters are updated without locking and gauges are sampled only when `::render` is called.
+ */
+class MetricsRegistry {
+    public:
+        /**
+         * @brief Construct a new MetricsRegistry object.
+         *
+         * @param node added to every metric as a `node` label, e.g. "ptui".
+         */
+        MetricsRegistry(std::string node);
+
+        /**
+         * @brief Register a counter. The reference stays valid for the life of the registry.
+         *
+         * @param name metric name. By Prometheus convention, counters end in `_total`.
+         * @param help one-line description, shown as `# HELP`.
+         */
+        MetricCounter& counter(std::string name, std::string help);
+        /**
+         * @brief Register a gauge, whose value is read by calling `read` on each scrape.
+         *
+         * `read` is called from the thread serving the metrics page, so it must be thread safe.
+         */
+        void gauge(std::string name, std::string help, std::function<double()> read);
+
+        /**
+         * @brief All metrics in Prometheus text format (version 0.0.4).
+         */
+        std::string render();
+
+        std::string node;
+
+    private:
+        struct CounterEntry {
+            std::string name;
+            std::string help;
+            MetricCounter counter;
+        };
+        struct GaugeEntry {
+            std::string name;
+            std::string help;
+            std::function<double()> read;
+        };
+
+        std::mutex mutex;
+        // deques, so references to registered counters stay valid:
+        std::deque<CounterEntry> counters;
+        std::deque<GaugeEntry> gauges;
+};
+
+/**
+ * @brief Counters for the health of a node's link to the Housekeeping board.
+ */
+struct LinkMetrics {
+    LinkMetrics(MetricsRegistry& registry);
+
+    MetricCounter& polls;
+    MetricCounter& replies;
+    MetricCounter& short_reads;
+    MetricCounter& timeouts;
+    MetricCounter& bytes_sent;
+    MetricCounter& bytes_received;
+    MetricCounter& connects;
+    MetricCounter& reconnects;
+    MetricCounter& connect_errors;
+};
+
+/**
+ * @brief A minimal HTTP server on localhost that serves a `MetricsRegistry` at `/metrics`, for a Prometheus scraper.
+ *
+ * Runs its own `io_context` on its own thread, so scrapes never wait on (or hold up) polling or the UI.
+ */
+class MetricsServer {
+    public:
+        MetricsServer(MetricsRegistry& registry);
+        ~MetricsServer();
+
+        /**
+         * @brief Listen on 127.0.0.1:`port` and start serving.
+         *
+         * @param port TCP port to listen on. 0 picks a free port (see `::port`).
+         * @param error set to a description of the problem if listening failed.
+         * @return true if the server is running.
+         */
+        bool start(unsigned short port, std::string& error);
+        /**
+         * @brief Stop serving and join the server thread.
+         */
+        void stop();
+        /**
+         * @brief The port being listened on, or 0 if not started.
+         */
+        unsigned short port() const;
+
+        /**
+         * @brief Number of scrapes served.
+         */
+        std::atomic<uint64_t> scrapes;
+
+    private:
+        void accept();
+        std::string respond(const std::string& request_line);
+
+        MetricsRegistry& registry;
+        boost::asio::io_context context;
+        boost::asio::ip::tcp::acceptor acceptor;
+        std::thread thread;
+};
+
+#endif
@@ -0,0 +1,93 @@
+#include "profiler.h"
+#include "trace.h"
+#include <sstream>
+#include <iomanip>
+
+const std::array<std::string, PhaseProfiler::phase_count>& poll_phase_names() {
+    static const std::array<std::string, PhaseProfiler::phase_count> names = {
+        "send", "wait", "raw log", "decode", "record", "format", "csv", "render"
+    };
+    return names;
+}
+
+PhaseProfiler::PhaseProfiler() {
+    last.fill(0.0);
+}
+
+void PhaseProfiler::add(PollPhase phase, int64_t ns) {
+    size_t k = static_cast<size_t>(phase);
+    last[k] = ns * 1e-3;
+    stats[k].add(last[k]);
+}
+
+void PhaseProfiler::reset() {
+    for (auto& s: stats) {
+        s.reset();
+    }
+    last.fill(0.0);
+}
+
+// format a duration in microseconds
+static std::string us(double value) {
+    std::stringstream result;
+    result << std::fixed << std::setprecision(1) << value;
+    return result.str();
+}
+
+std::vector<std::vector<std::string>> PhaseProfiler::table() const {
+    double total = 0.0;
+    for (auto& s: stats) {
+        total += s.count() > 0 ? s.mean() * s.count() : 0.0;
+    }
+
+    std::vector<std::vector<std::string>> result = {{"phase", "count", "last µs", "mean µs", "max µs", "share"}};
+    for (size_t k = 0; k < phase_count; ++k) {
+        const RunningStats& s = stats[k];
+        if (s.count() == 0) {
+            result.push_back({poll_phase_names()[k], "0", "-", "-", "-", "-"});
+            continue;
+        }
+        double share = total > 0.0 ? 100.0 * s.mean() * s.count() / total : 0.0;
+        result.push_back({poll_phase_names()[k], std::to_string(s.count()), us(last[k]), us(s.mean()), us(s.max()), us(share) + "%"});
+    }
+    return result;
+}
+
+PhaseProfiler::Lap::Lap(PhaseProfiler& profiler): profiler(profiler), last(std::chrono::steady_clock::now()) {
+    totals.fill(0);
+    touched.fill(false);
+}
+
+PhaseProfiler::Lap::~Lap() {
+    for (size_t k = 0; k < phase_count; ++k) {
+        if (touched[k]) {
+            profiler.add(static_cast<PollPhase>(k), totals[k]);
+        }
+    }
+}
+
+void PhaseProfiler::Lap::lap(PollPhase phase) {
+    auto now = std::chrono::steady_clock::now();
+    size_t k = static_cast<size_t>(phase);
+    int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now - last).count();
+    totals[k] += ns;
+    touched[k] = true;
+    if (trace::enabled()) {
+        trace::complete(poll_phase_names()[k].c_str(), "poll", std::chrono::duration_cast<std::chrono::nanoseconds>(last.time_since_epoch()).count(), ns);
+    }
+    last = now;
+}
+
+void PhaseProfiler::Lap::skip() {
+    last = std::chrono::steady_clock::now();
+}
+
+PhaseProfiler::Scope::Scope(PhaseProfiler& profiler, PollPhase phase): profiler(profiler), phase(phase), start(std::chrono::steady_clock::now()) {}
+
+PhaseProfiler::Scope::~Scope() {
+    int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    profiler.add(phase, ns);
+    if (trace::enabled()) {
+        trace::complete(poll_phase_names()[static_cast<size_t>(phase)].c_str(), "poll", std::chrono::duration_cast<std::chrono::nanoseconds>(start.time_since_epoch()).count(), ns);
+    }
+}
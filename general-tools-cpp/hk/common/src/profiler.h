@@ -0,0 +1,106 @@
+#pragma once
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <vector>
+#include <array>
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include "stats.h"
+
+/**
+ * @brief The phases of a housekeeping poll cycle, and of drawing the UI, timed by `PhaseProfiler`.
+ */
+enum class PollPhase: size_t {
+    send,       // write the request to the socket
+    wait,       // block until the reply arrives
+    raw,        // append the reply to the raw log
+    decode,     // `adc_table`/`parse_rtd`
+    record,     // captures, statistics, history, range index, alarms
+    format,     // build the display table
+    csv,        // `csv_write`
+    render,     // FTXUI render of the whole screen
+    count
+};
+
+/**
+ * @brief Display name for each `PollPhase`.
+ */
+const std::array<std::string, static_cast<size_t>(PollPhase::count)>& poll_phase_names();
+
+/**
+ * @brief Low-overhead timing of each phase of the poll cycle.
+ *
+ * Time each phase with a `::Lap` (for a sequence of phases) or a `::Scope` (for one block). Each costs one `steady_clock` read per phase, and per-phase statistics are updated once per cycle. When tracing is on (see `trace::start`), each phase is also recorded as a trace span. Not thread safe: use it from the thread that polls and renders (the FTXUI thread).
+ */
+class PhaseProfiler {
+    public:
+        static constexpr size_t phase_count = static_cast<size_t>(PollPhase::count);
+
+        PhaseProfiler();
+
+        /**
+         * @brief Times consecutive phases: each call to `::lap` charges the time since the previous call (or construction) to a phase.
+         *
+         * A phase may be lapped more than once in a cycle; its times are summed. Totals are added to the profiler when the Lap is destroyed, so early returns are counted correctly.
+         */
+        class Lap {
+            public:
+                Lap(PhaseProfiler& profiler);
+                ~Lap();
+                /**
+                 * @brief Charge the time since the previous lap to `phase`.
+                 */
+                void lap(PollPhase phase);
+                /**
+                 * @brief Restart timing without charging the elapsed time to any phase.
+                 */
+                void skip();
+
+            private:
+                PhaseProfiler& profiler;
+                std::chrono::steady_clock::time_point last;
+                std::array<int64_t, phase_count> totals;
+                std::array<bool, phase_count> touched;
+        };
+
+        /**
+         * @brief Times the enclosing block as one phase.
+         */
+        class Scope {
+            public:
+                Scope(PhaseProfiler& profiler, PollPhase phase);
+                ~Scope();
+
+            private:
+                PhaseProfiler& profiler;
+                PollPhase phase;
+                std::chrono::steady_clock::time_point start;
+        };
+
+        /**
+         * @brief Record one occurrence of `phase` taking `ns` nanoseconds.
+         */
+        void add(PollPhase phase, int64_t ns);
+        /**
+         * @brief Forget all timings.
+         */
+        void reset();
+
+        /**
+         * @brief A table of per-phase timing for display, with a header row: phase, count, last, mean, max (in µs), and share of total time.
+         */
+        std::vector<std::vector<std::string>> table() const;
+
+        /**
+         * @brief Statistics of each phase's duration, in microseconds.
+         */
+        std::array<RunningStats, phase_count> stats;
+        /**
+         * @brief Most recent duration of each phase, in microseconds.
+         */
+        std::array<double, phase_count> last;
+};
+
+#endif
@@ -0,0 +1,110 @@
+#include "rangeindex.h"
+#include <limits>
+#include <algorithm>
+
+RangeSummary::RangeSummary() {
+    count = 0;
+    min = std::numeric_limits<double>::infinity();
+    max = -std::numeric_limits<double>::infinity();
+    sum = 0.0;
+}
+
+void RangeSummary::add(double value) {
+    ++count;
+    min = std::min(min, value);
+    max = std::max(max, value);
+    sum += value;
+}
+
+void RangeSummary::merge(const RangeSummary& other) {
+    count += other.count;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+    sum += other.sum;
+}
+
+double RangeSummary::mean() const {
+    return count > 0 ? sum / count : std::numeric_limits<double>::quiet_NaN();
+}
+
+RangeIndex::RangeIndex(size_t block_size): block_size(block_size > 0 ? block_size : 1) {}
+
+void RangeIndex::add(double value) {
+    values.push_back(static_cast<float>(value));
+    partial.add(static_cast<float>(value));
+    if (partial.count == block_size) {
+        push(0, partial);
+        partial = RangeSummary();
+    }
+}
+
+void RangeIndex::push(size_t level, const RangeSummary& node) {
+    if (levels.size() <= level) {
+        levels.emplace_back();
+    }
+    levels[level].push_back(node);
+
+    size_t n = levels[level].size();
+    if (n % 2 == 0) {
+        RangeSummary parent = levels[level][n - 2];
+        parent.merge(levels[level][n - 1]);
+        push(level + 1, parent);
+    }
+}
+
+RangeSummary RangeIndex::query(uint64_t begin, uint64_t end) const {
+    RangeSummary result;
+    end = std::min<uint64_t>(end, values.size());
+    if (begin >= end) {
+        return result;
+    }
+
+    // complete blocks fully inside the range:
+    uint64_t first_block = (begin + block_size - 1) / block_size;
+    uint64_t last_block = end / block_size;
+
+    if (first_block >= last_block) {
+        for (uint64_t k = begin; k < end; ++k) {
+            result.add(values[k]);
+        }
+        return result;
+    }
+
+    for (uint64_t k = begin; k < first_block * block_size; ++k) {
+        result.add(values[k]);
+    }
+    for (uint64_t k = last_block * block_size; k < end; ++k) {
+        result.add(values[k]);
+    }
+
+    // bottom-up walk over the block tree, like an iterative segment tree:
+    uint64_t l = first_block;
+    uint64_t r = last_block;
+    for (size_t level = 0; l < r; ++level) {
+        if (l & 1) {
+            result.merge(levels[level][l++]);
+        }
+        if (r & 1) {
+            result.merge(levels[level][--r]);
+        }
+        l >>= 1;
+        r >>= 1;
+    }
+    return result;
+}
+
+TimedRangeIndex::TimedRangeIndex(size_t block_size): index(block_size) {}
+
+void TimedRangeIndex::add(std::chrono::steady_clock::time_point time, double value) {
+    times.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count());
+    index.add(value);
+}
+
+uint64_t TimedRangeIndex::lower_bound(std::chrono::steady_clock::time_point time) const {
+    int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    return std::lower_bound(times.begin(), times.end(), ns) - times.begin();
+}
+
+RangeSummary TimedRangeIndex::query(std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end) const {
+    return index.query(lower_bound(begin), lower_bound(end));
+}
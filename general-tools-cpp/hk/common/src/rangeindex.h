@@ -0,0 +1,119 @@
+#pragma once
+#ifndef RANGEINDEX_H
+#define RANGEINDEX_H
+
+#include <vector>
+#include <deque>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @brief Count, extrema and sum of a range of samples.
+ */
+struct RangeSummary {
+    RangeSummary();
+
+    /**
+     * @brief Add one value to the summary.
+     */
+    void add(double value);
+    /**
+     * @brief Combine another summary into this one.
+     */
+    void merge(const RangeSummary& other);
+    /**
+     * @brief Mean of the summarized values, or NaN if empty.
+     */
+    double mean() const;
+
+    uint64_t count;
+    double min;
+    double max;
+    double sum;
+};
+
+/**
+ * @brief An append-only index answering min/max/mean/count over any range of samples in O(log n).
+ *
+ * Samples are stored as `float` in fixed-size blocks. Each complete block is summarized, and summaries are combined pairwise into a binary tree that grows level by level as blocks are appended. A query scans at most two partial blocks directly and walks the tree for everything in between.
+ */
+class RangeIndex {
+    public:
+        /**
+         * @brief Construct a new RangeIndex object.
+         *
+         * @param block_size number of samples per leaf summary. Larger blocks use less memory but scan more raw samples per query.
+         */
+        RangeIndex(size_t block_size = 64);
+
+        /**
+         * @brief Append a sample.
+         *
+         * @param value the sample value.
+         */
+        void add(double value);
+
+        /**
+         * @brief Summarize the samples with index in `[begin, end)`.
+         *
+         * @param begin index of the first sample, counting from 0.
+         * @param end one past the index of the last sample. Clamped to `::size()`.
+         * @return RangeSummary summary of the range, empty if the range is.
+         */
+        RangeSummary query(uint64_t begin, uint64_t end) const;
+
+        /**
+         * @brief Number of samples stored.
+         */
+        uint64_t size() const { return values.size(); }
+
+    private:
+        /**
+         * @brief Append a complete summary node to `level`, and combine it with its sibling into the level above.
+         */
+        void push(size_t level, const RangeSummary& node);
+
+        size_t block_size;
+        std::deque<float> values;
+        // levels[0] summarizes complete blocks, levels[k] summarizes pairs of nodes in levels[k - 1]:
+        std::vector<std::vector<RangeSummary>> levels;
+        RangeSummary partial;
+};
+
+/**
+ * @brief A RangeIndex with a timestamp for each sample, for queries by time.
+ */
+class TimedRangeIndex {
+    public:
+        TimedRangeIndex(size_t block_size = 64);
+
+        /**
+         * @brief Append a sample. Samples must be added in time order.
+         *
+         * @param time when the sample was observed.
+         * @param value the sample value.
+         */
+        void add(std::chrono::steady_clock::time_point time, double value);
+
+        /**
+         * @brief Summarize the samples observed in `[begin, end)`.
+         *
+         * @param begin earliest time to include.
+         * @param end time to stop at.
+         * @return RangeSummary summary of the samples in the range.
+         */
+        RangeSummary query(std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end) const;
+
+        uint64_t size() const { return index.size(); }
+
+    private:
+        /**
+         * @brief Index of the first sample observed at or after `time`.
+         */
+        uint64_t lower_bound(std::chrono::steady_clock::time_point time) const;
+
+        RangeIndex index;
+        std::deque<int64_t> times;
+};
+
+#endif
@@ -0,0 +1,89 @@
+#pragma once
+#ifndef RING_H
+#define RING_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief A fixed-capacity circular buffer that overwrites its oldest entry when full.
+ *
+ * All storage is allocated once, in the constructor. After that, `::push` never allocates, so the buffer is safe to fill from the polling path at any rate.
+ *
+ * @tparam T the stored type. Should be cheap to copy-assign.
+ */
+template <typename T>
+class RingBuffer {
+    public:
+        /**
+         * @brief Construct a new RingBuffer object.
+         *
+         * @param capacity maximum number of entries retained. Must be nonzero.
+         */
+        RingBuffer(size_t capacity): buffer(capacity > 0 ? capacity : 1), head(0), count(0), pushed(0) {};
+
+        /**
+         * @brief Append `item`, overwriting the oldest entry if the buffer is full.
+         *
+         * @param item the entry to store.
+         */
+        void push(const T& item) {
+            buffer[head] = item;
+            head = (head + 1) % buffer.size();
+            if (count < buffer.size()) {
+                ++count;
+            }
+            ++pushed;
+        }
+
+        /**
+         * @brief Access an entry by age.
+         *
+         * @param index 0 is the oldest retained entry, `::size() - 1` is the newest.
+         * @return const T& the entry.
+         */
+        const T& operator[](size_t index) const {
+            return buffer[(head + buffer.size() - count + index) % buffer.size()];
+        }
+
+        /**
+         * @brief Access the most recently pushed entry. Only valid if `::size() > 0`.
+         */
+        const T& back() const {
+            return buffer[(head + buffer.size() - 1) % buffer.size()];
+        }
+
+        /**
+         * @brief Number of entries currently retained.
+         */
+        size_t size() const { return count; }
+        /**
+         * @brief Maximum number of entries retained.
+         */
+        size_t capacity() const { return buffer.size(); }
+        /**
+         * @brief Total number of entries ever pushed, including overwritten ones.
+         */
+        uint64_t total() const { return pushed; }
+        /**
+         * @brief Check if the buffer has wrapped and is now overwriting entries.
+         */
+        bool full() const { return count == buffer.size(); }
+
+        /**
+         * @brief Forget all entries. Does not release storage.
+         */
+        void clear() {
+            head = 0;
+            count = 0;
+        }
+
+    private:
+        std::vector<T> buffer;
+        size_t head;
+        size_t count;
+        uint64_t pushed;
+};
+
+#endif
@@ -0,0 +1,135 @@
+#include "scheduler.h"
+#include "trace.h"
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+
+JitterHistogram::JitterHistogram(): worst(0) {
+    for (auto& c: counts) {
+        c = 0;
+    }
+}
+
+void JitterHistogram::add(std::chrono::nanoseconds lateness) {
+    int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(lateness).count();
+    size_t k = std::upper_bound(edges.begin(), edges.end(), us) - edges.begin();
+    counts[k].fetch_add(1, std::memory_order_relaxed);
+
+    int64_t ns = lateness.count();
+    int64_t previous = worst.load(std::memory_order_relaxed);
+    while (ns > previous && !worst.compare_exchange_weak(previous, ns, std::memory_order_relaxed)) {}
+}
+
+uint64_t JitterHistogram::count(size_t k) const {
+    return counts[k].load(std::memory_order_relaxed);
+}
+
+uint64_t JitterHistogram::total() const {
+    uint64_t result = 0;
+    for (auto& c: counts) {
+        result += c.load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+std::chrono::nanoseconds JitterHistogram::max() const {
+    return std::chrono::nanoseconds(worst.load(std::memory_order_relaxed));
+}
+
+// format a bucket edge given in microseconds
+static std::string format_us(int64_t us) {
+    if (us < 1000) {
+        return std::to_string(us) + " us";
+    }
+    return std::to_string(us / 1000) + " ms";
+}
+
+std::string JitterHistogram::label(size_t k) {
+    if (k < edges.size()) {
+        return "< " + format_us(edges[k]);
+    }
+    return ">= " + format_us(edges.back());
+}
+
+PeriodicScheduler::PeriodicScheduler(): stopping(false) {}
+
+PeriodicScheduler::~PeriodicScheduler() {
+    stop();
+}
+
+size_t PeriodicScheduler::add(std::string name, std::chrono::nanoseconds period, std::function<void(std::chrono::steady_clock::time_point)> run) {
+    tasks.emplace_back();
+    Task& task = tasks.back();
+    task.name = name;
+    task.period = period;
+    task.run = run;
+    task.runs = 0;
+    task.missed = 0;
+    return tasks.size() - 1;
+}
+
+void PeriodicScheduler::run() {
+    trace::set_thread_name("scheduler");
+    auto start = std::chrono::steady_clock::now();
+    for (auto& task: tasks) {
+        task.deadline = start + task.period;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping && !tasks.empty()) {
+        auto next = std::min_element(tasks.begin(), tasks.end(), [](const Task& a, const Task& b) {
+            return a.deadline < b.deadline;
+        })->deadline;
+
+        // sleep until an absolute deadline, so time spent in the tasks doesn't add to the period:
+        if (wake.wait_until(lock, next, [this] { return stopping; })) {
+            break;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        for (auto& task: tasks) {
+            if (task.deadline > now) {
+                continue;
+            }
+            lock.unlock();
+            {
+                trace::Span span("periodic task", "scheduler", task.name);
+                task.run(task.deadline);
+            }
+            lock.lock();
+
+            // step to the next deadline, skipping (and counting) any that have already passed:
+            task.deadline += task.period;
+            now = std::chrono::steady_clock::now();
+            if (task.deadline <= now) {
+                int64_t skipped = (now - task.deadline) / task.period + 1;
+                task.deadline += skipped * task.period;
+                task.missed += skipped;
+            }
+        }
+    }
+}
+
+void PeriodicScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+}
+
+void PeriodicScheduler::record(size_t index, std::chrono::steady_clock::time_point deadline) {
+    Task& task = tasks[index];
+    auto lateness = std::max(std::chrono::steady_clock::now() - deadline, std::chrono::steady_clock::duration::zero());
+    task.jitter.add(lateness);
+    ++task.runs;
+}
+
+std::string PeriodicScheduler::summary(size_t index) const {
+    const Task& task = tasks[index];
+    std::stringstream result;
+    result << task.name << " every " << std::chrono::duration_cast<std::chrono::milliseconds>(task.period).count() << " ms: ";
+    result << task.runs << " runs, " << task.missed << " missed, max ";
+    result << std::fixed << std::setprecision(1) << std::chrono::duration<double, std::milli>(task.jitter.max()).count() << " ms late";
+    return result.str();
+}
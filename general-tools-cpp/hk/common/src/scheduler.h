@@ -0,0 +1,138 @@
+#pragma once
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <vector>
+#include <deque>
+#include <array>
+#include <string>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
+
+/**
+ * @brief Counts of how late periodic work started, in fixed buckets from 100 µs to 100 ms.
+ *
+ * Counters are atomic, so the histogram can be filled from one thread and read from another.
+ */
+class JitterHistogram {
+    public:
+        /**
+         * @brief Upper edge of each bucket in microseconds. The last bucket holds everything later.
+         */
+        static constexpr std::array<int64_t, 9> edges = {100, 500, 1000, 2000, 5000, 10000, 20000, 50000, 100000};
+        static constexpr size_t bucket_count = edges.size() + 1;
+
+        JitterHistogram();
+
+        /**
+         * @brief Count one start that was `lateness` after its deadline.
+         */
+        void add(std::chrono::nanoseconds lateness);
+
+        /**
+         * @brief Number of starts counted in bucket `k`.
+         */
+        uint64_t count(size_t k) const;
+        /**
+         * @brief Total number of starts counted.
+         */
+        uint64_t total() const;
+        /**
+         * @brief Largest lateness counted.
+         */
+        std::chrono::nanoseconds max() const;
+        /**
+         * @brief Short label for bucket `k`, like "< 1 ms" or ">= 100 ms".
+         */
+        static std::string label(size_t k);
+
+    private:
+        std::array<std::atomic<uint64_t>, bucket_count> counts;
+        std::atomic<int64_t> worst;
+};
+
+/**
+ * @brief Runs periodic tasks on absolute deadlines, so the period doesn't drift with the time the work takes.
+ *
+ * Each task's deadlines are `start + n * period`. After running a task, the scheduler waits until the next deadline rather than sleeping for a fixed time, so the time spent polling (or waiting in the UI queue) doesn't accumulate. If a deadline is missed entirely, it is counted and skipped, keeping later deadlines in phase instead of bursting to catch up.
+ *
+ * Task callbacks are given the deadline they were run for. If the real work happens elsewhere (e.g. posted to the UI thread), the worker should call `::record` with that deadline when it starts, so jitter is measured where the sample is actually taken.
+ */
+class PeriodicScheduler {
+    public:
+        /**
+         * @brief State and timing statistics for one periodic task.
+         */
+        struct Task {
+            std::string name;
+            std::chrono::nanoseconds period;
+            std::function<void(std::chrono::steady_clock::time_point)> run;
+            std::chrono::steady_clock::time_point deadline;
+
+            /**
+             * @brief How late each run started after its deadline.
+             */
+            JitterHistogram jitter;
+            /**
+             * @brief Number of runs recorded.
+             */
+            std::atomic<uint64_t> runs;
+            /**
+             * @brief Deadlines skipped by the scheduler because they had passed before the task could run. Runs that merely start late show up in `jitter` instead.
+             */
+            std::atomic<uint64_t> missed;
+        };
+
+        PeriodicScheduler();
+        ~PeriodicScheduler();
+
+        /**
+         * @brief Add a task to run every `period`, starting one period from when `::run` is called.
+         *
+         * Tasks must all be added before `::run` is called.
+         *
+         * @param name display name for the task.
+         * @param period time between deadlines.
+         * @param run called at each deadline, on the scheduler's thread, with the deadline.
+         * @return size_t the index of the task in `::tasks`.
+         */
+        size_t add(std::string name, std::chrono::nanoseconds period, std::function<void(std::chrono::steady_clock::time_point)> run);
+
+        /**
+         * @brief Run tasks until `::stop` is called. Blocks, so call it on its own thread.
+         */
+        void run();
+        /**
+         * @brief Stop `::run`, waking it immediately if it is waiting.
+         */
+        void stop();
+
+        /**
+         * @brief Record that work for task `index` started now, for its `deadline`.
+         *
+         * @param index the task's index, from `::add`.
+         * @param deadline the deadline passed to the task's callback.
+         */
+        void record(size_t index, std::chrono::steady_clock::time_point deadline);
+
+        /**
+         * @brief Describe a task's timing in one line, like "adc every 500 ms: 1200 runs, 0 missed, max 3.2 ms late".
+         */
+        std::string summary(size_t index) const;
+
+        /**
+         * @brief The scheduled tasks. Held in a deque, so references stay valid as tasks are added.
+         */
+        std::deque<Task> tasks;
+
+    private:
+        std::mutex mutex;
+        std::condition_variable wake;
+        bool stopping;
+};
+
+#endif
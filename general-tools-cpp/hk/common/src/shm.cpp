@@ -0,0 +1,294 @@
+#include "shm.h"
+#include "timestamp.h"
+#include <atomic>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <thread>
+#include <fcntl.h>
+#include <signal.h>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// the sequence and published counters are shared with other processes, so they're accessed atomically in place:
+static std::atomic_ref<uint64_t> shared_u64(unsigned char* base, size_t offset) {
+    return std::atomic_ref<uint64_t>(*reinterpret_cast<uint64_t*>(base + offset));
+}
+
+static uint64_t load_u64(const unsigned char* base, size_t offset, std::memory_order order) {
+    return std::atomic_ref<uint64_t>(*const_cast<uint64_t*>(reinterpret_cast<const uint64_t*>(base + offset))).load(order);
+}
+
+template <typename T>
+static void put(unsigned char* base, size_t offset, T value) {
+    std::memcpy(base + offset, &value, sizeof(T));
+}
+
+template <typename T>
+static T get(const unsigned char* base, size_t offset) {
+    T value;
+    std::memcpy(&value, base + offset, sizeof(T));
+    return value;
+}
+
+ShmPublisher::ShmPublisher(std::string node, std::vector<std::string> names, size_t history_capacity):
+        node(node),
+        names(names),
+        history_capacity(std::max<size_t>(history_capacity, 1)),
+        base(nullptr),
+        count(0),
+        segment_device(0),
+        segment_inode(0)
+{
+    slot_size = shm_layout::slot_size(names.size());
+    latest_offset = (shm_layout::header_size + names.size() * shm_layout::name_size + 63) / 64 * 64;
+    history_offset = latest_offset + slot_size;
+    total_size = history_offset + this->history_capacity * slot_size;
+}
+
+ShmPublisher::~ShmPublisher() {
+    if (base) {
+        munmap(base, total_size);
+        // another publisher may have replaced the segment since (after deciding ours was stale); leave theirs alone.
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd >= 0) {
+            struct stat info;
+            bool ours = fstat(fd, &info) == 0 && info.st_dev == segment_device && info.st_ino == segment_inode;
+            close(fd);
+            if (ours) {
+                shm_unlink(name.c_str());
+            }
+        }
+    }
+}
+
+// the process ID of a live publisher of the existing segment `name`, or 0 if it has none (stale, or never finished its header)
+static pid_t live_writer(const std::string& name) {
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return 0;
+    }
+    struct stat info;
+    pid_t pid = 0;
+    if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= shm_layout::header_size) {
+        void* mapped = mmap(nullptr, shm_layout::header_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (mapped != MAP_FAILED) {
+            const unsigned char* header = static_cast<const unsigned char*>(mapped);
+            if (std::memcmp(header + shm_layout::magic_offset, shm_layout::magic, sizeof(shm_layout::magic)) == 0) {
+                pid = static_cast<pid_t>(get<uint32_t>(header, shm_layout::pid_offset));
+            }
+            munmap(mapped, shm_layout::header_size);
+        }
+    }
+    close(fd);
+    // EPERM means the process exists but belongs to someone else:
+    if (pid > 0 && (kill(pid, 0) == 0 || errno == EPERM)) {
+        return pid;
+    }
+    return 0;
+}
+
+bool ShmPublisher::open(std::string name, std::string& error) {
+    // never truncate a segment another process may be publishing into: create it exclusively, replacing it only if its writer is gone.
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0 && errno == EEXIST) {
+        pid_t writer = live_writer(name);
+        if (writer != 0) {
+            error = name + ": already in use by process " + std::to_string(writer);
+            return false;
+        }
+        shm_unlink(name.c_str());
+        fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd < 0 && errno == EEXIST) {
+            error = name + ": already in use";
+            return false;
+        }
+    }
+    if (fd < 0) {
+        error = "shm_open " + name + ": " + std::strerror(errno);
+        return false;
+    }
+    struct stat info;
+    if (ftruncate(fd, static_cast<off_t>(total_size)) != 0 || fstat(fd, &info) != 0) {
+        error = "ftruncate " + name + ": " + std::strerror(errno);
+        close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+    void* mapped = mmap(nullptr, total_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        error = "mmap " + name + ": " + std::strerror(errno);
+        shm_unlink(name.c_str());
+        return false;
+    }
+    segment_device = info.st_dev;
+    segment_inode = info.st_ino;
+    base = static_cast<unsigned char*>(mapped);
+    this->name = name;
+
+    // the header is written once, before anything is published; the magic goes last so readers don't see a half-written header.
+    const TimeAnchor& anchor = session_anchor();
+    put<uint32_t>(base, shm_layout::version_offset, shm_layout::version);
+    put<uint32_t>(base, shm_layout::channels_offset, static_cast<uint32_t>(names.size()));
+    put<uint32_t>(base, shm_layout::capacity_offset, static_cast<uint32_t>(history_capacity));
+    put<uint32_t>(base, shm_layout::slot_size_offset, static_cast<uint32_t>(slot_size));
+    put<uint64_t>(base, shm_layout::names_pointer_offset, shm_layout::header_size);
+    put<uint64_t>(base, shm_layout::latest_pointer_offset, latest_offset);
+    put<uint64_t>(base, shm_layout::history_pointer_offset, history_offset);
+    put<int64_t>(base, shm_layout::anchor_steady_offset, anchor.steady);
+    put<int64_t>(base, shm_layout::anchor_unix_offset, std::chrono::duration_cast<std::chrono::nanoseconds>(anchor.wall.time_since_epoch()).count());
+    put<uint32_t>(base, shm_layout::pid_offset, static_cast<uint32_t>(getpid()));
+    std::strncpy(reinterpret_cast<char*>(base + shm_layout::node_offset), node.c_str(), shm_layout::name_size - 1);
+    for (size_t k = 0; k < names.size(); ++k) {
+        std::strncpy(reinterpret_cast<char*>(base + shm_layout::header_size + k * shm_layout::name_size), names[k].c_str(), shm_layout::name_size - 1);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(base + shm_layout::magic_offset, shm_layout::magic, sizeof(shm_layout::magic));
+    return true;
+}
+
+void ShmPublisher::write_slot(size_t offset, uint64_t index, int64_t time, const std::vector<double>& values) {
+    unsigned char* slot = base + offset;
+    auto sequence = shared_u64(slot, shm_layout::slot_sequence_offset);
+    uint64_t before = sequence.load(std::memory_order_relaxed);
+
+    // odd while writing; the fence keeps the data stores after it.
+    sequence.store(before + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    put<uint64_t>(slot, shm_layout::slot_index_offset, index);
+    put<int64_t>(slot, shm_layout::slot_time_offset, time);
+    for (size_t k = 0; k < names.size(); ++k) {
+        double value = k < values.size() ? values[k] : std::numeric_limits<double>::quiet_NaN();
+        put<double>(slot, shm_layout::slot_values_offset + k * sizeof(double), value);
+    }
+
+    sequence.store(before + 2, std::memory_order_release);
+}
+
+void ShmPublisher::publish(int64_t time, const std::vector<double>& values) {
+    if (!base) {
+        return;
+    }
+    write_slot(history_offset + (count % history_capacity) * slot_size, count, time, values);
+    write_slot(latest_offset, count, time, values);
+    ++count;
+    shared_u64(base, shm_layout::published_offset).store(count, std::memory_order_release);
+}
+
+ShmReader::ShmReader(): history_capacity(0), base(nullptr), total_size(0), slot_size(0), latest_offset(0), history_offset(0) {}
+
+ShmReader::~ShmReader() {
+    if (base) {
+        munmap(const_cast<unsigned char*>(base), total_size);
+    }
+}
+
+bool ShmReader::open(std::string name, std::string& error) {
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        error = "shm_open " + name + ": " + std::strerror(errno);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < shm_layout::header_size) {
+        error = name + " is too small to be a housekeeping segment";
+        close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        error = "mmap " + name + ": " + std::strerror(errno);
+        return false;
+    }
+    base = static_cast<const unsigned char*>(mapped);
+    total_size = info.st_size;
+    if (!check_header(name, error)) {
+        munmap(mapped, total_size);
+        base = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool ShmReader::check_header(const std::string& name, std::string& error) {
+    if (std::memcmp(base + shm_layout::magic_offset, shm_layout::magic, sizeof(shm_layout::magic)) != 0) {
+        error = name + " has no housekeeping header";
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (get<uint32_t>(base, shm_layout::version_offset) != shm_layout::version) {
+        error = name + " has layout version " + std::to_string(get<uint32_t>(base, shm_layout::version_offset));
+        return false;
+    }
+    size_t channels = get<uint32_t>(base, shm_layout::channels_offset);
+    history_capacity = get<uint32_t>(base, shm_layout::capacity_offset);
+    slot_size = get<uint32_t>(base, shm_layout::slot_size_offset);
+    latest_offset = get<uint64_t>(base, shm_layout::latest_pointer_offset);
+    history_offset = get<uint64_t>(base, shm_layout::history_pointer_offset);
+    if (history_offset + history_capacity * slot_size > total_size || slot_size < shm_layout::slot_size(channels)) {
+        error = name + " is smaller than its header says";
+        return false;
+    }
+
+    const char* text = reinterpret_cast<const char*>(base);
+    node = std::string(text + shm_layout::node_offset, strnlen(text + shm_layout::node_offset, shm_layout::name_size));
+    size_t names_offset = get<uint64_t>(base, shm_layout::names_pointer_offset);
+    names.clear();
+    for (size_t k = 0; k < channels; ++k) {
+        const char* entry = text + names_offset + k * shm_layout::name_size;
+        names.push_back(std::string(entry, strnlen(entry, shm_layout::name_size)));
+    }
+    return true;
+}
+
+uint64_t ShmReader::published() const {
+    if (!base) {
+        return 0;
+    }
+    return load_u64(base, shm_layout::published_offset, std::memory_order_acquire);
+}
+
+bool ShmReader::read_slot(size_t offset, ShmSample& out) const {
+    const unsigned char* slot = base + offset;
+    out.values.resize(names.size());
+    for (size_t attempt = 0; attempt < read_retries; ++attempt) {
+        uint64_t before = load_u64(slot, shm_layout::slot_sequence_offset, std::memory_order_acquire);
+        if (before % 2 == 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        out.index = get<uint64_t>(slot, shm_layout::slot_index_offset);
+        out.time = get<int64_t>(slot, shm_layout::slot_time_offset);
+        std::memcpy(out.values.data(), slot + shm_layout::slot_values_offset, names.size() * sizeof(double));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (load_u64(slot, shm_layout::slot_sequence_offset, std::memory_order_relaxed) == before) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ShmReader::latest(ShmSample& out) const {
+    if (published() == 0) {
+        return false;
+    }
+    return read_slot(latest_offset, out);
+}
+
+bool ShmReader::history(uint64_t index, ShmSample& out) const {
+    uint64_t count = published();
+    if (index >= count || count - index > history_capacity) {
+        return false;
+    }
+    if (!read_slot(history_offset + (index % history_capacity) * slot_size, out)) {
+        return false;
+    }
+    // the slot may have been reused since `published` was read:
+    return out.index == index;
+}
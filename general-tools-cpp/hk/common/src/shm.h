@@ -0,0 +1,210 @@
+#pragma once
+#ifndef SHM_H
+#define SHM_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <sys/types.h>
+
+/**
+ * @brief Layout of the shared-memory segment published by `ShmPublisher` (version 1).
+ *
+ * All integers and doubles are in the machine's native byte order (little-endian on every GSE machine). Offsets are in bytes from the start of the segment.
+ *
+ * Header, 128 bytes at offset 0:
+ * | offset | type        | field                                                           |
+ * |--------|-------------|-----------------------------------------------------------------|
+ * | 0      | char[8]     | magic, "FOXSIHK\0"                                              |
+ * | 8      | uint32      | layout version, 1                                               |
+ * | 12     | uint32      | channel count `n`                                               |
+ * | 16     | uint32      | history capacity `h` (slots)                                    |
+ * | 20     | uint32      | slot size in bytes                                              |
+ * | 24     | uint64      | offset of channel names (`n` × 32-byte NUL-padded strings)      |
+ * | 32     | uint64      | offset of the latest-sample slot                                |
+ * | 40     | uint64      | offset of the history ring (`h` slots)                          |
+ * | 48     | int64       | time anchor: steady-clock ns...                                 |
+ * | 56     | int64       | ...equal to this Unix time in ns                                |
+ * | 64     | uint64      | samples published so far (updated after each sample is written)|
+ * | 72     | uint32      | writer process ID                                               |
+ * | 76     | uint32      | reserved                                                        |
+ * | 80     | char[32]    | node name, e.g. "ptui"                                          |
+ *
+ * Each slot (64-byte aligned, slot size bytes):
+ * | offset | type        | field                                                           |
+ * |--------|-------------|-----------------------------------------------------------------|
+ * | 0      | uint64      | sequence: odd while being written, even when stable             |
+ * | 8      | uint64      | sample number, counting from 0                                  |
+ * | 16     | int64       | sample time, steady-clock ns (Unix ns = anchor Unix + time - anchor steady) |
+ * | 24     | double[n]   | channel values, NaN where a channel had no valid reading        |
+ *
+ * Sample `i` is in the latest slot until sample `i + 1` is published, and in history slot `i % h` until sample `i + h`.
+ *
+ * Reading a slot (seqlock): read the sequence; if it is odd, try again. Copy the slot. Read the sequence again; if it changed, the copy may be torn, so try again. Readers never write to the segment and never block the publisher.
+ */
+namespace shm_layout {
+    static constexpr char magic[8] = {'F', 'O', 'X', 'S', 'I', 'H', 'K', '\0'};
+    static constexpr uint32_t version = 1;
+    static constexpr size_t header_size = 128;
+    static constexpr size_t name_size = 32;
+
+    static constexpr size_t magic_offset = 0;
+    static constexpr size_t version_offset = 8;
+    static constexpr size_t channels_offset = 12;
+    static constexpr size_t capacity_offset = 16;
+    static constexpr size_t slot_size_offset = 20;
+    static constexpr size_t names_pointer_offset = 24;
+    static constexpr size_t latest_pointer_offset = 32;
+    static constexpr size_t history_pointer_offset = 40;
+    static constexpr size_t anchor_steady_offset = 48;
+    static constexpr size_t anchor_unix_offset = 56;
+    static constexpr size_t published_offset = 64;
+    static constexpr size_t pid_offset = 72;
+    static constexpr size_t node_offset = 80;
+
+    static constexpr size_t slot_sequence_offset = 0;
+    static constexpr size_t slot_index_offset = 8;
+    static constexpr size_t slot_time_offset = 16;
+    static constexpr size_t slot_values_offset = 24;
+
+    /**
+     * @brief Size of one slot for `channels` values, rounded up to a cache line.
+     */
+    constexpr size_t slot_size(size_t channels) {
+        return (slot_values_offset + channels * sizeof(double) + 63) / 64 * 64;
+    }
+};
+
+/**
+ * @brief One sample read back from a shared-memory segment.
+ */
+struct ShmSample {
+    uint64_t index;
+    int64_t time;
+    std::vector<double> values;
+};
+
+/**
+ * @brief Publishes each decoded sample, and a short history of them, to a POSIX shared-memory segment for other local programs.
+ *
+ * The layout is documented in `shm_layout`. Publishing is two seqlock-protected slot writes and never waits for readers; any number of readers can poll the segment without locks or copies through the kernel. A reader for Python is in `general-tools-py/hkshm`.
+ */
+class ShmPublisher {
+    public:
+        /**
+         * @brief Construct a new ShmPublisher object. Nothing is published until `::open` succeeds.
+         *
+         * @param node name of the publishing node, stored in the header.
+         * @param names name of each channel.
+         * @param history_capacity number of recent samples kept in the history ring.
+         */
+        ShmPublisher(std::string node, std::vector<std::string> names, size_t history_capacity);
+        /**
+         * @brief Unmap the segment, and unlink it unless another publisher has replaced it since.
+         */
+        ~ShmPublisher();
+
+        /**
+         * @brief Create the segment `name` and write its header. A segment left behind by a process that has exited is replaced; one whose writer is still running is left alone.
+         *
+         * @param name POSIX shared-memory name, like "/foxsi_hk_ptui". On Linux it appears as `/dev/shm/foxsi_hk_ptui`.
+         * @param error set to a description of the problem if the segment couldn't be created, like "/foxsi_hk_ptui: already in use by process 1234".
+         * @return true if samples will now be published.
+         */
+        bool open(std::string name, std::string& error);
+        /**
+         * @brief Check whether the segment is open.
+         */
+        bool is_open() const { return base != nullptr; }
+
+        /**
+         * @brief Publish one sample.
+         *
+         * @param time sample time, in `steady_clock` nanoseconds (see `steady_ns`).
+         * @param values one value per channel. Missing values are published as NaN, extras are ignored.
+         */
+        void publish(int64_t time, const std::vector<double>& values);
+
+        /**
+         * @brief Number of samples published.
+         */
+        uint64_t published() const { return count; }
+        /**
+         * @brief Name of the open segment, or empty.
+         */
+        std::string name;
+
+    private:
+        void write_slot(size_t offset, uint64_t index, int64_t time, const std::vector<double>& values);
+
+        std::string node;
+        std::vector<std::string> names;
+        size_t history_capacity;
+        size_t slot_size;
+        size_t latest_offset;
+        size_t history_offset;
+        size_t total_size;
+
+        unsigned char* base;
+        uint64_t count;
+        // identity of the segment this publisher created, so it only ever unlinks its own
+        dev_t segment_device;
+        ino_t segment_inode;
+};
+
+/**
+ * @brief Reads samples from a segment written by `ShmPublisher`, without locking.
+ */
+class ShmReader {
+    public:
+        ShmReader();
+        ~ShmReader();
+
+        /**
+         * @brief Map the segment `name` read-only and check its header.
+         *
+         * @return true if the segment is open and has a layout this reader understands.
+         */
+        bool open(std::string name, std::string& error);
+
+        /**
+         * @brief Copy the latest sample into `out`.
+         *
+         * @return false if nothing has been published yet, or the slot stayed mid-write for `read_retries` attempts (the publisher died while writing it).
+         */
+        bool latest(ShmSample& out) const;
+        /**
+         * @brief Copy sample number `index` from the history ring into `out`.
+         *
+         * @return false if that sample hasn't been published yet, has been overwritten, or couldn't be read (see `::latest`).
+         */
+        bool history(uint64_t index, ShmSample& out) const;
+        /**
+         * @brief Number of samples published so far.
+         */
+        uint64_t published() const;
+
+        std::string node;
+        std::vector<std::string> names;
+        size_t history_capacity;
+
+        /**
+         * @brief Attempts at reading a slot before giving up on it. A write takes well under a microsecond, so only a publisher that stopped mid-write uses them all.
+         */
+        static constexpr size_t read_retries = 10000;
+
+    private:
+        // read the layout from the header, checking it fits in the segment.
+        bool check_header(const std::string& name, std::string& error);
+        // copy the slot at `offset`, retrying while it's being written, up to `read_retries` times.
+        bool read_slot(size_t offset, ShmSample& out) const;
+
+        const unsigned char* base;
+        size_t total_size;
+        size_t slot_size;
+        size_t latest_offset;
+        size_t history_offset;
+};
+
+#endif
@@ -0,0 +1,19 @@
+#include "signals.h"
+#include <pthread.h>
+
+ShutdownSignal::ShutdownSignal() {
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, &previous);
+}
+
+ShutdownSignal::~ShutdownSignal() {
+    pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+}
+
+int ShutdownSignal::wait() {
+    int received = 0;
+    while (sigwait(&signals, &received) != 0) {}
+    return received;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#ifndef SIGNALS_H
+#define SIGNALS_H
+
+#include <csignal>
+
+/**
+ * @brief Waits for SIGINT or SIGTERM, for clean shutdown of headless programs.
+ *
+ * Construct this at the top of `main`, before any threads start: it blocks the signals in the calling thread, and threads inherit that, so the signals are only ever delivered to `::wait`. Nothing runs in signal-handler context, so shutdown can do anything (join threads, write files).
+ */
+class ShutdownSignal {
+    public:
+        ShutdownSignal();
+        /**
+         * @brief Unblock the signals again.
+         */
+        ~ShutdownSignal();
+
+        /**
+         * @brief Block the calling thread (without using any CPU) until SIGINT or SIGTERM arrives.
+         *
+         * @return the signal number received.
+         */
+        int wait();
+
+    private:
+        sigset_t signals;
+        sigset_t previous;
+};
+
+#endif
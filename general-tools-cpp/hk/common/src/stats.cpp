@@ -0,0 +1,168 @@
+#include "stats.h"
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <iomanip>
+
+RunningStats::RunningStats() {
+    reset();
+}
+
+void RunningStats::reset() {
+    n = 0;
+    mu = 0.0;
+    m2 = 0.0;
+    lo = std::numeric_limits<double>::infinity();
+    hi = -std::numeric_limits<double>::infinity();
+}
+
+void RunningStats::add(double value) {
+    ++n;
+    double delta = value - mu;
+    mu += delta / n;
+    m2 += delta * (value - mu);
+    lo = std::min(lo, value);
+    hi = std::max(hi, value);
+}
+
+void RunningStats::merge(const RunningStats& other) {
+    if (other.n == 0) {
+        return;
+    }
+    if (n == 0) {
+        *this = other;
+        return;
+    }
+    uint64_t total = n + other.n;
+    double delta = other.mu - mu;
+    mu += delta * other.n / total;
+    m2 += other.m2 + delta * delta * (static_cast<double>(n) * other.n / total);
+    n = total;
+    lo = std::min(lo, other.lo);
+    hi = std::max(hi, other.hi);
+}
+
+double RunningStats::mean() const {
+    return n > 0 ? mu : std::numeric_limits<double>::quiet_NaN();
+}
+
+double RunningStats::variance() const {
+    return n > 1 ? m2 / (n - 1) : 0.0;
+}
+
+double RunningStats::stddev() const {
+    return std::sqrt(variance());
+}
+
+double RunningStats::min() const {
+    return n > 0 ? lo : std::numeric_limits<double>::quiet_NaN();
+}
+
+double RunningStats::max() const {
+    return n > 0 ? hi : std::numeric_limits<double>::quiet_NaN();
+}
+
+WindowedStats::WindowedStats(std::chrono::nanoseconds window, size_t bucket_count):
+        width(window / (bucket_count > 0 ? bucket_count : 1)),
+        buckets(bucket_count > 0 ? bucket_count : 1),
+        bucket_ids(bucket_count > 0 ? bucket_count : 1, std::numeric_limits<int64_t>::min())
+{}
+
+int64_t WindowedStats::bucket_index(std::chrono::steady_clock::time_point time) const {
+    return time.time_since_epoch() / width;
+}
+
+void WindowedStats::add(std::chrono::steady_clock::time_point time, double value) {
+    int64_t id = bucket_index(time);
+    size_t slot = static_cast<size_t>(id % static_cast<int64_t>(buckets.size()));
+    if (bucket_ids[slot] != id) {
+        // this slot last held a bucket from an older lap around the ring.
+        buckets[slot].reset();
+        bucket_ids[slot] = id;
+    }
+    buckets[slot].add(value);
+}
+
+RunningStats WindowedStats::query(std::chrono::steady_clock::time_point now) const {
+    int64_t newest = bucket_index(now);
+    int64_t oldest = newest - static_cast<int64_t>(buckets.size()) + 1;
+    RunningStats result;
+    for (size_t k = 0; k < buckets.size(); ++k) {
+        if (bucket_ids[k] >= oldest && bucket_ids[k] <= newest) {
+            result.merge(buckets[k]);
+        }
+    }
+    return result;
+}
+
+ChannelStats::ChannelStats():
+        second(std::chrono::seconds(1), 10),
+        minute(std::chrono::minutes(1), 60),
+        hour(std::chrono::hours(1), 60)
+{}
+
+void ChannelStats::add(std::chrono::steady_clock::time_point time, double value) {
+    session.add(value);
+    second.add(time, value);
+    minute.add(time, value);
+    hour.add(time, value);
+}
+
+StatsBank::StatsBank(std::vector<std::string> names, std::string rollup_path, std::chrono::seconds rollup_period):
+        names(names),
+        channels(names.size()),
+        rollup_period(rollup_period)
+{
+    last_rollup = std::chrono::steady_clock::now();
+    rollup_first = true;
+    if (rollup_path != "") {
+        rollup_file.open(rollup_path, std::ios::out | std::ios::app);
+    }
+}
+
+void StatsBank::add(size_t channel, std::chrono::steady_clock::time_point time, double value) {
+    if (channel < channels.size()) {
+        channels[channel].add(time, value);
+    }
+}
+
+bool StatsBank::rollup(std::chrono::steady_clock::time_point now, const std::string& time_tag) {
+    if (!rollup_file.is_open() || now - last_rollup < rollup_period) {
+        return false;
+    }
+    last_rollup = now;
+
+    std::stringstream out;
+    if (rollup_first) {
+        out << "Time,Channel,Window,Count,Mean,Stddev,Min,Max\n";
+        rollup_first = false;
+    }
+    for (size_t k = 0; k < channels.size(); ++k) {
+        std::vector<std::pair<std::string, RunningStats>> windows = {
+            {"1 min", channels[k].minute.query(now)},
+            {"1 h", channels[k].hour.query(now)},
+            {"session", channels[k].session}
+        };
+        for (auto& w: windows) {
+            out << time_tag << "," << names[k] << "," << w.first << "," << w.second.count();
+            out << std::fixed << std::setprecision(4);
+            out << "," << w.second.mean() << "," << w.second.stddev() << "," << w.second.min() << "," << w.second.max() << "\n";
+        }
+    }
+    rollup_file << out.str();
+    rollup_file.flush();
+    return true;
+}
+
+std::vector<std::string> StatsBank::columns(const RunningStats& stats, int precision) {
+    if (stats.count() == 0) {
+        return {"-", "-", "-", "-"};
+    }
+    std::vector<std::string> result;
+    for (double v: {stats.mean(), stats.stddev(), stats.min(), stats.max()}) {
+        std::stringstream stream;
+        stream << std::fixed << std::setprecision(precision) << v;
+        result.push_back(stream.str());
+    }
+    return result;
+}
@@ -0,0 +1,169 @@
+#pragma once
+#ifndef STATS_H
+#define STATS_H
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <fstream>
+#include <cstdint>
+
+/**
+ * @brief Running count, mean, variance and extrema of a stream of values.
+ *
+ * Uses Welford's algorithm, so each update is O(1) and numerically stable over long sessions.
+ */
+class RunningStats {
+    public:
+        RunningStats();
+
+        /**
+         * @brief Add a new value to the statistics.
+         *
+         * @param value the new value.
+         */
+        void add(double value);
+        /**
+         * @brief Combine another set of statistics into this one (Chan et al. parallel update).
+         *
+         * @param other the statistics to merge in.
+         */
+        void merge(const RunningStats& other);
+        /**
+         * @brief Forget all values.
+         */
+        void reset();
+
+        uint64_t count() const { return n; }
+        double mean() const;
+        /**
+         * @brief Sample variance of the values added so far. Zero for fewer than two values.
+         */
+        double variance() const;
+        double stddev() const;
+        double min() const;
+        double max() const;
+
+    private:
+        uint64_t n;
+        double mu;
+        double m2;
+        double lo;
+        double hi;
+};
+
+/**
+ * @brief Statistics over a sliding time window, kept in a fixed ring of buckets.
+ *
+ * The window is divided into `bucket_count` buckets. Each new value is merged into the bucket for its time, and old buckets are recycled as time moves on, so adding a value is O(1) and memory is fixed. Queries merge the live buckets, which is O(`bucket_count`).
+ */
+class WindowedStats {
+    public:
+        /**
+         * @brief Construct a new WindowedStats object.
+         *
+         * @param window total length of the window.
+         * @param bucket_count number of buckets the window is divided into.
+         */
+        WindowedStats(std::chrono::nanoseconds window, size_t bucket_count);
+
+        /**
+         * @brief Add a value observed at `time`.
+         *
+         * @param time when the value was observed.
+         * @param value the new value.
+         */
+        void add(std::chrono::steady_clock::time_point time, double value);
+        /**
+         * @brief Get statistics for values in the window ending at `now`.
+         *
+         * @param now the end of the window.
+         * @return RunningStats merged statistics of all live buckets.
+         */
+        RunningStats query(std::chrono::steady_clock::time_point now) const;
+        /**
+         * @brief The length of the window.
+         */
+        std::chrono::nanoseconds window() const { return width * buckets.size(); }
+
+    private:
+        int64_t bucket_index(std::chrono::steady_clock::time_point time) const;
+
+        std::chrono::nanoseconds width;
+        std::vector<RunningStats> buckets;
+        std::vector<int64_t> bucket_ids;
+};
+
+/**
+ * @brief Session-long and windowed (1 s, 1 min, 1 h) statistics for one channel.
+ */
+class ChannelStats {
+    public:
+        ChannelStats();
+
+        /**
+         * @brief Add a value observed at `time` to every window.
+         */
+        void add(std::chrono::steady_clock::time_point time, double value);
+
+        /**
+         * @brief Statistics since the start of the session.
+         */
+        RunningStats session;
+        WindowedStats second;
+        WindowedStats minute;
+        WindowedStats hour;
+};
+
+/**
+ * @brief Statistics for a set of named channels, with periodic rollups to a log file.
+ */
+class StatsBank {
+    public:
+        /**
+         * @brief Construct a new StatsBank object.
+         *
+         * @param names display name for each channel. Sets the number of channels.
+         * @param rollup_path file to append periodic rollups to. Empty to disable rollups.
+         * @param rollup_period how often to write rollups.
+         */
+        StatsBank(std::vector<std::string> names, std::string rollup_path, std::chrono::seconds rollup_period);
+
+        /**
+         * @brief Add a value for one channel.
+         *
+         * @param channel index into `::names`.
+         * @param time when the value was observed.
+         * @param value the new value.
+         */
+        void add(size_t channel, std::chrono::steady_clock::time_point time, double value);
+
+        /**
+         * @brief Write a rollup of every channel if `rollup_period` has passed since the last one.
+         *
+         * @param now the current time.
+         * @param time_tag wall-clock time to write in each row, in the application's log time format.
+         * @return true if a rollup was written.
+         */
+        bool rollup(std::chrono::steady_clock::time_point now, const std::string& time_tag);
+
+        /**
+         * @brief Format `stats` as {mean, stddev, min, max} strings for display.
+         *
+         * @param stats the statistics to format.
+         * @param precision number of digits after the decimal point.
+         * @return std::vector<std::string> four formatted columns, or dashes if `stats` is empty.
+         */
+        static std::vector<std::string> columns(const RunningStats& stats, int precision);
+
+        std::vector<std::string> names;
+        std::vector<ChannelStats> channels;
+
+    private:
+        std::ofstream rollup_file;
+        std::chrono::seconds rollup_period;
+        std::chrono::steady_clock::time_point last_rollup;
+        bool rollup_first;
+};
+
+#endif
@@ -0,0 +1,100 @@
+#include "timestamp.h"
+#include <cstdlib>
+#include <ctime>
+#include <istream>
+#include <ostream>
+#include <iomanip>
+#include <sstream>
+
+std::string format_time(std::chrono::system_clock::time_point time) {
+    char time_format[std::size("yyyy-mm-dd_hh-mm-ss")];
+    std::time_t seconds = std::chrono::system_clock::to_time_t(time);
+    auto millisec = std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count() % 1000;
+
+    std::strftime(std::data(time_format), std::size(time_format), "%F_%H-%M-%S", std::gmtime(&seconds));
+
+    std::stringstream result;
+    result << time_format << "-" << std::setw(3) << std::setfill('0') << millisec;
+    return result.str();
+}
+
+TimeAnchor TimeAnchor::capture() {
+    TimeAnchor best{std::chrono::system_clock::now(), steady_now_ns()};
+    int64_t best_gap = INT64_MAX;
+    for (int k = 0; k < 5; ++k) {
+        // bracket the wall-clock read with steady reads, and keep the tightest bracket:
+        int64_t before = steady_now_ns();
+        auto wall = std::chrono::system_clock::now();
+        int64_t after = steady_now_ns();
+        if (after - before < best_gap) {
+            best_gap = after - before;
+            best = TimeAnchor{wall, before + (after - before) / 2};
+        }
+    }
+    return best;
+}
+
+std::chrono::system_clock::time_point TimeAnchor::to_wall(int64_t steady_time) const {
+    return wall + std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(steady_time - steady));
+}
+
+std::string TimeAnchor::header() const {
+    std::stringstream result;
+    int64_t wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(wall.time_since_epoch()).count();
+    result << "# time anchor: steady_ns " << steady << " = unix_ns " << wall_ns << " (" << format_time(wall) << " UTC)";
+    return result.str();
+}
+
+bool TimeAnchor::parse(const std::string& line, TimeAnchor& anchor) {
+    std::stringstream words(line);
+    std::string hash, time, label, steady_label, equals, unix_label;
+    int64_t steady = 0;
+    int64_t wall_ns = 0;
+    words >> hash >> time >> label >> steady_label >> steady >> equals >> unix_label >> wall_ns;
+    if (!words || hash != "#" || time != "time" || label != "anchor:" || steady_label != "steady_ns" || equals != "=" || unix_label != "unix_ns") {
+        return false;
+    }
+    anchor.steady = steady;
+    anchor.wall = std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(wall_ns)));
+    return true;
+}
+
+const TimeAnchor& session_anchor() {
+    static const TimeAnchor anchor = TimeAnchor::capture();
+    return anchor;
+}
+
+bool export_wall_clock(std::istream& in, std::ostream& out, std::string& error) {
+    TimeAnchor anchor{};
+    bool anchored = false;
+    bool header = false;
+    std::string line;
+    for (size_t number = 1; std::getline(in, line); ++number) {
+        if (line.empty()) {
+            continue;
+        }
+        if (line[0] == '#') {
+            anchored = TimeAnchor::parse(line, anchor) || anchored;
+            continue;
+        }
+        if (line.rfind("Steady ns", 0) == 0) {
+            if (!header) {
+                out << "Time," << line << "\n";
+                header = true;
+            }
+            continue;
+        }
+        char* end = nullptr;
+        long long steady = std::strtoll(line.c_str(), &end, 10);
+        if (end == line.c_str() || (*end != ',' && *end != '\0')) {
+            error = "line " + std::to_string(number) + " doesn't start with a steady time";
+            return false;
+        }
+        if (!anchored) {
+            error = "line " + std::to_string(number) + " comes before any time anchor";
+            return false;
+        }
+        out << format_time(anchor.to_wall(steady)) << "," << line << "\n";
+    }
+    return true;
+}
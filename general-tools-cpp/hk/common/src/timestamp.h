@@ -0,0 +1,79 @@
+#pragma once
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+#include <string>
+#include <iosfwd>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @brief Nanoseconds on `std::chrono::steady_clock` for `time`.
+ *
+ * Samples are stamped with these: reading the steady clock is a single vDSO call, the values never jump backwards, and they can be converted to wall-clock time later with a `TimeAnchor`.
+ */
+inline int64_t steady_ns(std::chrono::steady_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+/**
+ * @brief Nanoseconds on `std::chrono::steady_clock`, now.
+ */
+inline int64_t steady_now_ns() {
+    return steady_ns(std::chrono::steady_clock::now());
+}
+
+/**
+ * @brief Format `time` in UTC as `yyyy-mm-dd_hh-mm-ss-mmm`, the time format of every log name and log line.
+ */
+std::string format_time(std::chrono::system_clock::time_point time);
+
+/**
+ * @brief A matching pair of wall-clock and steady-clock readings, used to convert steady timestamps to wall-clock time.
+ *
+ * Each log records one anchor in its header, and every sample in it is stamped only with steady-clock nanoseconds. Wall-clock time for a sample is `wall + (sample - steady)`, which is only worked out when a file is exported or displayed.
+ */
+struct TimeAnchor {
+    std::chrono::system_clock::time_point wall;
+    int64_t steady;
+
+    /**
+     * @brief Read both clocks now.
+     *
+     * Takes the closest of a few back-to-back readings, so the pair is accurate to well under a microsecond.
+     */
+    static TimeAnchor capture();
+
+    /**
+     * @brief Convert a steady-clock timestamp (see `steady_ns`) to wall-clock time.
+     */
+    std::chrono::system_clock::time_point to_wall(int64_t steady_time) const;
+
+    /**
+     * @brief A log header line recording this anchor, starting with `#`.
+     */
+    std::string header() const;
+
+    /**
+     * @brief Read an anchor back from a line written by `::header`.
+     *
+     * @return false, leaving `anchor` alone, if `line` isn't an anchor line.
+     */
+    static bool parse(const std::string& line, TimeAnchor& anchor);
+};
+
+/**
+ * @brief The anchor for this session, captured the first time it is called.
+ */
+const TimeAnchor& session_anchor();
+
+/**
+ * @brief Copy a CSV log stamped in steady time (a `TimeAnchor::header` line, then a header row and data rows starting with `Steady ns`) to `out` with a wall-clock `Time` column in front, as capture files have.
+ *
+ * An anchor line partway through (from a later session appending to the file) applies to the rows after it, and repeated header rows are dropped.
+ *
+ * @return false if the file has no anchor before its first row, or a row doesn't start with a steady time. `error` says which line.
+ */
+bool export_wall_clock(std::istream& in, std::ostream& out, std::string& error);
+
+#endif
@@ -0,0 +1,236 @@
+#include "trace.h"
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <fstream>
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+
+namespace trace {
+    std::atomic<bool> active{false};
+
+    namespace {
+        // events each thread can record before further ones are dropped (about 6 MB per thread)
+        constexpr size_t buffer_events = 1 << 16;
+
+        struct Event {
+            const char* name;
+            const char* category;
+            int64_t start;
+            int64_t duration;   // -1 for instant events
+            char detail[detail_size];
+        };
+
+        // written only by its own thread; `count` is published with release ordering so `stop` can read it from another.
+        struct ThreadBuffer {
+            int tid;
+            std::string name;
+            std::vector<Event> events;
+            std::atomic<size_t> count{0};
+            std::atomic<size_t> dropped{0};
+        };
+
+        struct Registry {
+            std::mutex mutex;
+            std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+            std::string path;
+            int64_t origin = 0;
+        };
+
+        Registry& registry() {
+            static Registry instance;
+            return instance;
+        }
+
+        // the calling thread's buffer, registered the first time the thread records anything.
+        // Buffers are owned by the registry, so events survive their thread.
+        ThreadBuffer& local_buffer() {
+            thread_local ThreadBuffer* buffer = nullptr;
+            if (!buffer) {
+                auto made = std::make_unique<ThreadBuffer>();
+                made->events.resize(buffer_events);
+                Registry& r = registry();
+                std::lock_guard<std::mutex> lock(r.mutex);
+                made->tid = static_cast<int>(r.buffers.size()) + 1;
+                made->name = "thread " + std::to_string(made->tid);
+                buffer = made.get();
+                r.buffers.push_back(std::move(made));
+            }
+            return *buffer;
+        }
+
+        int64_t now_ns() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        void push(const char* name, const char* category, int64_t start, int64_t duration, const char* detail) {
+            ThreadBuffer& buffer = local_buffer();
+            size_t k = buffer.count.load(std::memory_order_relaxed);
+            if (k >= buffer.events.size()) {
+                buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            Event& event = buffer.events[k];
+            event.name = name;
+            event.category = category;
+            event.start = start;
+            event.duration = duration;
+            event.detail[0] = '\0';
+            if (detail) {
+                std::strncpy(event.detail, detail, sizeof(event.detail) - 1);
+                event.detail[sizeof(event.detail) - 1] = '\0';
+            }
+            buffer.count.store(k + 1, std::memory_order_release);
+        }
+
+        // write `text` as the body of a JSON string
+        void escape(std::ostream& out, const char* text) {
+            for (const char* c = text; *c; ++c) {
+                switch (*c) {
+                    case '"':  out << "\\\""; break;
+                    case '\\': out << "\\\\"; break;
+                    case '\n': out << "\\n"; break;
+                    case '\t': out << "\\t"; break;
+                    default:
+                        if (static_cast<unsigned char>(*c) < 0x20) {
+                            char code[8];
+                            std::snprintf(code, sizeof(code), "\\u%04x", *c);
+                            out << code;
+                        } else {
+                            out << *c;
+                        }
+                }
+            }
+        }
+
+        // trace-event timestamps are in microseconds
+        void micros(std::ostream& out, int64_t ns) {
+            char text[32];
+            long long magnitude = ns < 0 ? -static_cast<long long>(ns) : static_cast<long long>(ns);
+            std::snprintf(text, sizeof(text), "%s%lld.%03lld", ns < 0 ? "-" : "", magnitude / 1000, magnitude % 1000);
+            out << text;
+        }
+    }
+
+    bool start(const std::string& path) {
+        std::ofstream check(path, std::ios::out);
+        if (!check.is_open()) {
+            std::cerr << "couldn't open trace file " << path << "\n";
+            return false;
+        }
+        Registry& r = registry();
+        {
+            std::lock_guard<std::mutex> lock(r.mutex);
+            r.path = path;
+            r.origin = now_ns();
+        }
+        active.store(true, std::memory_order_relaxed);
+        return true;
+    }
+
+    void stop() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        if (r.path == "") {
+            return;
+        }
+        active.store(false, std::memory_order_relaxed);
+
+        std::ofstream out(r.path, std::ios::out);
+        if (!out.is_open()) {
+            std::cerr << "couldn't write trace file " << r.path << "\n";
+            return;
+        }
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        bool first = true;
+        auto separate = [&]() {
+            if (!first) {
+                out << ",\n";
+            }
+            first = false;
+        };
+        size_t dropped = 0;
+        for (auto& buffer: r.buffers) {
+            separate();
+            out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid << ",\"args\":{\"name\":\"";
+            escape(out, buffer->name.c_str());
+            out << "\"}}";
+
+            size_t count = buffer->count.load(std::memory_order_acquire);
+            dropped += buffer->dropped.load(std::memory_order_relaxed);
+            for (size_t k = 0; k < count; ++k) {
+                const Event& event = buffer->events[k];
+                separate();
+                out << "{\"name\":\"";
+                escape(out, event.name);
+                out << "\",\"cat\":\"";
+                escape(out, event.category);
+                out << "\",\"ph\":\"" << (event.duration < 0 ? "i" : "X") << "\",\"ts\":";
+                micros(out, event.start - r.origin);
+                if (event.duration < 0) {
+                    out << ",\"s\":\"t\"";
+                } else {
+                    out << ",\"dur\":";
+                    micros(out, event.duration);
+                }
+                out << ",\"pid\":1,\"tid\":" << buffer->tid;
+                if (event.detail[0] != '\0') {
+                    out << ",\"args\":{\"detail\":\"";
+                    escape(out, event.detail);
+                    out << "\"}";
+                }
+                out << "}";
+            }
+        }
+        out << "\n]}\n";
+        if (dropped > 0) {
+            std::cerr << "trace buffers filled: dropped " << dropped << " events\n";
+        }
+        r.path = "";
+    }
+
+    void set_thread_name(const std::string& name) {
+        if (!enabled()) {
+            return;
+        }
+        ThreadBuffer& buffer = local_buffer();
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        buffer.name = name;
+    }
+
+    void complete(const char* name, const char* category, int64_t start_ns, int64_t duration_ns, const char* detail) {
+        if (!enabled()) {
+            return;
+        }
+        push(name, category, start_ns, duration_ns, detail);
+    }
+
+    void instant(const char* name, const char* category, const char* detail) {
+        if (!enabled()) {
+            return;
+        }
+        push(name, category, now_ns(), -1, detail);
+    }
+
+    Span::Span(const char* name, const char* category): name(name), category(category), start(enabled() ? now_ns() : 0) {}
+
+    Span::Span(const char* name, const char* category, const char* detail): name(name), category(category), start(0) {
+        this->detail[0] = '\0';
+        if (enabled()) {
+            std::strncpy(this->detail, detail, detail_size - 1);
+            this->detail[detail_size - 1] = '\0';
+            start = now_ns();
+        }
+    }
+
+    Span::Span(const char* name, const char* category, const std::string& detail): Span(name, category, detail.c_str()) {}
+
+    Span::~Span() {
+        if (start == 0 || !enabled()) {
+            return;
+        }
+        push(name, category, start, now_ns() - start, detail[0] == '\0' ? nullptr : detail);
+    }
+};
@@ -0,0 +1,93 @@
+#pragma once
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <string>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Opt-in recording of timed spans, written out as Chrome trace-event JSON.
+ *
+ * Open the output in https://ui.perfetto.dev or `chrome://tracing` to see what each thread was doing over time: poll cycles, socket waits, log writes, renders, command sends.
+ *
+ * Each thread records into its own preallocated buffer, so recording a span takes no locks and never allocates: one clock read at each end and a store into the buffer. When tracing is off (the default), a span costs a single relaxed atomic load. The file is written by `trace::stop`.
+ *
+ * Span and category names must be string literals (or otherwise live for the whole program); only the optional `detail` is copied, truncated into a fixed-size buffer.
+ */
+namespace trace {
+    /**
+     * @brief Room for an event's `detail`, including the terminating null. Longer details are truncated.
+     */
+    constexpr size_t detail_size = 48;
+
+    /**
+     * @brief Whether spans are being recorded. Use `trace::enabled()` rather than reading this directly.
+     */
+    extern std::atomic<bool> active;
+
+    /**
+     * @brief Check whether spans are being recorded.
+     */
+    inline bool enabled() {
+        return active.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Start recording spans, to be written to `path` by `::stop`.
+     *
+     * @param path the JSON file to write.
+     * @return true if tracing started.
+     * @return false if `path` can't be written. Tracing stays off.
+     */
+    bool start(const std::string& path);
+    /**
+     * @brief Stop recording, and write everything recorded so far to the file given to `::start`.
+     *
+     * Call once other threads are done recording (e.g. after joining them). Does nothing if tracing was never started.
+     */
+    void stop();
+
+    /**
+     * @brief Name the calling thread in the trace. Does nothing unless tracing is enabled, so call it after `::start`.
+     */
+    void set_thread_name(const std::string& name);
+
+    /**
+     * @brief Record a completed span on the calling thread.
+     *
+     * @param name the span name.
+     * @param category the span category, used for filtering in the viewer.
+     * @param start_ns start time, in `steady_clock` nanoseconds.
+     * @param duration_ns duration in nanoseconds.
+     * @param detail optional text shown with the span. Truncated to 47 characters.
+     */
+    void complete(const char* name, const char* category, int64_t start_ns, int64_t duration_ns, const char* detail = nullptr);
+    /**
+     * @brief Record an instant event on the calling thread.
+     */
+    void instant(const char* name, const char* category, const char* detail = nullptr);
+
+    /**
+     * @brief Records the enclosing block as a span, if tracing is enabled.
+     */
+    class Span {
+        public:
+            Span(const char* name, const char* category);
+            /**
+             * @brief Record the enclosing block with `detail` shown alongside it. The detail is copied into the span (truncated to `detail_size - 1` characters) only while tracing, so this never allocates.
+             */
+            Span(const char* name, const char* category, const char* detail);
+            Span(const char* name, const char* category, const std::string& detail);
+            ~Span();
+
+        private:
+            const char* name;
+            const char* category;
+            int64_t start;
+            char detail[detail_size];
+    };
+};
+
+#endif
@@ -0,0 +1,186 @@
+#include "wiretime.h"
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <algorithm>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/net_tstamp.h>
+#include <linux/errqueue.h>
+#include <poll.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+// current time on CLOCK_REALTIME, the clock kernel software timestamps use
+static int64_t unix_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+double WireSample::wire_rtt() const {
+    return (wire_rx - wire_tx) * 1e-6;
+}
+
+double WireSample::app_rtt() const {
+    return (app_receive - app_send) * 1e-6;
+}
+
+WireTimer::WireTimer(std::string log_path): last{0, 0, 0, 0}, missing(0), on(false), log_path(log_path) {}
+
+#ifdef __linux__
+
+// pull the software timestamp out of a message's control data, or 0 if there isn't one
+static int64_t read_timestamp(msghdr& msg, bool* is_tx_send) {
+    int64_t result = 0;
+    for (cmsghdr* c = CMSG_FIRSTHDR(&msg); c != nullptr; c = CMSG_NXTHDR(&msg, c)) {
+        if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SO_TIMESTAMPING) {
+            scm_timestamping ts;
+            std::memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+            result = static_cast<int64_t>(ts.ts[0].tv_sec) * 1000000000 + ts.ts[0].tv_nsec;
+        } else if (is_tx_send != nullptr && ((c->cmsg_level == SOL_IP && c->cmsg_type == IP_RECVERR) || (c->cmsg_level == SOL_IPV6 && c->cmsg_type == IPV6_RECVERR))) {
+            sock_extended_err err;
+            std::memcpy(&err, CMSG_DATA(c), sizeof(err));
+            *is_tx_send = err.ee_origin == SO_EE_ORIGIN_TIMESTAMPING && err.ee_info == SCM_TSTAMP_SND;
+        }
+    }
+    return result;
+}
+
+bool WireTimer::enable(int fd, std::string& error) {
+    int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE | SOF_TIMESTAMPING_OPT_TSONLY;
+    if (setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) != 0) {
+        error = std::string("SO_TIMESTAMPING: ") + std::strerror(errno);
+        return false;
+    }
+    if (!log_file.is_open() && log_path != "") {
+        log_file.open(log_path, std::ios::out | std::ios::app);
+        log_file << "Steady ns,App send ns,Wire TX ns,Wire RX ns,App receive ns,Wire RTT (ms),App RTT (ms)\n";
+    }
+    on = true;
+    return true;
+}
+
+void WireTimer::disable(int fd) {
+    int flags = 0;
+    setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags));
+    drain_tx(fd);
+    on = false;
+}
+
+int64_t WireTimer::drain_tx(int fd) {
+    int64_t earliest = 0;
+    while (true) {
+        char control[256];
+        msghdr msg{};
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            return earliest;
+        }
+        bool is_send = false;
+        int64_t stamp = read_timestamp(msg, &is_send);
+        if (is_send && stamp != 0 && (earliest == 0 || stamp < earliest)) {
+            earliest = stamp;
+        }
+    }
+}
+
+void WireTimer::before_send(int fd) {
+    if (on) {
+        drain_tx(fd);
+    }
+    last = WireSample{unix_now_ns(), 0, 0, 0};
+}
+
+size_t WireTimer::receive(int fd, void* data, size_t size) {
+    while (true) {
+        iovec io{data, size};
+        char control[256];
+        msghdr msg{};
+        msg.msg_iov = &io;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        ssize_t got = recvmsg(fd, &msg, 0);
+        if (got > 0) {
+            last.app_receive = unix_now_ns();
+            last.wire_rx = read_timestamp(msg, nullptr);
+            return static_cast<size_t>(got);
+        }
+        if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            // the socket is non-blocking: wait for data. Queued transmit stamps also wake poll(), so collect them here.
+            pollfd p{fd, POLLIN, 0};
+            ::poll(&p, 1, -1);
+            if ((p.revents & POLLERR) && !(p.revents & POLLIN)) {
+                int64_t tx = drain_tx(fd);
+                if (tx != 0 && last.wire_tx == 0) {
+                    last.wire_tx = tx;
+                }
+            }
+            continue;
+        }
+        return 0;
+    }
+}
+
+#else
+
+bool WireTimer::enable(int fd, std::string& error) {
+    error = "kernel timestamps are only supported on Linux";
+    return false;
+}
+
+void WireTimer::disable(int fd) {
+    on = false;
+}
+
+int64_t WireTimer::drain_tx(int fd) {
+    return 0;
+}
+
+void WireTimer::before_send(int fd) {
+    last = WireSample{unix_now_ns(), 0, 0, 0};
+}
+
+size_t WireTimer::receive(int fd, void* data, size_t size) {
+    return 0;
+}
+
+#endif
+
+void WireTimer::finish(int fd, int64_t sample_time) {
+    if (last.wire_tx == 0) {
+        last.wire_tx = drain_tx(fd);
+    }
+    if (last.wire_tx == 0 || last.wire_rx == 0) {
+        ++missing;
+        return;
+    }
+    wire_rtt.add(last.wire_rtt());
+    app_delay.add(last.app_rtt() - last.wire_rtt());
+
+    if (log_file.is_open()) {
+        log_file << sample_time << "," << last.app_send << "," << last.wire_tx << "," << last.wire_rx << "," << last.app_receive;
+        log_file << "," << std::fixed << std::setprecision(6) << last.wire_rtt() << "," << last.app_rtt() << "\n";
+    }
+}
+
+std::string WireTimer::summary() const {
+    if (!on) {
+        return "kernel timestamps off";
+    }
+    if (wire_rtt.count() == 0) {
+        return "kernel timestamps on, no samples yet (" + std::to_string(missing) + " missing)";
+    }
+    std::stringstream result;
+    result << std::fixed << std::setprecision(3);
+    result << "wire RTT " << last.wire_rtt() << " ms (mean " << wire_rtt.mean() << ", max " << wire_rtt.max() << "), ";
+    result << "app delay " << last.app_rtt() - last.wire_rtt() << " ms (mean " << app_delay.mean() << ", max " << app_delay.max() << ")";
+    if (missing > 0) {
+        result << ", " << missing << " missing";
+    }
+    return result.str();
+}
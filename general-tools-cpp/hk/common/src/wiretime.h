@@ -0,0 +1,134 @@
+#pragma once
+#ifndef WIRETIME_H
+#define WIRETIME_H
+
+#include <string>
+#include <fstream>
+#include <cstdint>
+#include <cstddef>
+#include "stats.h"
+
+/**
+ * @brief Application and kernel timestamps for one request/reply exchange, in Unix nanoseconds.
+ *
+ * The kernel stamps (`wire_tx`, `wire_rx`) are zero if the kernel didn't provide them.
+ */
+struct WireSample {
+    /**
+     * @brief When the application called `send`.
+     */
+    int64_t app_send;
+    /**
+     * @brief When the kernel passed the request to the network device.
+     */
+    int64_t wire_tx;
+    /**
+     * @brief When the kernel received the reply from the network device.
+     */
+    int64_t wire_rx;
+    /**
+     * @brief When the application got the reply back from `recvmsg`.
+     */
+    int64_t app_receive;
+
+    /**
+     * @brief Round trip seen on the wire, in milliseconds: the board's latency plus the network.
+     */
+    double wire_rtt() const;
+    /**
+     * @brief Round trip seen by the application, in milliseconds.
+     */
+    double app_rtt() const;
+};
+
+/**
+ * @brief Optional kernel software timestamps (`SO_TIMESTAMPING`) for request/reply exchanges on a TCP socket.
+ *
+ * When enabled, the kernel stamps each outgoing segment as it is handed to the network device and each incoming segment as it arrives. Comparing these to the times the application sent and received shows how much of a poll's round trip is the board and the link (the wire RTT) and how much is our own scheduling and processing (the application delay).
+ *
+ * Use it around each exchange like this:
+ * ```cpp
+ * wire.before_send(fd);
+ * // ... send the request ...
+ * size_t got = wire.receive(fd, reply.data(), reply.size());
+ * wire.finish(fd, sample_time);
+ * ```
+ *
+ * Only available on Linux. Elsewhere, `::enable` fails and the timer stays off.
+ */
+class WireTimer {
+    public:
+        /**
+         * @brief Construct a new WireTimer object, initially disabled.
+         *
+         * @param log_path file to write one row per exchange to, opened on first `::enable`. Empty to disable the log.
+         */
+        WireTimer(std::string log_path);
+
+        /**
+         * @brief Turn on RX and TX software timestamps for the socket `fd`.
+         *
+         * @param fd the native socket handle.
+         * @param error set to a description of the problem if enabling fails.
+         * @return true if timestamps were enabled.
+         */
+        bool enable(int fd, std::string& error);
+        /**
+         * @brief Turn timestamps off for the socket `fd`.
+         */
+        void disable(int fd);
+        bool enabled() const { return on; }
+
+        /**
+         * @brief Call just before sending a request. Discards stale transmit timestamps and notes the send time.
+         */
+        void before_send(int fd);
+        /**
+         * @brief Receive a reply with `recvmsg`, keeping its kernel receive timestamp.
+         *
+         * Blocks until data arrives, like `socket.receive`.
+         *
+         * @return size_t number of bytes received, or 0 on error.
+         */
+        size_t receive(int fd, void* data, size_t size);
+        /**
+         * @brief Call after the reply is received. Collects the request's transmit timestamp and records the exchange.
+         *
+         * @param sample_time the sample's `steady_clock` timestamp (see `steady_ns`), written to the log to match rows with other logs.
+         */
+        void finish(int fd, int64_t sample_time);
+
+        /**
+         * @brief A one-line summary of wire RTT and application delay, for display.
+         */
+        std::string summary() const;
+
+        /**
+         * @brief The most recent exchange.
+         */
+        WireSample last;
+        /**
+         * @brief Wire round trip, in milliseconds.
+         */
+        RunningStats wire_rtt;
+        /**
+         * @brief Application round trip minus wire round trip, in milliseconds.
+         */
+        RunningStats app_delay;
+        /**
+         * @brief Number of exchanges where the kernel didn't provide both timestamps.
+         */
+        uint64_t missing;
+
+    private:
+        /**
+         * @brief Read queued transmit timestamps from the socket error queue, returning the earliest, or 0 if none.
+         */
+        int64_t drain_tx(int fd);
+
+        bool on;
+        std::string log_path;
+        std::ofstream log_file;
+};
+
+#endif
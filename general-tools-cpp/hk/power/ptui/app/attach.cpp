@@ -0,0 +1,143 @@
+#include <ftxui/dom/elements.hpp>
+#include "ftxui/component/component.hpp"       // for Radiobox, Button, Renderer, Vertical
+#include "ftxui/component/component_base.hpp"  // for ComponentBase
+#include "ftxui/component/component_options.hpp"
+#include "ftxui/component/screen_interactive.hpp"  // for Component, ScreenInteractive
+#include <ftxui/screen/color.hpp>
+#include <ftxui/dom/table.hpp>
+
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include "parameters.h"
+#include "attach.h"
+
+/**
+ * @brief A thin ptui that attaches to a running `ptuid --attach` instead of polling the board itself.
+ *
+ * Any number of these can be open at once: the board is only ever polled (and logged) by the daemon, and ON/OFF commands from every client go through the daemon one at a time.
+ */
+int main(int argc, char* argv[]) {
+    std::string path = argc > 1 ? argv[1] : config::attach_path;
+    if (path == "-h" || path == "--help") {
+        std::cout << "use like this:\n\t> ./ptui-attach [socket path, default " << config::attach_path << "]\n";
+        return 0;
+    }
+
+    auto screen = ftxui::ScreenInteractive::FitComponent();
+    AttachClient client;
+    // redraw whenever the daemon sends something
+    client.on_update = [&] {
+        screen.Post(ftxui::Event::Custom);
+    };
+    std::string error;
+    if (!client.attach(path, error)) {
+        std::cout << "couldn't attach: " << error << "\n";
+        return 1;
+    }
+
+    // the state shown by this frame, refreshed before each render
+    AttachState state = client.snapshot();
+    AlarmEngine describer(state.names, "");
+
+    int selected = 0;
+    auto send_switch = [&](uint8_t off) {
+        client.command({0x03, config::token_lookup.at(config::names[selected]), off});
+    };
+    auto on_button = ftxui::Button("ON ", [&] { send_switch(0x00); }, ftxui::ButtonOption::Simple());
+    auto off_button = ftxui::Button("OFF", [&] { send_switch(0x01); }, ftxui::ButtonOption::Simple());
+    auto onoff_layout = ftxui::Container::Horizontal({on_button, off_button});
+    auto radio_list = ftxui::Radiobox(&config::names, &selected);
+
+    auto system_selector = ftxui::Renderer(radio_list, [&] {
+        return ftxui::vbox({
+            ftxui::text("systems"),
+            ftxui::separator(),
+            radio_list->Render()
+        }) | ftxui::vscroll_indicator | ftxui::frame | size(ftxui::HEIGHT, ftxui::LESS_THAN, 20) | ftxui::border;
+    });
+
+    auto toggle_context = ftxui::Renderer(onoff_layout, [&] {
+        return ftxui::vbox({
+            ftxui::text(state.connected ? "attached to " + state.node : "detached") | ftxui::center,
+            ftxui::separator(),
+            ftxui::text(config::names[selected]) | ftxui::bold | ftxui::center,
+            ftxui::separator(),
+            onoff_layout->Render(),
+            ftxui::separator(),
+            ftxui::text(state.last_result == "" ? "no commands sent" : state.last_result) | ftxui::center,
+        }) | ftxui::border;
+    });
+
+    auto format = [](double value) {
+        std::stringstream stream;
+        stream << std::fixed << std::setprecision(3) << value;
+        return stream.str();
+    };
+    auto table_context = ftxui::Renderer([&] {
+        std::vector<std::vector<std::string>> rows = {{"System", "Voltage", "Current"}};
+        bool have_values = state.samples > 0 && state.values.size() == config::ADC_CHANNELS;
+        for (size_t k = 0; k < config::v_map.size(); ++k) {
+            rows.push_back({config::measure_names[k], have_values ? format(state.values[config::v_map[k]]) : "-", have_values ? format(state.values[config::i_map[k]]) : "-"});
+        }
+        auto tab = ftxui::Table(rows);
+        if (have_values) {
+            for (size_t k = 1; k <= config::v_map.size(); ++k) {
+                AlarmLevel level = std::max(state.levels[config::v_map[k - 1]], state.levels[config::i_map[k - 1]]);
+                if (level == AlarmLevel::red) {
+                    tab.SelectRow(k).Decorate(ftxui::bgcolor(ftxui::Color::Red1));
+                    tab.SelectRow(k).Decorate(ftxui::color(ftxui::Color::White));
+                } else if (level == AlarmLevel::yellow) {
+                    tab.SelectRow(k).Decorate(ftxui::bgcolor(ftxui::Color::Yellow1));
+                    tab.SelectRow(k).Decorate(ftxui::color(ftxui::Color::Black));
+                }
+            }
+        }
+        tab.SelectColumn(1).BorderLeft(ftxui::LIGHT);
+        tab.SelectRow(0).Decorate(ftxui::bold);
+        tab.SelectRow(0).BorderBottom(ftxui::LIGHT);
+        return ftxui::vbox({
+            ftxui::text("measurement (reading " + std::to_string(state.index) + ")"),
+            ftxui::separator(),
+            tab.Render()
+        }) | ftxui::border;
+    });
+
+    // the most recent alarm level changes, newest first
+    auto alarm_context = ftxui::Renderer([&] {
+        ftxui::Elements lines;
+        const size_t shown = 5;
+        for (size_t k = 0; k < std::min(shown, state.alarms.size()); ++k) {
+            const AlarmEvent& event = state.alarms[state.alarms.size() - 1 - k];
+            auto line = ftxui::text(describer.describe(event));
+            if (event.to == AlarmLevel::red) {
+                line = line | ftxui::color(ftxui::Color::Red1);
+            } else if (event.to == AlarmLevel::yellow) {
+                line = line | ftxui::color(ftxui::Color::Yellow1);
+            }
+            lines.push_back(line);
+        }
+        if (lines.empty()) {
+            lines.push_back(ftxui::text("no alarms"));
+        }
+        return ftxui::vbox({
+            ftxui::text("alarms"),
+            ftxui::separator(),
+            ftxui::vbox(lines)
+        }) | ftxui::border;
+    });
+
+    auto system_context = ftxui::Container::Horizontal({system_selector, table_context, toggle_context});
+    auto global_layout = ftxui::Container::Vertical({system_context, alarm_context});
+    auto refreshed_layout = ftxui::Renderer(global_layout, [&] {
+        state = client.snapshot();
+        return global_layout->Render();
+    });
+
+    std::cout << "\n";
+    screen.Loop(refreshed_layout);
+    client.detach();
+
+    return 0;
+}
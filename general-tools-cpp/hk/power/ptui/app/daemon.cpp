@@ -0,0 +1,103 @@
+#include "listen.h"
+#include "headless.h"
+#include <iostream>
+#include <algorithm>
+#include <sys/socket.h>
+
+/**
+ * @brief Poll the power board without a UI, for long unattended runs like thermal soaks.
+ *
+ * Logs, captures, alarms, metrics and shared memory all work as in `ptui`. The link is (re)connected automatically, and SIGINT or SIGTERM stops polling and closes every log cleanly (see `HeadlessRunner`). Between polls, every thread is blocked waiting for a deadline, a socket or a signal.
+ */
+int main(int argc, char** argv) {
+    // blocks SIGINT/SIGTERM before any other thread starts, so they only reach `runner.run()`:
+    HeadlessRunner runner("ptuid", "ADC poll", config::adc_poll_period, config::alarm_path);
+    runner.options.add_options()
+        ("attach",      boost::program_options::value<std::string>()->implicit_value(config::attach_path), "serve readings to ptui-attach clients on this Unix socket")
+    ;
+    int status = 0;
+    if (!runner.parse(argc, argv, status)) {
+        return status;
+    }
+
+    boost::asio::io_context context;
+    HKADCNode node(runner.local, context, runner.period);
+
+    std::string alarm_note;
+    if (node.load_alarms(runner.vm["alarms"].as<std::string>(), alarm_note)) {
+        std::cout << "alarm limits from " << runner.vm["alarms"].as<std::string>() << "\n";
+    } else {
+        std::cout << "no alarm limits: " << alarm_note << "\n";
+    }
+
+    std::string metrics_error;
+    if (!runner.serve_metrics(node.metrics, metrics_error)) {
+        std::cerr << "couldn't serve metrics: " << metrics_error << "\n";
+        return 1;
+    }
+
+    // let any number of ptui-attach clients watch, and switch systems through this one connection to the board
+    if (runner.vm.count("attach")) {
+        std::string attach_error;
+        if (!node.attach.start(runner.vm["attach"].as<std::string>(), attach_error)) {
+            std::cerr << "couldn't serve attach clients: " << attach_error << "\n";
+            return 1;
+        }
+        node.metrics.gauge("hk_attach_clients", "UI clients attached.", [&node] {
+            return static_cast<double>(node.attach.clients.load());
+        });
+        std::cout << "serving attach clients on " << node.attach.path << "\n";
+    }
+
+    // send a client's command to the board, if it's one of the power switch commands ptui itself sends
+    auto run_command = [&](const AttachCommand& command) {
+        bool known = command.bytes.size() == 3 && command.bytes[0] == 0x03 && command.bytes[2] <= 0x01
+            && std::any_of(config::token_lookup.begin(), config::token_lookup.end(), [&](auto& entry) { return entry.second == command.bytes[1]; });
+        if (!known) {
+            node.attach.reply(command, attach_protocol::Status::rejected, "not a power switch command");
+            return;
+        }
+        if (!node.poll_started) {
+            node.attach.reply(command, attach_protocol::Status::failed, "not connected to the board");
+            return;
+        }
+        try {
+            node.socket.send(boost::asio::buffer(command.bytes));
+        } catch (std::exception& e) {
+            node.attach.reply(command, attach_protocol::Status::failed, e.what());
+            return;
+        }
+        std::cout << util::get_now_string() << " client " << command.client << " switched " << static_cast<int>(command.bytes[1]) << (command.bytes[2] == 0x00 ? " on" : " off") << "\n";
+        node.attach.reply(command, attach_protocol::Status::sent, "");
+    };
+
+    runner.connect = [&] {
+        node.poll_started = node.setup_socket(runner.remote);
+        return node.poll_started;
+    };
+    runner.disconnect = [&] {
+        boost::system::error_code ignored;
+        node.socket.close(ignored);
+        node.poll_started = false;
+    };
+    runner.poll = [&] { return node.poll_adc(); };
+    // commands from attached clients run between polls, so they reach the board one at a time:
+    runner.between = [&] {
+        AttachCommand command;
+        while (node.attach.next_command(command)) {
+            run_command(command);
+        }
+    };
+    runner.status = [&] {
+        return std::to_string(node.link.replies.value()) + " replies, " + std::to_string(node.link.short_reads.value()) + " short, " + std::to_string(node.link.timeouts.value()) + " timeouts, "
+            + std::to_string(node.link.reconnects.value()) + " reconnects, " + node.latency.brief(0);
+    };
+    runner.interrupt = [&] { ::shutdown(node.socket.native_handle(), SHUT_RDWR); };
+    runner.time_tag = util::get_now_string;
+
+    int result = runner.run();
+    node.attach.stop();
+    std::cout << node.latency.brief(0) << "\n";
+    // logs are flushed and closed as `node` goes out of scope.
+    return result;
+}
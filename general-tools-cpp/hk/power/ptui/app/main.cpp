@@ -13,18 +13,66 @@
 #include <iostream>
 #include <algorithm>
 #include <functional>
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+#include <limits>
 #include "listen.h"
+#include "scheduler.h"
+#include "trace.h"
 
 int main(int argc, char* argv[]) {
-    // handle CLI arguments: 
-    if (argc < 3) {
-        std::cout << "use like this:\n\t> ./gsetui ip.address portnum \n";
+    // handle CLI arguments, splitting off the optional `--trace file.json`, `--metrics port` and `--poll-period ms` from the positional ones:
+    std::vector<std::string> args;
+    std::string trace_path;
+    unsigned long metrics_port = 0;
+    std::chrono::milliseconds poll_period = config::adc_poll_period;
+    for (int k = 1; k < argc; ++k) {
+        if (std::string(argv[k]) == "--trace" && k + 1 < argc) {
+            trace_path = argv[++k];
+        } else if (std::string(argv[k]) == "--metrics" && k + 1 < argc) {
+            metrics_port = strtoul(argv[++k], nullptr, 10);
+        } else if (std::string(argv[k]) == "--poll-period" && k + 1 < argc) {
+            poll_period = std::chrono::milliseconds(strtoul(argv[++k], nullptr, 10));
+        } else {
+            args.push_back(argv[k]);
+        }
+    }
+    if (args.size() < 2 || poll_period.count() == 0) {
+        std::cout << "use like this:\n\t> ./gsetui ip.address portnum [alarms.json] [--trace trace.json] [--metrics port] [--poll-period ms]\n";
         return 1;
     }
+    // record a Chrome trace-event file of poll cycles and renders, written on exit
+    if (trace_path != "") {
+        if (!trace::start(trace_path)) {
+            return 1;
+        }
+        trace::set_thread_name("ui");
+    }
     // create io context manager and local TCP endpoint from CLI arguments
     boost::asio::io_context context;
-    boost::asio::ip::tcp::endpoint endpoint(boost::asio::ip::make_address_v4(argv[1]), strtoul(argv[2], nullptr, 10));
-    HKADCNode node(endpoint, context);
+    boost::asio::ip::tcp::endpoint endpoint(boost::asio::ip::make_address_v4(args[0]), strtoul(args[1].c_str(), nullptr, 10));
+    HKADCNode node(endpoint, context, poll_period);
+    PeriodicScheduler scheduler;
+
+    // serve link counters at http://127.0.0.1:port/metrics for a Prometheus scraper
+    MetricsServer metrics_server(node.metrics);
+    if (metrics_port != 0) {
+        std::string metrics_error;
+        if (metrics_port > 65535 || !metrics_server.start(static_cast<unsigned short>(metrics_port), metrics_error)) {
+            std::cout << "couldn't serve metrics on port " << metrics_port << ": " << metrics_error << "\n";
+            return 1;
+        }
+    }
+
+    // load alarm limits, from the optional third argument or the default file
+    std::string alarm_path = args.size() > 2 ? args[2] : config::alarm_path;
+    std::string alarm_note;
+    if (node.load_alarms(alarm_path, alarm_note)) {
+        alarm_note = "limits from " + alarm_path;
+    } else {
+        alarm_note = "no alarm limits: " + alarm_note;
+    }
 
     // number of systems used
     const std::size_t n_sys = 9;
@@ -176,10 +224,21 @@ int main(int argc, char* argv[]) {
         if (node.format_table.size() > 0) {
             std::vector<ftxui::Color::Palette256> colortab = {ftxui::Color::Blue1, ftxui::Color::Orange1, ftxui::Color::Purple, ftxui::Color::Red1};
             for (size_t k = 1; k <= config::v_map.size(); ++k) {
-                tab.SelectRow(k).Decorate(ftxui::color(colortab[config::v_map[k - 1]]));
+                // a row alarms if either its voltage or current channel does
+                AlarmLevel level = std::max(node.alarms.level(config::v_map[k - 1]), node.alarms.level(config::i_map[k - 1]));
+                if (level == AlarmLevel::red) {
+                    tab.SelectRow(k).Decorate(ftxui::bgcolor(ftxui::Color::Red1));
+                    tab.SelectRow(k).Decorate(ftxui::color(ftxui::Color::White));
+                } else if (level == AlarmLevel::yellow) {
+                    tab.SelectRow(k).Decorate(ftxui::bgcolor(ftxui::Color::Yellow1));
+                    tab.SelectRow(k).Decorate(ftxui::color(ftxui::Color::Black));
+                } else {
+                    tab.SelectRow(k).Decorate(ftxui::color(colortab[config::v_map[k - 1]]));
+                }
             }
             tab.SelectColumn(1).BorderRight(ftxui::LIGHT);
             tab.SelectColumn(1).BorderLeft(ftxui::LIGHT);
+            tab.SelectColumn(3).BorderLeft(ftxui::LIGHT);
             tab.SelectRow(-1).BorderBottom(ftxui::LIGHT);
             tab.SelectRow(0).Decorate(ftxui::bold);
         }
@@ -196,13 +255,15 @@ int main(int argc, char* argv[]) {
             }) | ftxui::flex_grow | ftxui::center,
             ftxui::separator(),
             onoff_layout->Render(),
+            ftxui::separator(),
+            ftxui::text(node.capture.status()) | ftxui::center,
         }) | ftxui::border;
     });
 
     auto table_context = ftxui::Renderer([&] {
         return ftxui::vbox({
             // ftxui::text(debug_label()),
-            ftxui::text("measurement"),
+            ftxui::text("measurement (current statistics over last minute)"),
             ftxui::separator(),
             ftxui::vbox({
                 detail_readout_table()
@@ -210,34 +271,249 @@ int main(int argc, char* argv[]) {
         }) | ftxui::border;
     });
     
+    // index of the selected trend plot time span
+    int span_selected = 0;
+    auto span_toggle = ftxui::Toggle(&config::trend_span_names, &span_selected);
+
+    // plot the selected system's current over the selected time span, as a min/max envelope
+    auto trend_plot = [&] {
+        size_t channel = config::i_map[config::trend_map[selected]];
+        const int plot_width = 2 * config::trend_width;
+        const int plot_height = 4 * 6;
+        auto env = node.history[channel].envelope(std::chrono::steady_clock::now(), config::trend_spans[span_selected], plot_width);
+
+        double lo = std::numeric_limits<double>::infinity();
+        double hi = -std::numeric_limits<double>::infinity();
+        for (auto& col: env) {
+            if (!std::isnan(col.first)) {
+                lo = std::min(lo, col.first);
+                hi = std::max(hi, col.second);
+            }
+        }
+        if (lo > hi) {
+            return ftxui::text("no data") | ftxui::center | size(ftxui::WIDTH, ftxui::EQUAL, config::trend_width + 8);
+        }
+        auto to_y = [=](double v) {
+            if (hi <= lo) {
+                return plot_height / 2;
+            }
+            return static_cast<int>((hi - v) / (hi - lo) * (plot_height - 1));
+        };
+        auto plot = ftxui::canvas(plot_width, plot_height, [=](ftxui::Canvas& c) {
+            for (int x = 0; x < plot_width; ++x) {
+                if (!std::isnan(env[x].first)) {
+                    c.DrawPointLine(x, to_y(env[x].second), x, to_y(env[x].first), ftxui::Color::Green1);
+                }
+            }
+        });
+        std::stringstream hi_label;
+        std::stringstream lo_label;
+        hi_label << std::fixed << std::setprecision(3) << hi;
+        lo_label << std::fixed << std::setprecision(3) << lo;
+        return ftxui::hbox({
+            ftxui::vbox({ftxui::text(hi_label.str()), ftxui::filler(), ftxui::text(lo_label.str())}) | size(ftxui::WIDTH, ftxui::EQUAL, 8),
+            plot
+        });
+    };
+    auto trend_context = ftxui::Renderer(span_toggle, [&] {
+        size_t channel = config::i_map[config::trend_map[selected]];
+        return ftxui::vbox({
+            ftxui::hbox({
+                ftxui::text("trend: " + config::adc_ch_names[channel] + " current   "),
+                span_toggle->Render()
+            }),
+            ftxui::separator(),
+            trend_plot()
+        }) | ftxui::border;
+    });
+
+    // range query over the session: channel, and window start/end in minutes before now
+    int query_channel = 0;
+    std::string query_from;
+    std::string query_to;
+    auto query_channel_box = ftxui::Dropdown(&config::adc_ch_names, &query_channel);
+    auto query_from_field = ftxui::Input(&query_from, "start of session", ftxui::InputOption::Default());
+    auto query_to_field = ftxui::Input(&query_to, "now", ftxui::InputOption::Default());
+    auto query_layout = ftxui::Container::Vertical({query_channel_box, query_from_field, query_to_field});
+
+    // convert "minutes ago" entered by the user into a time, or `fallback` if blank
+    auto minutes_ago = [](std::string& field, std::chrono::steady_clock::time_point now, std::chrono::steady_clock::time_point fallback) {
+        if (field.empty()) {
+            return fallback;
+        }
+        auto ago = std::chrono::duration<double, std::ratio<60>>(strtod(field.c_str(), nullptr));
+        return now - std::chrono::duration_cast<std::chrono::steady_clock::duration>(ago);
+    };
+    auto query_result = [&] {
+        auto now = std::chrono::steady_clock::now();
+        auto begin = minutes_ago(query_from, now, std::chrono::steady_clock::time_point::min());
+        auto end = minutes_ago(query_to, now, now + std::chrono::seconds(1));
+        RangeSummary summary = node.index[query_channel].query(begin, end);
+        if (summary.count == 0) {
+            return std::vector<std::string>{"no samples", "", "", ""};
+        }
+        std::stringstream min_stream;
+        std::stringstream max_stream;
+        std::stringstream mean_stream;
+        min_stream << std::fixed << std::setprecision(3) << "min  " << summary.min;
+        max_stream << std::fixed << std::setprecision(3) << "max  " << summary.max;
+        mean_stream << std::fixed << std::setprecision(3) << "mean " << summary.mean();
+        return std::vector<std::string>{"n    " + std::to_string(summary.count), min_stream.str(), max_stream.str(), mean_stream.str()};
+    };
+    auto query_context = ftxui::Renderer(query_layout, [&] {
+        ftxui::Elements results;
+        for (auto& line: query_result()) {
+            results.push_back(ftxui::text(line));
+        }
+        return ftxui::vbox({
+            ftxui::text("query"),
+            ftxui::separator(),
+            query_channel_box->Render(),
+            ftxui::hbox({ftxui::text("from (min ago): "), query_from_field->Render()}),
+            ftxui::hbox({ftxui::text("to   (min ago): "), query_to_field->Render()}),
+            ftxui::separator(),
+            ftxui::vbox(results)
+        }) | size(ftxui::WIDTH, ftxui::GREATER_THAN, 32) | ftxui::border;
+    });
+
+    // list the most recent alarm level changes, newest first
+    auto alarm_context = ftxui::Renderer([&] {
+        ftxui::Elements lines;
+        const size_t shown = 5;
+        for (size_t k = 0; k < std::min(shown, node.alarms.events.size()); ++k) {
+            const AlarmEvent& event = node.alarms.events[node.alarms.events.size() - 1 - k];
+            auto line = ftxui::text(node.alarms.describe(event));
+            if (event.to == AlarmLevel::red) {
+                line = line | ftxui::color(ftxui::Color::Red1);
+            } else if (event.to == AlarmLevel::yellow) {
+                line = line | ftxui::color(ftxui::Color::Yellow1);
+            }
+            lines.push_back(line);
+        }
+        if (lines.empty()) {
+            lines.push_back(ftxui::text("no alarms"));
+        }
+        return ftxui::vbox({
+            ftxui::text("alarms (" + alarm_note + ")"),
+            ftxui::separator(),
+            ftxui::vbox(lines)
+        }) | ftxui::border;
+    });
+
+    // optional kernel timestamps on the board socket, splitting the round trip into wire and application time
+    bool wire_on = false;
+    std::string wire_note;
+    auto wire_option = ftxui::CheckboxOption::Simple();
+    wire_option.on_change = [&] {
+        wire_note = "";
+        if (!node.set_wire_timestamps(wire_on, wire_note)) {
+            wire_on = false;
+        }
+    };
+    auto wire_checkbox = ftxui::Checkbox("kernel timestamps", &wire_on, wire_option);
+
+    // show poll timing: how late each poll started after its deadline
+    auto timing_context = ftxui::Renderer(wire_checkbox, [&] {
+        ftxui::Elements rows;
+        for (size_t t = 0; t < scheduler.tasks.size(); ++t) {
+            const JitterHistogram& jitter = scheduler.tasks[t].jitter;
+            uint64_t total = std::max<uint64_t>(1, jitter.total());
+            ftxui::Elements labels, bars, counts;
+            for (size_t k = 0; k < JitterHistogram::bucket_count; ++k) {
+                labels.push_back(ftxui::text(JitterHistogram::label(k)));
+                bars.push_back(ftxui::gauge(static_cast<float>(jitter.count(k)) / total) | ftxui::size(ftxui::WIDTH, ftxui::EQUAL, 20));
+                counts.push_back(ftxui::text(std::to_string(jitter.count(k))));
+            }
+            rows.push_back(ftxui::text(scheduler.summary(t)));
+            rows.push_back(ftxui::hbox({ftxui::vbox(labels), ftxui::text(" "), ftxui::vbox(bars), ftxui::text(" "), ftxui::vbox(counts)}));
+        }
+        rows.push_back(ftxui::separator());
+        rows.push_back(wire_checkbox->Render());
+        rows.push_back(ftxui::text(wire_note == "" ? node.wire.summary() : wire_note));
+        return ftxui::vbox({
+            ftxui::text("poll timing (lateness after deadline)"),
+            ftxui::separator(),
+            ftxui::vbox(rows)
+        }) | ftxui::border;
+    });
+
+    // one-line status bar: connection, poll count, and round-trip latency for each request type
+    auto status_bar = ftxui::Renderer([&] {
+        ftxui::Elements items = {ftxui::text(status_label()), ftxui::separator(), ftxui::text(poll_label())};
+        for (size_t k = 0; k < node.latency.names.size(); ++k) {
+            items.push_back(ftxui::separator());
+            items.push_back(ftxui::text(node.latency.brief(k)));
+        }
+        return ftxui::hbox(items);
+    });
+
+    // debug panel: time spent in each phase of the poll cycle and in rendering. Toggle with `d`.
+    bool show_profile = false;
+    auto profile_context = ftxui::Renderer([&] {
+        auto tab = ftxui::Table(node.profile.table());
+        tab.SelectRow(0).Decorate(ftxui::bold);
+        tab.SelectRow(0).BorderBottom(ftxui::LIGHT);
+        tab.SelectColumn(0).BorderRight(ftxui::LIGHT);
+        return ftxui::vbox({
+            ftxui::text("poll cycle profile (press d to hide)"),
+            ftxui::separator(),
+            tab.Render()
+        }) | ftxui::border;
+    });
+
     // layout out the main areas of the screen:
     auto system_context = ftxui::Container::Horizontal({system_selector, table_context, toggle_context});
-    auto global_layout = ftxui::Container::Vertical({ip_entry, system_context});
+    auto history_context = ftxui::Container::Horizontal({trend_context, query_context});
+    auto status_context = ftxui::Container::Horizontal({alarm_context, timing_context});
+    auto global_layout = ftxui::Container::Vertical({ip_entry, system_context, history_context, status_context, ftxui::Maybe(profile_context, &show_profile), status_bar});
+    // press `c` to manually trigger a capture of recent readings, or `d` to show the poll cycle profile.
+    // Keys typed into a text field are left for the field.
+    auto typing = [&] {
+        return address_field->Focused() || port_field->Focused() || query_from_field->Focused() || query_to_field->Focused();
+    };
+    auto global_events = ftxui::CatchEvent(global_layout, [&](ftxui::Event event) {
+        if (event == ftxui::Event::Character('c') && !typing()) {
+            node.capture.trigger("manual");
+            return true;
+        }
+        if (event == ftxui::Event::Character('d') && !typing()) {
+            show_profile = !show_profile;
+            return true;
+        }
+        return false;
+    });
+    // time each render of the whole screen
+    auto profiled_layout = ftxui::Renderer(global_events, [&] {
+        PhaseProfiler::Scope scope(node.profile, PollPhase::render);
+        return global_events->Render();
+    });
     auto screen = ftxui::ScreenInteractive::FitComponent();
     
     std::cout << "\n";
 
-    // add work to rendering loop to poll the power board.
-    std::atomic<bool> refresh_ui_continue = true;
-    std::thread refresh_ui([&] {
-        while (refresh_ui_continue) {
-            using namespace std::chrono_literals;
-            std::this_thread::sleep_for(500ms);
-            // `screen.Post(task)` will execute the update on the thread
-            //  where |screen| lives (e.g. the main thread). Using 
-            // `screen.Post(task)` is threadsafe.
+    // poll the board on fixed deadlines from the scheduler thread, so the period doesn't drift.
+    size_t poll_task = 0;
+    poll_task = scheduler.add("ADC poll", poll_period, [&](std::chrono::steady_clock::time_point deadline) {
+        // `screen.Post(task)` will execute the update on the thread
+        //  where |screen| lives (e.g. the main thread). Using 
+        // `screen.Post(task)` is threadsafe.
 
-            screen.Post([&] { node.poll_adc(); });
+        screen.Post([&, deadline] {
+            scheduler.record(poll_task, deadline);
+            node.poll_adc();
+        });
 
-            // After updating the state, request a new frame to be drawn. This is done
-            // by simulating a new "custom" event to be handled.
-            screen.Post(ftxui::Event::Custom);
-        }
+        // After updating the state, request a new frame to be drawn. This is done
+        // by simulating a new "custom" event to be handled.
+        screen.Post(ftxui::Event::Custom);
     });
+    std::thread refresh_ui([&] { scheduler.run(); });
 
-    screen.Loop(global_layout);
-    refresh_ui_continue = false;
+    screen.Loop(profiled_layout);
+    scheduler.stop();
     refresh_ui.join();
+    metrics_server.stop();
+    trace::stop();
 
     return 0;
 }
\ No newline at end of file
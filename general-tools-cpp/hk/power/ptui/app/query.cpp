@@ -0,0 +1,120 @@
+#include "parameters.h"
+#include "rangeindex.h"
+#include "timestamp.h"
+#include <boost/program_options.hpp>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+/**
+ * @brief Answer min/max/mean/count queries over a raw power board log (`log/raw_*.log`).
+ *
+ * The raw log has no time tags, so times are counted from the first reply in the file assuming replies arrived every `config::adc_poll_period`.
+ *
+ * With `--export`, instead copy a parsed CSV log (`log/parse_*.csv`) to stdout with a wall-clock time on each row, worked out from the file's time anchor.
+ */
+int main(int argc, char** argv) {
+    boost::program_options::options_description options("options");
+    options.add_options()
+        ("help,h",                                                              "output help message")
+        ("file,f",      boost::program_options::value<std::string>(),           "raw log file to read")
+        ("channel,c",   boost::program_options::value<std::string>(),           "ADC channel name or index (default: all)")
+        ("from",        boost::program_options::value<double>()->default_value(0.0), "start of query, seconds after first reply")
+        ("to",          boost::program_options::value<double>(),                "end of query, seconds after first reply (default: end of file)")
+        ("period",      boost::program_options::value<double>()->default_value(config::adc_poll_period.count()), "milliseconds between replies")
+        ("export",      boost::program_options::value<std::string>(),           "parsed CSV log to write to stdout with a wall-clock Time column")
+    ;
+    boost::program_options::positional_options_description positional;
+    positional.add("file", 1);
+    boost::program_options::variables_map vm;
+    try {
+        boost::program_options::store(boost::program_options::command_line_parser(argc, argv).options(options).positional(positional).run(), vm);
+        boost::program_options::notify(vm);
+    } catch (std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    if (vm.count("help") || (!vm.count("file") && !vm.count("export"))) {
+        std::cout << "use like this:\n\t> ./hkquery log/raw_*.log [--channel \"CdTe 2\"] [--from seconds] [--to seconds]\n";
+        std::cout << "or:\n\t> ./hkquery --export log/parse_*.csv > parse.csv\n\n";
+        std::cout << options << "\n";
+        return vm.count("help") ? 0 : 1;
+    }
+
+    if (vm.count("export")) {
+        std::ifstream csv_file(vm["export"].as<std::string>());
+        if (!csv_file.is_open()) {
+            std::cerr << "couldn't open " << vm["export"].as<std::string>() << "\n";
+            return 1;
+        }
+        std::string error;
+        if (!export_wall_clock(csv_file, std::cout, error)) {
+            std::cerr << vm["export"].as<std::string>() << ": " << error << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    std::ifstream raw_file(vm["file"].as<std::string>(), std::ios::binary);
+    if (!raw_file.is_open()) {
+        std::cerr << "couldn't open " << vm["file"].as<std::string>() << "\n";
+        return 1;
+    }
+
+    // pick out which channels to report:
+    std::vector<size_t> channels;
+    if (vm.count("channel")) {
+        std::string name = vm["channel"].as<std::string>();
+        auto found = std::find(config::adc_ch_names.begin(), config::adc_ch_names.end(), name);
+        if (found != config::adc_ch_names.end()) {
+            channels.push_back(found - config::adc_ch_names.begin());
+        } else {
+            char* end;
+            size_t k = strtoul(name.c_str(), &end, 10);
+            if (*end != '\0' || k >= config::ADC_CHANNELS) {
+                std::cerr << "unknown channel: " << name << "\n";
+                return 1;
+            }
+            channels.push_back(k);
+        }
+    } else {
+        for (size_t k = 0; k < config::ADC_CHANNELS; ++k) {
+            channels.push_back(k);
+        }
+    }
+
+    // index every reply in the file:
+    std::vector<RangeIndex> index(config::ADC_CHANNELS);
+    std::vector<uint8_t> reply(config::REPLY_SIZE);
+    size_t bad_replies = 0;
+    std::string error;
+    while (raw_file.read(reinterpret_cast<char*>(reply.data()), reply.size())) {
+        std::vector<double> values = util::adc_decode(reply, error);
+        if (values.size() != config::ADC_CHANNELS) {
+            ++bad_replies;
+            continue;
+        }
+        for (size_t k = 0; k < config::ADC_CHANNELS; ++k) {
+            index[k].add(values[k]);
+        }
+    }
+
+    double period = vm["period"].as<double>() / 1000.0;
+    uint64_t begin = static_cast<uint64_t>(std::max(0.0, vm["from"].as<double>()) / period);
+    uint64_t end = index[0].size();
+    if (vm.count("to")) {
+        end = static_cast<uint64_t>(std::max(0.0, vm["to"].as<double>()) / period);
+    }
+
+    std::cout << "read " << index[0].size() << " replies (" << bad_replies << " malformed), querying samples [" << begin << ", " << end << ")\n";
+    std::cout << std::left << std::setw(16) << "channel" << std::right << std::setw(10) << "count" << std::setw(12) << "min" << std::setw(12) << "max" << std::setw(12) << "mean" << "\n";
+    for (size_t k: channels) {
+        RangeSummary summary = index[k].query(begin, end);
+        std::cout << std::left << std::setw(16) << config::adc_ch_names[k] << std::right << std::setw(10) << summary.count;
+        std::cout << std::fixed << std::setprecision(3) << std::setw(12) << summary.min << std::setw(12) << summary.max << std::setw(12) << summary.mean() << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,213 @@
+#include "capture.h"
+#include "trace.h"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <limits>
+
+ADCCapture::ADCCapture(size_t pre_samples, size_t post_samples, std::string directory):
+        ring(pre_samples + 1 + post_samples),
+        pre_samples(pre_samples),
+        post_samples(post_samples),
+        directory(directory)
+{
+    capture_count = 0;
+    ignored_count = 0;
+    armed = false;
+    post_remaining = 0;
+    trigger_time = 0;
+    staging_time = 0;
+    writer_busy = false;
+    writer_quit = false;
+
+    for (auto& l: limits) {
+        l = std::make_pair(-std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity());
+    }
+    hysteresis.fill(0.0);
+    outside.fill(false);
+
+    staging.reserve(ring.capacity());
+    writer = std::thread(&ADCCapture::write_loop, this);
+}
+
+ADCCapture::~ADCCapture() {
+    // write out whatever post-trigger data made it in before quitting.
+    if (armed) {
+        complete();
+    }
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        writer_quit = true;
+    }
+    wake.notify_all();
+    writer.join();
+}
+
+void ADCCapture::set_limits(size_t channel, double low, double high, double hysteresis) {
+    if (channel < limits.size()) {
+        limits[channel] = std::make_pair(low, high);
+        this->hysteresis[channel] = hysteresis;
+        outside[channel] = false;
+    }
+}
+
+void ADCCapture::push(const ADCSample& sample) {
+    ring.push(sample);
+
+    // track every channel on every sample, so one that left its limits during a capture doesn't fire again after it.
+    size_t left = config::ADC_CHANNELS;
+    for (size_t k = 0; k < config::ADC_CHANNELS; ++k) {
+        double value = sample.values[k];
+        if (outside[k]) {
+            outside[k] = value < limits[k].first + hysteresis[k] || value > limits[k].second - hysteresis[k];
+        } else if (value < limits[k].first || value > limits[k].second) {
+            outside[k] = true;
+            if (left == config::ADC_CHANNELS) {
+                left = k;
+            }
+        }
+    }
+
+    if (armed) {
+        if (post_remaining > 0) {
+            --post_remaining;
+        }
+        if (post_remaining == 0) {
+            complete();
+        }
+        return;
+    }
+
+    if (left < config::ADC_CHANNELS) {
+        trigger("threshold: " + config::adc_ch_names[left]);
+    }
+}
+
+bool ADCCapture::trigger(const std::string& reason) {
+    if (armed || ring.size() == 0) {
+        ++ignored_count;
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (writer_busy) {
+            ++ignored_count;
+            return false;
+        }
+    }
+
+    armed = true;
+    post_remaining = post_samples;
+    trigger_reason = reason;
+    trigger_time = ring.back().time;
+    if (post_remaining == 0) {
+        complete();
+    }
+    return true;
+}
+
+bool ADCCapture::pending() {
+    return armed;
+}
+
+size_t ADCCapture::queued() {
+    std::lock_guard<std::mutex> guard(lock);
+    return writer_busy ? staging.size() : 0;
+}
+
+size_t ADCCapture::captures() {
+    std::lock_guard<std::mutex> guard(lock);
+    return capture_count;
+}
+
+std::string ADCCapture::last_path() {
+    std::lock_guard<std::mutex> guard(lock);
+    return last_file;
+}
+
+std::string ADCCapture::status() {
+    if (armed) {
+        return "capturing (" + std::to_string(post_remaining) + " to go)";
+    }
+    std::lock_guard<std::mutex> guard(lock);
+    if (writer_busy) {
+        return "writing capture";
+    }
+    return "captures: " + std::to_string(capture_count);
+}
+
+void ADCCapture::complete() {
+    armed = false;
+    size_t window = std::min(ring.size(), pre_samples + 1 + post_samples);
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        staging.clear();
+        for (size_t k = ring.size() - window; k < ring.size(); ++k) {
+            staging.push_back(ring[k]);
+        }
+        staging_reason = trigger_reason;
+        staging_time = trigger_time;
+        writer_busy = true;
+    }
+    wake.notify_one();
+}
+
+void ADCCapture::write_loop() {
+    trace::set_thread_name("capture writer");
+    std::unique_lock<std::mutex> guard(lock);
+    while (true) {
+        wake.wait(guard, [this] { return writer_busy || writer_quit; });
+        if (writer_busy) {
+            // the polling thread won't touch staging until writer_busy is cleared.
+            guard.unlock();
+            bool written;
+            {
+                trace::Span span("write capture", "log", staging_reason);
+                written = write_capture();
+            }
+            guard.lock();
+            writer_busy = false;
+            if (written) {
+                ++capture_count;
+            }
+        }
+        if (writer_quit) {
+            return;
+        }
+    }
+}
+
+bool ADCCapture::write_capture() {
+    // capture_count is only changed by this thread, so it can be read without locking.
+    std::string path = directory + "/capture_" + util::get_now_string() + "_" + std::to_string(capture_count) + ".csv";
+    std::ofstream out(path, std::ios::out);
+    if (!out.is_open()) {
+        std::cout << "couldn't open capture file " << path << "\n";
+        return false;
+    }
+
+    const TimeAnchor& anchor = session_anchor();
+    out << "# trigger: " << staging_reason << "\n";
+    out << "# trigger time: " << util::format_time(anchor.to_wall(staging_time)) << "\n";
+    out << anchor.header() << "\n";
+    out << "Time,Steady ns,Offset (s)";
+    for (auto& name: config::adc_ch_names) {
+        out << "," << name;
+    }
+    out << "\n";
+
+    for (auto& sample: staging) {
+        double offset = (sample.time - staging_time) * 1e-9;
+        out << util::format_time(anchor.to_wall(sample.time)) << "," << sample.time << "," << std::fixed << std::setprecision(3) << offset;
+        for (auto& v: sample.values) {
+            out << "," << v;
+        }
+        out << "\n";
+    }
+    out.close();
+
+    std::lock_guard<std::mutex> guard(lock);
+    last_file = path;
+    return true;
+}
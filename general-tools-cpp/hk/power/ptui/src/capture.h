@@ -0,0 +1,145 @@
+#pragma once
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <array>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "parameters.h"
+#include "ring.h"
+#include "timestamp.h"
+
+/**
+ * @brief One decoded power board reading, tagged with the time it was received.
+ *
+ * `time` is in `std::chrono::steady_clock` nanoseconds (see `steady_ns`). It is converted to wall-clock time with `session_anchor()` only when a capture is written.
+ */
+struct ADCSample {
+    int64_t time;
+    std::array<double, config::ADC_CHANNELS> values;
+};
+
+/**
+ * @brief A pre-trigger capture buffer for power board readings, like an oscilloscope's.
+ *
+ * Every decoded sample is kept in a fixed-size ring. When a trigger fires (a channel leaves its limits, a decoding fault, or a manual request), the capture waits for the post-trigger window to fill, then hands the whole window to a background thread which writes it to `capture_*.csv` in its directory (`log/` by default). Acquisition keeps running the whole time, and nothing on the polling path allocates after construction.
+ */
+class ADCCapture {
+    public:
+        /**
+         * @brief Construct a new ADCCapture object.
+         *
+         * @param pre_samples number of samples to keep from before the trigger.
+         * @param post_samples number of samples to record after the trigger.
+         * @param directory where to write capture files. It must already exist.
+         */
+        ADCCapture(size_t pre_samples, size_t post_samples, std::string directory = "log");
+        ~ADCCapture();
+
+        /**
+         * @brief Add a newly decoded sample.
+         *
+         * Checks the sample against the trigger limits, and completes a pending capture once the post-trigger window is full.
+         *
+         * @param sample the decoded reading.
+         */
+        void push(const ADCSample& sample);
+
+        /**
+         * @brief Fire a trigger on the most recent sample.
+         *
+         * @param reason a short description written into the capture file header.
+         * @return true if a new capture was started.
+         * @return false if a capture is already pending or being written.
+         */
+        bool trigger(const std::string& reason);
+
+        /**
+         * @brief Set the threshold trigger limits for one channel.
+         *
+         * A sample that takes `channel` outside `[low, high]` fires a trigger. The channel then has to come back inside the limits by at least `hysteresis` before it can fire again, so a channel that stays out of limits triggers once, not every window. Use infinities to disable.
+         *
+         * @param channel the ADC channel index, see `config::adc_ch_names`.
+         * @param low the lowest allowed value.
+         * @param high the highest allowed value.
+         * @param hysteresis how far back inside the limits a channel must come to re-arm its trigger.
+         */
+        void set_limits(size_t channel, double low, double high, double hysteresis = 0.0);
+
+        /**
+         * @brief Check if a trigger has fired and its post-trigger window is still filling.
+         */
+        bool pending();
+        /**
+         * @brief Number of samples handed to the writer thread and not yet written. Thread safe.
+         */
+        size_t queued();
+
+        /**
+         * @brief A short status string for display.
+         */
+        std::string status();
+
+        /**
+         * @brief Number of capture files written. Thread safe.
+         */
+        size_t captures();
+        /**
+         * @brief Path of the most recently written capture file, or empty. Thread safe.
+         */
+        std::string last_path();
+
+        /**
+         * @brief Number of triggers ignored because another capture was in progress.
+         */
+        size_t ignored_count;
+
+    private:
+        /**
+         * @brief Background loop that writes completed windows to disk.
+         */
+        void write_loop();
+        /**
+         * @brief Copy the finished window out of the ring for the writer thread.
+         */
+        void complete();
+        /**
+         * @brief Format and write `staging` to a new capture file.
+         *
+         * @return true if the file was written.
+         */
+        bool write_capture();
+
+        RingBuffer<ADCSample> ring;
+        size_t pre_samples;
+        size_t post_samples;
+        std::string directory;
+        std::array<std::pair<double, double>, config::ADC_CHANNELS> limits;
+        std::array<double, config::ADC_CHANNELS> hysteresis;
+        // whether each channel was out of limits on the last sample
+        std::array<bool, config::ADC_CHANNELS> outside;
+
+        bool armed;
+        size_t post_remaining;
+        std::string trigger_reason;
+        int64_t trigger_time;
+
+        // shared with the writer thread, guarded by `lock`:
+        std::mutex lock;
+        std::condition_variable wake;
+        bool writer_busy;
+        bool writer_quit;
+        std::vector<ADCSample> staging;
+        std::string staging_reason;
+        int64_t staging_time;
+        // only changed by the writer thread
+        size_t capture_count;
+        std::string last_file;
+        std::thread writer;
+};
+
+#endif
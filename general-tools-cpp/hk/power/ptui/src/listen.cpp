@@ -1,9 +1,22 @@
 #include "parameters.h"
 #include "listen.h"
+#include "trace.h"
 #include <sstream>
+#include <iomanip>
 #include <boost/bind.hpp>
 
-HKADCNode::HKADCNode(boost::asio::ip::tcp::endpoint &local, boost::asio::io_context &io_context): 
+HKADCNode::HKADCNode(boost::asio::ip::tcp::endpoint &local, boost::asio::io_context &io_context, std::chrono::milliseconds poll_period): 
+        capture(util::poll_count(config::capture_pre_seconds, poll_period), util::poll_count(config::capture_post_seconds, poll_period)),
+        stats(config::adc_ch_names, "log/stats_" + util::get_now_string() + ".csv", config::stats_rollup_period),
+        history(config::ADC_CHANNELS),
+        index(config::ADC_CHANNELS),
+        alarms(config::adc_ch_names, "log/alarms_" + util::get_now_string() + ".log"),
+        wire("log/wire_" + util::get_now_string() + ".csv"),
+        latency("ptui", {"request_adc"}, "log/latency_" + util::get_now_string() + ".txt"),
+        metrics("ptui"),
+        link(metrics),
+        shm("ptui", config::adc_ch_names, util::poll_count(config::shm_history_seconds, poll_period)),
+        attach("ptui", config::adc_ch_names),
         context(io_context), 
         socket(io_context)
 {
@@ -22,15 +35,32 @@ HKADCNode::HKADCNode(boost::asio::ip::tcp::endpoint &local, boost::asio::io_cont
     csv_file.open("log/parse_" + util::get_now_string() + ".csv", std::ios::out | std::ios::app);
     csv_first = true;
     poll_started = false;
+
+    std::string shm_error;
+    if (!shm.open(config::shm_name, shm_error)) {
+        std::cout << "not publishing to shared memory: " << shm_error << "\n";
+    }
+
+    alarms.on_event = [this](const AlarmEvent& event) {
+        attach.publish_alarm(event);
+    };
+    metrics.gauge("hk_capture_queue_depth", "Samples waiting to be written by the capture thread.", [this] {
+        return static_cast<double>(capture.queued());
+    });
 }
 
 bool HKADCNode::setup_socket(boost::asio::ip::tcp::endpoint &target) {
     if (socket.is_open()) {
         try {
             socket.connect(target);
+            if (link.connects.value() > 0) {
+                link.reconnects.add();
+            }
+            link.connects.add();
             return true;
         } catch (std::exception &e) {
             std::cout << "connect error: " << e.what() << "\n";
+            link.connect_errors.add();
             return false;
         }
     } else {
@@ -42,6 +72,26 @@ bool HKADCNode::setup_socket(boost::asio::ip::tcp::endpoint &target) {
     }
 }
 
+bool HKADCNode::load_alarms(const std::string& path, std::string& error) {
+    if (!alarms.load(path, error)) {
+        return false;
+    }
+    // capture on the same limits that raise a red alarm, so the two can't disagree
+    for (size_t k = 0; k < config::ADC_CHANNELS; ++k) {
+        const AlarmLimit& limit = alarms.limit(k);
+        capture.set_limits(k, limit.red_low, limit.red_high, limit.hysteresis);
+    }
+    return true;
+}
+
+bool HKADCNode::set_wire_timestamps(bool enable, std::string& error) {
+    if (!enable) {
+        wire.disable(socket.native_handle());
+        return true;
+    }
+    return wire.enable(socket.native_handle(), error);
+}
+
 void HKADCNode::sync_write(std::vector<uint8_t> data) {
     try {
         socket.async_send(
@@ -126,56 +176,131 @@ void HKADCNode::async_read_handler(const boost::system::error_code &ec, std::siz
     *out_length = length;
 }
 
+bool HKADCNode::wait_for_reply() {
+    // only wait here; the reply itself is read with a plain (or timestamped) receive once it's there.
+    socket.async_wait(boost::asio::ip::tcp::socket::wait_read, [](const boost::system::error_code&) {});
+    return !run_context_until();
+}
+
 bool HKADCNode::run_context_until() {
     context.restart();
     context.run_for(io_timeout);
     if (!context.stopped()) {
         socket.cancel();
         context.run();
+        link.timeouts.add();
         return true;
     }
     return false;
 }
 
-void HKADCNode::poll_adc() {
+bool HKADCNode::poll_adc() {
     if (!poll_started) {
-        return;
+        return true;
     }
-    socket.send(boost::asio::buffer(config::request_adc));
+    trace::Span span("poll cycle", "poll");
+    link.polls.add();
+    PhaseProfiler::Lap timer(profile);
+    wire.before_send(socket.native_handle());
+    int64_t send_time = steady_now_ns();
+    link.bytes_sent.add(socket.send(boost::asio::buffer(config::request_adc)));
+    timer.lap(PollPhase::send);
     std::vector<uint8_t> reply;
     size_t target_size = config::REPLY_SIZE;
     reply.resize(target_size);
-    size_t reply_size = socket.receive(boost::asio::buffer(reply));
+    if (!wait_for_reply()) {
+        timer.lap(PollPhase::wait);
+        trace::instant("reply timeout", "poll");
+        capture.trigger("fault: no reply");
+        return false;
+    }
+    size_t reply_size = wire.enabled() ? wire.receive(socket.native_handle(), reply.data(), reply.size()) : socket.receive(boost::asio::buffer(reply));
+    // stamp the reply once, as soon as it arrives:
+    int64_t receive_time = steady_now_ns();
+    timer.lap(PollPhase::wait);
+    link.bytes_received.add(reply_size);
+    if (wire.enabled()) {
+        wire.finish(socket.native_handle(), receive_time);
+    }
+    if (reply_size > 0) {
+        latency.add(0, send_time, receive_time);
+    }
+    timer.lap(PollPhase::record);
+    auto now = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(receive_time));
     
     if (reply_size == target_size) {
         reply.resize(reply_size);
         sync_write(raw_file, reply);
         raw_file.flush();
+        timer.lap(PollPhase::raw);
 
         ++linecounter;
+        link.replies.add();
 
         last_reading = adc_table(reply);
+        timer.lap(PollPhase::decode);
+        if (last_reading.size() != config::ADC_CHANNELS) {
+            capture.trigger("fault: " + debug_msg);
+            return true;
+        }
+        ADCSample sample;
+        sample.time = receive_time;
+        std::copy(last_reading.begin(), last_reading.end(), sample.values.begin());
+        capture.push(sample);
+        shm.publish(receive_time, last_reading);
+
+        for (size_t k = 0; k < config::ADC_CHANNELS; ++k) {
+            stats.add(k, now, last_reading[k]);
+            history[k].add(now, last_reading[k]);
+            index[k].add(now, last_reading[k]);
+
+            AlarmLevel before = alarms.level(k);
+            if (alarms.check(k, last_reading[k]) == AlarmLevel::red && before != AlarmLevel::red) {
+                capture.trigger("alarm: " + config::adc_ch_names[k]);
+            }
+        }
+        if (attach.is_open()) {
+            std::vector<AlarmLevel> levels(config::ADC_CHANNELS);
+            for (size_t k = 0; k < config::ADC_CHANNELS; ++k) {
+                levels[k] = alarms.level(k);
+            }
+            attach.publish_sample(receive_time, last_reading, levels);
+        }
+        timer.lap(PollPhase::record);
+
         displayable_reading.clear();
         format_table.clear();
-        format_table.push_back({"System", "Voltage", "Current"});
+        format_table.push_back({"System", "Voltage", "Current", "mean", "stddev", "min", "max"});
         for (size_t k = 0; k < 16; ++k) {
             if (k < 12) {
                 std::stringstream v_stream;
                 v_stream << std::fixed << std::setprecision(3) << last_reading[config::v_map[k]];
                 std::stringstream i_stream;
                 i_stream << std::fixed << std::setprecision(3) << last_reading[config::i_map[k]];
-                format_table.push_back({config::measure_names[k], v_stream.str(), i_stream.str()});
+                std::vector<std::string> row = {config::measure_names[k], v_stream.str(), i_stream.str()};
+                for (auto& col: StatsBank::columns(stats.channels[config::i_map[k]].minute.query(now), 3)) {
+                    row.push_back(col);
+                }
+                format_table.push_back(row);
             }
             std::stringstream stream;
             stream << std::fixed << std::setprecision(3) << last_reading[k];
             displayable_reading.push_back({config::adc_ch_names[k], stream.str()});
             debug_msg = config::adc_ch_names[k];
         }
+        timer.lap(PollPhase::format);
         // call this after setting displayable_reading, to avoid missing last packet before quit.
-        csv_write();
+        csv_write(receive_time);
+        timer.lap(PollPhase::csv);
+        stats.rollup(now, util::get_now_string());
+        timer.lap(PollPhase::record);
     } else {
         std::cout << "got reply size: " << std::to_string(reply_size);
+        trace::instant("short reply", "poll");
+        link.short_reads.add();
+        capture.trigger("fault: reply size " + std::to_string(reply_size));
     }
+    return true;
 }
 
 void HKADCNode::handle_adc_write() {
@@ -205,74 +330,35 @@ void HKADCNode::handle_adc_reply(const boost::system::error_code& err, std::size
     }
 }
 
-void HKADCNode::csv_write() {
+void HKADCNode::csv_write(int64_t time) {
     if (displayable_reading.size() != 16) {
         return;
     }
 
     // linecounter = 0;
-    std::string now_line = util::get_now_string();
     std::string header = "";
     
     if (csv_first) {
-        header += "Time";
+        header += session_anchor().header() + "\n";
+        header += "Steady ns";
         for (auto& s: displayable_reading) {
             header += "," + s[0];
         }
         header += "\n";
         csv_first = false;
     }
-    header += now_line;
+    header += std::to_string(time);
     for (auto& s: displayable_reading) {
         header += "," + s[1];
     }
     header += "\n";
     
-    char* writable = new char[header.size()];
-    std::copy(header.begin(),header.end(),writable);
-    csv_file.write(writable, header.size());
+    csv_file.write(header.data(), header.size());
     csv_file.flush();
 }
 
 std::vector<double> HKADCNode::adc_table(std::vector<uint8_t>& data) {
-    if (data.size() != config::REPLY_SIZE) {
-        debug_msg = "adc wrong packet size!";
-        return {};
-    }
-
-    uint16_t raw_5v_src = adc_range_to_uint16_t(data, 6);
-    uint16_t ch_5v = raw_5v_src >> 12;
-    if (ch_5v != 0x03) {
-        // error, read the wrong channel.
-        debug_msg = "adc 5v ch error!";
-        return {};
-    }
-
-    double ref_5v = 5.0;
-    double current_gain = 0.2;
-    std::vector<double> v_divider_coefficients = {9.2, 2.0, 4.0, 1.68};
-    double measured_5v = v_divider_coefficients[3] * ref_5v * (raw_5v_src & 0x0fff) / 0x0fff;
-
-    std::vector<double> result(16);
-    for (size_t i = 0; i < config::REPLY_SIZE; i += 2) {
-        uint16_t raw = adc_range_to_uint16_t(data, i);
-        uint16_t ch = raw >> 12;
-
-        double this_ratiometric = ref_5v * (raw & 0x0fff) / 0x0fff;
-        if (ch < 4){
-            if (ch == 0x03) {
-                // result.insert(std::make_pair(ch_names[ch], measured_5v));
-                result[ch] = measured_5v;
-            } else {
-                // result.insert(std::make_pair(ch_names[ch], v_divider_coefficients[ch] * this_ratiometric));
-                result[ch] = v_divider_coefficients[ch] * this_ratiometric;
-            }
-        } else {
-            // result.insert(std::make_pair(ch_names[ch], (this_ratiometric - measured_5v/2) / current_gain));
-            result[ch] = (this_ratiometric - measured_5v/2) / current_gain;
-        }
-    }
-    return result;
+    return util::adc_decode(data, debug_msg);
 }
 
 uint16_t HKADCNode::adc_range_to_uint16_t(std::vector<uint8_t>& data, size_t start) {
@@ -11,6 +11,18 @@
 #include <iostream>
 #include <ctime>                // for timestamping
 #include "parameters.h"
+#include "capture.h"
+#include "stats.h"
+#include "history.h"
+#include "rangeindex.h"
+#include "alarm.h"
+#include "timestamp.h"
+#include "wiretime.h"
+#include "latency.h"
+#include "profiler.h"
+#include "metrics.h"
+#include "shm.h"
+#include "attach.h"
 
 /**
  * @brief A class to query the Housekeeping board's ADC subsystem.
@@ -24,8 +36,9 @@ class HKADCNode {
          * 
          * @param local the local endpoint to bind to.
          * @param io_context the `boost::asio` `io_context` used to manage communication.
+         * @param poll_period time between polls, which sets how many readings the capture windows and shared memory hold.
          */
-        HKADCNode(boost::asio::ip::tcp::endpoint &local, boost::asio::io_context& io_context);
+        HKADCNode(boost::asio::ip::tcp::endpoint &local, boost::asio::io_context& io_context, std::chrono::milliseconds poll_period = config::adc_poll_period);
 
         // socket should already be bound by the time these are called:
 
@@ -75,10 +88,11 @@ class HKADCNode {
         /**
          * @brief Synchronously write data to `::csv_file`. 
          * 
-         * This will write the buffer currently stored in `::displayable_reading` (recently obtained Housekeeping board power readings) to the `::csv_file` for storage. A time tag will be added in front with millisecond precision. 
+         * This will write the buffer currently stored in `::displayable_reading` (recently obtained Housekeeping board power readings) to the `::csv_file` for storage, with `time` in front. The first write also records the session's `TimeAnchor` in a `#` comment line, so rows can be converted to wall-clock time later.
          * 
+         * @param time when the reading was received, in `steady_clock` nanoseconds (see `steady_ns`).
          */
-        void csv_write();
+        void csv_write(int64_t time);
 
         /**
          * @brief Internal function for ADC responses.
@@ -97,8 +111,12 @@ class HKADCNode {
          * This function polls the Housekeeping board for new power readings, stores those readings in the CSV and raw data files, and populates other fields for the FTXUI display to use.
          * 
          * This can be called on a timer in a background thread to continuously update the display or continuously store power readings.
+         *
+         * Waits at most `::io_timeout` for each reply, so a board that stops answering (while the TCP connection stays up) can't block the caller.
+         *
+         * @return false if the board didn't reply in time. The socket may still deliver the late reply, so reconnect before polling again.
          */
-        void poll_adc();
+        bool poll_adc();
 
         /**
          * @brief Parse a received 32-byte message from the Housekeeping board into a list of voltage/current values.
@@ -135,6 +153,73 @@ class HKADCNode {
          */
         std::string debug_msg;
 
+        /**
+         * @brief Pre-trigger capture buffer holding the most recent decoded readings.
+         */
+        ADCCapture capture;
+        /**
+         * @brief Streaming statistics for each ADC channel, see `config::adc_ch_names`.
+         */
+        StatsBank stats;
+        /**
+         * @brief Decimated min/max history for each ADC channel, for trend plots.
+         */
+        std::vector<DecimatedHistory> history;
+        /**
+         * @brief Session-long range query index for each ADC channel.
+         */
+        std::vector<TimedRangeIndex> index;
+        /**
+         * @brief Limit checking for each ADC channel. Limits are disabled until loaded with `AlarmEngine::load`.
+         */
+        AlarmEngine alarms;
+        /**
+         * @brief Optional kernel timestamps for each ADC request/reply, separating wire round trip from our own delay. Off until enabled with `::set_wire_timestamps`.
+         */
+        WireTimer wire;
+        /**
+         * @brief Round-trip latency of each `request_adc` poll, from send to reply. Summarized to `log/latency_*.txt` at exit.
+         */
+        LatencyBank latency;
+        /**
+         * @brief Time spent in each phase of the poll cycle (and in rendering, timed by the UI).
+         */
+        PhaseProfiler profile;
+        /**
+         * @brief Counters and gauges served on the metrics page (see `MetricsServer`).
+         */
+        MetricsRegistry metrics;
+        /**
+         * @brief Link health counters (polls, replies, short reads, timeouts, bytes, connections), registered in `::metrics`.
+         */
+        LinkMetrics link;
+        /**
+         * @brief Publishes each reading to shared memory (`config::shm_name`) for other local programs, see `shm_layout`.
+         */
+        ShmPublisher shm;
+        /**
+         * @brief Serves each reading and alarm to attached UI clients once started (by `ptuid --attach`), see `attach_protocol`.
+         */
+        AttachServer attach;
+
+        /**
+         * @brief Load alarm limits into `alarms`, and set `capture`'s threshold triggers from their red limits.
+         *
+         * @param path the alarm limits JSON file, see `AlarmEngine`.
+         * @param error set to a description of the problem if loading fails.
+         * @return true if the file was loaded.
+         */
+        bool load_alarms(const std::string& path, std::string& error);
+
+        /**
+         * @brief Turn kernel (`SO_TIMESTAMPING`) timestamps on the board socket on or off.
+         * 
+         * @param enable true to turn timestamps on.
+         * @param error set to a description of the problem if they couldn't be turned on.
+         * @return true if timestamps are now in the requested state.
+         */
+        bool set_wire_timestamps(bool enable, std::string& error);
+
         /**
          * @brief Set the up the local socket and connect to `target`.
          * 
@@ -179,6 +264,12 @@ class HKADCNode {
          * @return false 
          */
         bool run_context_until();
+        /**
+         * @brief Wait up to `::io_timeout` for the socket to have a reply to read.
+         *
+         * @return false if nothing arrived in time.
+         */
+        bool wait_for_reply();
         /**
          * @brief Internal method for managing read timeouts/retries.
          * 
@@ -190,7 +281,7 @@ class HKADCNode {
         void async_read_handler(const boost::system::error_code &ec, std::size_t length, boost::system::error_code *out_ec, std::size_t *out_length);
 
         /**
-         * @brief Duration to wait for response (in `::async_read`) before trying again or abandoning.
+         * @brief Duration to wait for a response (in `::async_read` and each poll) before trying again or abandoning.
          */
         std::chrono::milliseconds io_timeout;
         /**
@@ -1,28 +1,70 @@
 #include "parameters.h"
+#include "timestamp.h"
+#include <algorithm>
 #include <chrono>
 #include <ctime>
-#include <sys/time.h>
+#include <iomanip>
+#include <sstream>
 
 std::string util::get_now_string() {
-    char time_format[std::size("yyyy-mm-dd_hh-mm-ss")];
-    auto start_time = std::time({});
+    return format_time(std::chrono::system_clock::now());
+}
+std::string util::get_now_millis() {
+    auto millisec = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count() % 1000;
 
-    std::strftime(std::data(time_format), std::size(time_format), "%F_%H-%M-%S", std::gmtime(&start_time));
+    std::stringstream result;
+    result << std::setw(3) << std::setfill('0') << millisec;
+    return result.str();
+}
+std::string util::format_time(std::chrono::system_clock::time_point time) {
+    return ::format_time(time);
+}
 
-    return std::string(time_format) + "-" + get_now_millis();
+uint16_t util::bytes_to_uint16_t(std::vector<uint8_t>& data, size_t start) {
+    return (static_cast<uint16_t>(data[start]) << 8) | data[start + 1];
 }
-std::string util::get_now_millis() {
-    int millisec;
-    struct tm* tm_info;
-    struct timeval tv;
 
-    gettimeofday(&tv, NULL);
+std::vector<double> util::adc_decode(std::vector<uint8_t>& data, std::string& error) {
+    if (data.size() != config::REPLY_SIZE) {
+        error = "adc wrong packet size!";
+        return {};
+    }
 
-    millisec = lrint(tv.tv_usec/1000.0); // Round to nearest millisec
-    if (millisec>=1000) { // Allow for rounding up to nearest second
-        millisec -=1000;
-        tv.tv_sec++;
+    uint16_t raw_5v_src = bytes_to_uint16_t(data, 6);
+    uint16_t ch_5v = raw_5v_src >> 12;
+    if (ch_5v != 0x03) {
+        // error, read the wrong channel.
+        error = "adc 5v ch error!";
+        return {};
     }
 
-    return std::to_string(millisec);
+    double ref_5v = 5.0;
+    double current_gain = 0.2;
+    std::vector<double> v_divider_coefficients = {9.2, 2.0, 4.0, 1.68};
+    double measured_5v = v_divider_coefficients[3] * ref_5v * (raw_5v_src & 0x0fff) / 0x0fff;
+
+    std::vector<double> result(16);
+    for (size_t i = 0; i < config::REPLY_SIZE; i += 2) {
+        uint16_t raw = bytes_to_uint16_t(data, i);
+        uint16_t ch = raw >> 12;
+
+        double this_ratiometric = ref_5v * (raw & 0x0fff) / 0x0fff;
+        if (ch < 4){
+            if (ch == 0x03) {
+                // result.insert(std::make_pair(ch_names[ch], measured_5v));
+                result[ch] = measured_5v;
+            } else {
+                // result.insert(std::make_pair(ch_names[ch], v_divider_coefficients[ch] * this_ratiometric));
+                result[ch] = v_divider_coefficients[ch] * this_ratiometric;
+            }
+        } else {
+            // result.insert(std::make_pair(ch_names[ch], (this_ratiometric - measured_5v/2) / current_gain));
+            result[ch] = (this_ratiometric - measured_5v/2) / current_gain;
+        }
+    }
+    return result;
+}
+
+size_t util::poll_count(size_t seconds, std::chrono::milliseconds period) {
+    return std::max<size_t>(1, seconds * 1000 / std::max<std::chrono::milliseconds::rep>(1, period.count()));
 }
\ No newline at end of file
@@ -6,10 +6,15 @@
 #include <string>
 #include <iostream>
 #include <unordered_map>
+#include <chrono>
 
 namespace config {
 // power board ADC reply message size
 static const size_t REPLY_SIZE = 0x20;
+// number of ADC channels in a power board reply
+static const size_t ADC_CHANNELS = 16;
+// default period between power board ADC polls (`--poll-period` overrides it)
+static const std::chrono::milliseconds adc_poll_period(500);
 
 // lookup table for power board switch channel by name
 static const std::unordered_map<std::string, uint8_t> token_lookup = {
@@ -107,12 +112,68 @@ static const std::vector<std::string> measure_names = {
     "saas camera", 
     "regulators" 
 };
+
+// seconds of history to keep in a capture from before the trigger
+static const size_t capture_pre_seconds = 30;
+// seconds of data to record in a capture after the trigger
+static const size_t capture_post_seconds = 10;
+
+// maps system name indices (in `names`) onto measurement indices (in `measure_names`) for the trend plot
+static const std::vector<size_t> trend_map = {
+    0,
+    1,
+    2,
+    3,
+    4,
+    5,
+    6,
+    7,
+    9
+};
+// time spans selectable for the trend plot
+static const std::vector<std::chrono::seconds> trend_spans = {
+    std::chrono::seconds(60),
+    std::chrono::seconds(600),
+    std::chrono::seconds(3600),
+    std::chrono::seconds(6 * 3600),
+    std::chrono::seconds(24 * 3600)
+};
+static const std::vector<std::string> trend_span_names = {
+    "1 min",
+    "10 min",
+    "1 h",
+    "6 h",
+    "24 h"
+};
+// width of the trend plot, in characters
+static const int trend_width = 60;
+
+// default alarm limit file
+static const std::string alarm_path = "config/alarms.json";
+
+// shared-memory segment the latest readings are published to, and how many seconds of recent readings it keeps
+static const std::string shm_name = "/foxsi_hk_ptui";
+static const size_t shm_history_seconds = 600;
+
+// Unix-domain socket `ptuid --attach` serves readings and takes commands on, for `ptui-attach` clients
+static const std::string attach_path = "/tmp/foxsi_hk_ptui.sock";
+
+// how often to append per-channel statistics to the stats log
+static const std::chrono::seconds stats_rollup_period(60);
 }; // namespace config
 namespace util {
-    // get current time as string
+    // get current time as string, including zero-padded milliseconds
     std::string get_now_string();
-    // get current time as string, including milliseconds
+    // format a time point as string, including milliseconds
+    std::string format_time(std::chrono::system_clock::time_point time);
+    // get the milliseconds part of the current time, zero-padded to three digits
     std::string get_now_millis();
+    // convert two bytes starting at `start` to uint16_t, big-endian
+    uint16_t bytes_to_uint16_t(std::vector<uint8_t>& data, size_t start);
+    // parse a raw ADC reply into voltage/current values (see `config::adc_ch_names`), or empty and set `error` on failure
+    std::vector<double> adc_decode(std::vector<uint8_t>& data, std::string& error);
+    // number of polls every `period` that fit in `seconds`, at least one
+    size_t poll_count(size_t seconds, std::chrono::milliseconds period);
 };
 
 #endif
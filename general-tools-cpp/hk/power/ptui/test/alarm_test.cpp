@@ -0,0 +1,55 @@
+#include "alarm.h"
+#include "parameters.h"
+#include "test_check.h"
+
+/**
+ * @brief Check AlarmEngine level changes, hysteresis and persistence against the shipped limits file.
+ */
+int main() {
+    int failures = 0;
+
+    AlarmEngine alarms(config::adc_ch_names, "");
+    std::string error;
+    failures += check(alarms.load(config::alarm_path, error), "load " + config::alarm_path + " " + error);
+
+    // with no limits on a channel, nothing alarms:
+    failures += check(alarms.check(6, 1000.0) == AlarmLevel::nominal, "unlimited channel stays nominal");
+
+    // 28 V rail: yellow outside [25.2, 30.8], red outside [22.4, 33.6], hysteresis 0.3, persistence 3
+    failures += check(alarms.check(0, 28.0) == AlarmLevel::nominal, "nominal reading");
+    alarms.check(0, 31.0);
+    alarms.check(0, 31.0);
+    failures += check(alarms.level(0) == AlarmLevel::nominal, "persistence delays yellow");
+    failures += check(alarms.check(0, 31.0) == AlarmLevel::yellow, "yellow after persistence");
+
+    // back inside the limit, but within the hysteresis band:
+    for (int k = 0; k < 5; ++k) {
+        alarms.check(0, 30.7);
+    }
+    failures += check(alarms.level(0) == AlarmLevel::yellow, "hysteresis holds yellow");
+    for (int k = 0; k < 3; ++k) {
+        alarms.check(0, 30.0);
+    }
+    failures += check(alarms.level(0) == AlarmLevel::nominal, "clears outside hysteresis band");
+
+    // a single glitch doesn't alarm:
+    alarms.check(0, 40.0);
+    alarms.check(0, 28.0);
+    alarms.check(0, 40.0);
+    alarms.check(0, 28.0);
+    failures += check(alarms.level(0) == AlarmLevel::nominal, "glitches are debounced");
+
+    // straight to red:
+    for (int k = 0; k < 3; ++k) {
+        alarms.check(0, 20.0);
+    }
+    failures += check(alarms.level(0) == AlarmLevel::red, "red below red_low");
+    failures += check(alarms.worst() == AlarmLevel::red, "worst level");
+    failures += check(alarms.events.size() == 3, "one event per level change");
+    failures += check(alarms.events.back().from == AlarmLevel::nominal && alarms.events.back().to == AlarmLevel::red, "event levels");
+
+    AlarmEngine other(config::adc_ch_names, "");
+    failures += check(!other.load("config/does_not_exist.json", error), "missing file fails to load");
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+#include "attach.h"
+#include "test_check.h"
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// wait up to a second for `done` to hold
+template <typename F>
+bool eventually(F done) {
+    for (int k = 0; k < 200; ++k) {
+        if (done()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return false;
+}
+
+/**
+ * @brief Check the attach server and client: hello, catch-up on attach, live samples and alarms, and command round trips.
+ */
+int main() {
+    int failures = 0;
+    std::string path = "/tmp/attach_test_" + std::to_string(getpid()) + ".sock";
+    std::string error;
+
+    AttachServer server("test", {"a", "b", "c"});
+    // publishing before starting is harmless:
+    server.publish_sample(1, {1.0, 2.0, 3.0}, {AlarmLevel::nominal, AlarmLevel::nominal, AlarmLevel::nominal});
+    failures += check(server.start(path, error), "server starts: " + error);
+
+    // something happens before anyone attaches:
+    AlarmEvent event{std::chrono::system_clock::now(), 1, AlarmLevel::nominal, AlarmLevel::red, 9.5};
+    server.publish_alarm(event);
+    server.publish_sample(100, {1.0, 9.5, std::nan("")}, {AlarmLevel::nominal, AlarmLevel::red, AlarmLevel::nominal});
+
+    AttachClient first;
+    failures += check(first.attach(path, error), "first client attaches: " + error);
+    failures += check(eventually([&] { return first.snapshot().samples == 1; }), "first client is caught up with the latest sample");
+    AttachState state = first.snapshot();
+    failures += check(state.connected && state.node == "test", "hello names the node");
+    failures += check(state.names == std::vector<std::string>({"a", "b", "c"}), "hello names the channels");
+    failures += check(state.time == 100 && state.index == 0, "sample time and number");
+    failures += check(state.values[1] == 9.5 && std::isnan(state.values[2]), "sample values, with NaN kept");
+    failures += check(state.levels[1] == AlarmLevel::red, "sample alarm levels");
+    failures += check(state.alarms.size() == 1 && state.alarms[0].channel == 1 && state.alarms[0].to == AlarmLevel::red, "recent alarm replayed on attach");
+
+    // two clients see the same live stream:
+    AttachClient second;
+    failures += check(second.attach(path, error), "second client attaches: " + error);
+    failures += check(eventually([&] { return server.clients.load() == 2; }), "server counts two clients");
+    for (int k = 0; k < 10; ++k) {
+        server.publish_sample(200 + k, {static_cast<double>(k), 0.0, 0.0}, {});
+    }
+    failures += check(eventually([&] { return first.snapshot().samples == 11 && second.snapshot().samples == 11; }), "both clients get every new sample");
+    failures += check(first.snapshot().values[0] == 9.0 && second.snapshot().index == 10, "clients hold the newest sample");
+
+    // commands are queued in arrival order, and results go back to the sender only:
+    uint32_t id = first.command({0x03, 0x07, 0x00});
+    failures += check(id != 0, "command sent");
+    AttachCommand command;
+    failures += check(eventually([&] { return server.next_command(command); }), "server receives the command");
+    failures += check(command.id == id && command.bytes == std::vector<uint8_t>({0x03, 0x07, 0x00}), "command bytes and ID");
+    failures += check(!server.next_command(command), "only one command waiting");
+    server.reply(command, attach_protocol::Status::sent, "");
+    failures += check(eventually([&] { return first.snapshot().last_result == "#" + std::to_string(id) + " sent"; }), "result reaches the sender");
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    failures += check(second.snapshot().last_result == "", "result doesn't reach other clients");
+
+    // detaching one client leaves the other attached:
+    second.detach();
+    failures += check(eventually([&] { return server.clients.load() == 1; }), "server notices a client detaching");
+    server.publish_alarm({std::chrono::system_clock::now(), 0, AlarmLevel::nominal, AlarmLevel::yellow, 1.0});
+    failures += check(eventually([&] { return first.snapshot().alarms.size() == 2; }), "remaining client gets live alarms");
+
+    // a second server can't take over a socket that's being served:
+    AttachServer rival("rival", {"a"});
+    failures += check(!rival.start(path, error) && error.find("already in use") != std::string::npos, "second server refuses a live socket");
+    failures += check(access(path.c_str(), F_OK) == 0, "live socket file left alone");
+
+    // stopping the server tells clients, and removes the socket:
+    server.stop();
+    failures += check(eventually([&] { return !first.snapshot().connected; }), "client notices the server stopping");
+    failures += check(access(path.c_str(), F_OK) != 0, "socket file removed");
+    failures += check(!second.attach(path, error), "can't attach to a stopped server");
+
+    // a socket file left behind by a server that died is replaced:
+    int stale = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    failures += check(bind(stale, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0, "make a stale socket file");
+    close(stale);
+    AttachServer restarted("test", {"a"});
+    failures += check(restarted.start(path, error), "server replaces a stale socket file: " + error);
+
+    // a server only removes the socket file it made:
+    unlink(path.c_str());
+    AttachServer replacement("test", {"a"});
+    failures += check(replacement.start(path, error), "replacement server starts: " + error);
+    restarted.stop();
+    failures += check(access(path.c_str(), F_OK) == 0, "stopping leaves another server's socket file");
+    replacement.stop();
+    failures += check(access(path.c_str(), F_OK) != 0, "replacement removes its own socket file");
+
+    if (failures == 0) {
+        std::cout << "all attach tests passed\n";
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,94 @@
+#include "capture.h"
+#include "ring.h"
+#include "test_check.h"
+#include <thread>
+#include <chrono>
+#include <fstream>
+#include <filesystem>
+#include <unistd.h>
+
+ADCSample make_sample(size_t k) {
+    ADCSample sample;
+    sample.time = 500000000 * static_cast<int64_t>(k);
+    sample.values.fill(static_cast<double>(k));
+    return sample;
+}
+
+/**
+ * @brief Check ADCCapture's pre/post-trigger windows and threshold triggers, writing capture files to `directory`.
+ */
+int check_capture(const std::string& directory) {
+    int failures = 0;
+
+    ADCCapture capture(3, 2, directory);
+    failures += check(!capture.trigger("empty"), "trigger with no samples is ignored");
+    for (size_t k = 0; k < 10; ++k) {
+        capture.push(make_sample(k));
+    }
+    failures += check(capture.trigger("manual"), "manual trigger starts capture");
+    failures += check(capture.pending(), "capture pending during post-trigger window");
+    failures += check(!capture.trigger("again"), "second trigger ignored while pending");
+    capture.push(make_sample(10));
+    capture.push(make_sample(11));
+    failures += check(!capture.pending(), "capture completes after post-trigger window");
+
+    // wait for the writer thread:
+    for (size_t k = 0; k < 100 && capture.captures() == 0; ++k) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    failures += check(capture.captures() == 1, "capture file written");
+
+    std::ifstream written(capture.last_path());
+    size_t lines = 0;
+    std::string line;
+    while (std::getline(written, line)) {
+        ++lines;
+    }
+    // three comment lines, one header, 3 pre + 1 trigger + 2 post samples
+    failures += check(lines == 10, "capture file has pre- and post-trigger rows");
+
+    capture.set_limits(0, -1.0, 100.0, 10.0);
+    capture.push(make_sample(200));
+    failures += check(capture.pending(), "threshold trigger starts capture");
+    capture.push(make_sample(201));
+    capture.push(make_sample(202));
+    failures += check(!capture.pending(), "threshold capture completes");
+    for (size_t k = 0; k < 100 && capture.captures() < 2; ++k) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    capture.push(make_sample(203));
+    failures += check(!capture.pending(), "channel staying out of limits doesn't trigger again");
+    capture.push(make_sample(95));
+    capture.push(make_sample(200));
+    failures += check(!capture.pending(), "channel inside limits by less than the hysteresis doesn't re-arm");
+    capture.push(make_sample(50));
+    capture.push(make_sample(200));
+    failures += check(capture.pending(), "channel back inside limits re-arms the trigger");
+
+    return failures;
+}
+
+/**
+ * @brief Check RingBuffer wraparound and ADCCapture pre/post-trigger windows.
+ */
+int main() {
+    int failures = 0;
+
+    RingBuffer<int> ring(4);
+    for (int k = 0; k < 6; ++k) {
+        ring.push(k);
+    }
+    failures += check(ring.size() == 4, "ring size after wrap");
+    failures += check(ring.total() == 6, "ring total after wrap");
+    failures += check(ring[0] == 2 && ring.back() == 5, "ring oldest/newest after wrap");
+
+    // write captures somewhere disposable, not into the source tree's log/
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / ("capture_test_" + std::to_string(::getpid()));
+    std::filesystem::create_directories(directory);
+
+    failures += check_capture(directory.string());
+
+    std::filesystem::remove_all(directory);
+
+    return failures == 0 ? 0 : 1;
+}
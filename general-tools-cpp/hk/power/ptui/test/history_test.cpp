@@ -0,0 +1,51 @@
+#include "history.h"
+#include "test_check.h"
+#include <cmath>
+#include <chrono>
+
+/**
+ * @brief Check that DecimatedHistory keeps extrema across levels and bounds query cost.
+ */
+int main() {
+    int failures = 0;
+
+    // 16 bins per level, 4x decimation, 4 levels: level 3 spans 1024 samples.
+    DecimatedHistory history(16, 4, 4);
+    auto t0 = std::chrono::steady_clock::time_point(std::chrono::hours(1000));
+    const int n = 1000;
+    for (int k = 0; k < n; ++k) {
+        // one spike, long ago, that only coarse levels still remember:
+        double value = (k == 100) ? 50.0 : static_cast<double>(k % 10);
+        history.add(t0 + std::chrono::seconds(k), value);
+    }
+    auto now = t0 + std::chrono::seconds(n - 1);
+    failures += check(history.count() == n, "sample count");
+
+    auto recent = history.envelope(now, std::chrono::seconds(8), 8);
+    bool recent_ok = true;
+    for (int k = 0; k < 8; ++k) {
+        double expect = static_cast<double>((n - 8 + k) % 10);
+        recent_ok &= recent[k].first == expect && recent[k].second == expect;
+    }
+    failures += check(recent_ok, "raw samples at finest level");
+
+    auto all = history.envelope(now, std::chrono::seconds(n), 10);
+    double peak = 0.0;
+    double floor = 100.0;
+    for (auto& col: all) {
+        if (!std::isnan(col.first)) {
+            peak = std::max(peak, col.second);
+            floor = std::min(floor, col.first);
+        }
+    }
+    failures += check(peak == 50.0, "spike survives decimation");
+    failures += check(floor == 0.0, "minimum survives decimation");
+    failures += check(all[9].second == 9.0, "newest partial bins included");
+
+    auto empty = history.envelope(t0 - std::chrono::hours(1), std::chrono::seconds(10), 4);
+    failures += check(std::isnan(empty[0].first), "no data before first sample");
+
+    failures += check(history.sparkline(now, std::chrono::seconds(10), 10).size() == 10 * std::string("▁").size(), "sparkline width");
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,46 @@
+#include "latency.h"
+#include "test_check.h"
+#include <random>
+#include <sstream>
+
+/**
+ * @brief Check LatencyHistogram bucketing precision and percentiles.
+ */
+int main() {
+    int failures = 0;
+
+    // every value lands in a bucket that contains it, and buckets are within 1/16 of their value wide:
+    bool contained = true;
+    bool precise = true;
+    std::mt19937_64 rng(34);
+    for (size_t trial = 0; trial < 100000; ++trial) {
+        uint64_t v = rng() >> (rng() % 64);
+        size_t k = LatencyHistogram::bucket(v);
+        contained &= k < LatencyHistogram::bucket_count && LatencyHistogram::bucket_low(k) <= v && v <= LatencyHistogram::bucket_high(k);
+        precise &= v < 32 || LatencyHistogram::bucket_high(k) - LatencyHistogram::bucket_low(k) < v / 16 + 1;
+    }
+    failures += check(contained, "values fall inside their bucket");
+    failures += check(precise, "buckets are within 1/16 of their value");
+
+    // 1 to 10 ms, uniform:
+    LatencyHistogram h;
+    for (int64_t k = 0; k < 10000; ++k) {
+        h.add(1000000 + k * 900);
+    }
+    failures += check(h.count() == 10000, "count");
+    failures += check(h.min() == 1000000 && h.max() == 1000000 + 9999 * 900, "exact min and max");
+    double p50 = h.percentile(0.5) * 1e-6;
+    double p99 = h.percentile(0.99) * 1e-6;
+    failures += check(p50 > 5.5 * 0.94 && p50 < 5.5 * 1.07, "p50 within bucket precision");
+    failures += check(p99 > 9.91 * 0.94 && p99 <= h.max() * 1e-6, "p99 within bucket precision");
+    failures += check(h.percentile(1.0) == h.max(), "p100 is max");
+
+    LatencyBank bank("test", {"a", "b"}, "");
+    bank.add(0, 100, 1100);
+    std::stringstream summary;
+    bank.write_summary(summary);
+    failures += check(summary.str().find("[b]\ncount 0") != std::string::npos, "summary lists empty request types");
+    failures += check(bank.brief(0).find("p50 0.00") != std::string::npos, "brief string");
+
+    return failures == 0 ? 0 : 1;
+}
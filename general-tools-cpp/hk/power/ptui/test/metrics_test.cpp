@@ -0,0 +1,66 @@
+#include "metrics.h"
+#include "test_check.h"
+#include <vector>
+#include <thread>
+
+// fetch `target` from the server with a bare HTTP/1.1 request, returning the whole response.
+std::string fetch(unsigned short port, std::string method, std::string target) {
+    boost::asio::io_context context;
+    boost::asio::ip::tcp::socket socket(context);
+    socket.connect(boost::asio::ip::tcp::endpoint(boost::asio::ip::make_address_v4("127.0.0.1"), port));
+    std::string request = method + " " + target + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    boost::asio::write(socket, boost::asio::buffer(request));
+    std::string response;
+    boost::system::error_code err;
+    boost::asio::read(socket, boost::asio::dynamic_buffer(response), err);
+    return response;
+}
+
+/**
+ * @brief Check sharded counters, the exposition format, and the /metrics endpoint.
+ */
+int main() {
+    int failures = 0;
+
+    MetricsRegistry registry("test");
+    LinkMetrics link(registry);
+    double depth = 3.0;
+    registry.gauge("hk_test_depth", "A test gauge.", [&] { return depth; });
+
+    // more threads than shards, so some share:
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < MetricCounter::shard_count + 4; ++t) {
+        threads.emplace_back([&] {
+            for (int k = 0; k < 10000; ++k) {
+                link.polls.add();
+                link.bytes_sent.add(3);
+            }
+        });
+    }
+    for (auto& t: threads) {
+        t.join();
+    }
+    uint64_t expected = (MetricCounter::shard_count + 4) * 10000;
+    failures += check(link.polls.value() == expected, "counts from every thread are summed");
+    failures += check(link.bytes_sent.value() == 3 * expected, "counts by more than one");
+
+    std::string page = registry.render();
+    failures += check(page.find("# TYPE hk_polls_total counter\nhk_polls_total{node=\"test\"} " + std::to_string(expected) + "\n") != std::string::npos, "counter exposition");
+    failures += check(page.find("# HELP hk_test_depth A test gauge.\n# TYPE hk_test_depth gauge\nhk_test_depth{node=\"test\"} 3\n") != std::string::npos, "gauge exposition");
+
+    MetricsServer server(registry);
+    std::string error;
+    failures += check(server.start(0, error), "server starts: " + error);
+    failures += check(server.port() != 0, "server reports its port");
+    depth = 5.0;
+    std::string response = fetch(server.port(), "GET", "/metrics");
+    failures += check(response.rfind("HTTP/1.1 200 OK\r\n", 0) == 0, "metrics page is served");
+    failures += check(response.find("Content-Type: text/plain; version=0.0.4") != std::string::npos, "exposition content type");
+    failures += check(response.find("hk_test_depth{node=\"test\"} 5\n") != std::string::npos, "gauges are read on scrape");
+    failures += check(fetch(server.port(), "GET", "/").rfind("HTTP/1.1 404", 0) == 0, "other paths are not found");
+    failures += check(fetch(server.port(), "POST", "/metrics").rfind("HTTP/1.1 405", 0) == 0, "only GET");
+    failures += check(server.scrapes == 1, "scrapes counted");
+    server.stop();
+
+    return failures == 0 ? 0 : 1;
+}
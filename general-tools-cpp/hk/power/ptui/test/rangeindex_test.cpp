@@ -0,0 +1,66 @@
+#include "rangeindex.h"
+#include "test_check.h"
+#include <random>
+#include <chrono>
+#include <iostream>
+
+/**
+ * @brief Check RangeIndex queries against a brute-force scan, then time queries over a large index.
+ */
+int main() {
+    int failures = 0;
+
+    std::mt19937 rng(4);
+    std::uniform_real_distribution<float> value(-10.0, 10.0);
+    std::vector<float> raw;
+    RangeIndex index(8);
+    for (size_t k = 0; k < 5000; ++k) {
+        raw.push_back(value(rng));
+        index.add(raw.back());
+    }
+
+    int mismatches = 0;
+    for (size_t trial = 0; trial < 2000; ++trial) {
+        uint64_t a = rng() % (raw.size() + 1);
+        uint64_t b = rng() % (raw.size() + 1);
+        uint64_t begin = std::min(a, b);
+        uint64_t end = std::max(a, b);
+
+        RangeSummary expect;
+        for (uint64_t k = begin; k < end; ++k) {
+            expect.add(raw[k]);
+        }
+        RangeSummary got = index.query(begin, end);
+        if (got.count != expect.count || (got.count > 0 && (got.min != expect.min || got.max != expect.max || std::abs(got.sum - expect.sum) > 1e-6))) {
+            ++mismatches;
+        }
+    }
+    failures += check(mismatches == 0, "queries match brute force");
+    failures += check(index.query(10, 10).count == 0, "empty range");
+    failures += check(index.query(4990, 1000000).count == 10, "range clamped to size");
+
+    TimedRangeIndex timed;
+    auto t0 = std::chrono::steady_clock::time_point(std::chrono::hours(1000));
+    for (int k = 0; k < 100; ++k) {
+        timed.add(t0 + std::chrono::seconds(k), k);
+    }
+    RangeSummary window = timed.query(t0 + std::chrono::seconds(10), t0 + std::chrono::seconds(20));
+    failures += check(window.count == 10 && window.min == 10.0 && window.max == 19.0, "time range query");
+
+    // 20 million samples, then many random queries:
+    RangeIndex large;
+    for (size_t k = 0; k < 20000000; ++k) {
+        large.add(static_cast<double>(k % 1000));
+    }
+    auto start = std::chrono::steady_clock::now();
+    double total = 0.0;
+    for (size_t trial = 0; trial < 100000; ++trial) {
+        uint64_t a = rng() % large.size();
+        total += large.query(a, a + 1 + rng() % (large.size() - a)).max;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "100000 queries over 20M samples: " << seconds << " s (" << total << ")\n";
+    failures += check(seconds < 5.0, "large queries are fast");
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,49 @@
+#include "scheduler.h"
+#include "test_check.h"
+#include <thread>
+#include <iostream>
+
+/**
+ * @brief Check that PeriodicScheduler keeps deadlines in phase while tasks take time, and counts missed deadlines.
+ */
+int main() {
+    int failures = 0;
+    using namespace std::chrono_literals;
+
+    PeriodicScheduler scheduler;
+    std::vector<std::chrono::steady_clock::time_point> deadlines;
+    size_t fast = scheduler.add("fast", 20ms, [&](std::chrono::steady_clock::time_point deadline) {
+        scheduler.record(0, deadline);
+        deadlines.push_back(deadline);
+        // work that would make a sleep-based loop drift by 25%:
+        std::this_thread::sleep_for(5ms);
+    });
+    std::thread runner([&] { scheduler.run(); });
+    std::this_thread::sleep_for(1s);
+    scheduler.stop();
+    runner.join();
+
+    bool in_phase = deadlines.size() > 1;
+    for (size_t k = 1; k < deadlines.size(); ++k) {
+        in_phase &= (deadlines[k] - deadlines[0]) % 20ms == 0ns;
+    }
+    failures += check(in_phase, "deadlines stay on the period grid");
+    failures += check(deadlines.size() + scheduler.tasks[fast].missed >= 45, "no drift from task run time");
+    failures += check(scheduler.tasks[fast].runs == deadlines.size(), "runs counted");
+    failures += check(scheduler.tasks[fast].jitter.total() == deadlines.size(), "jitter recorded for each run");
+    std::cout << scheduler.summary(fast) << "\n";
+
+    PeriodicScheduler overrun;
+    size_t slow = overrun.add("slow", 20ms, [&](std::chrono::steady_clock::time_point deadline) {
+        overrun.record(0, deadline);
+        std::this_thread::sleep_for(50ms);
+    });
+    std::thread overrun_runner([&] { overrun.run(); });
+    std::this_thread::sleep_for(500ms);
+    overrun.stop();
+    overrun_runner.join();
+    failures += check(overrun.tasks[slow].missed > 0, "overrunning task misses deadlines");
+    std::cout << overrun.summary(slow) << "\n";
+
+    return failures == 0 ? 0 : 1;
+}
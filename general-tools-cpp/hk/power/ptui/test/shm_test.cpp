@@ -0,0 +1,136 @@
+#include "shm.h"
+#include "test_check.h"
+#include <thread>
+#include <atomic>
+#include <cmath>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <memory>
+#include <cstring>
+
+// two publishers on one name: the second must leave the first's segment alone, and only a dead writer's segment is taken over
+int check_ownership(const std::string& name) {
+    int failures = 0;
+    std::string error;
+    auto first = std::make_unique<ShmPublisher>("first", std::vector<std::string>{"a"}, 4);
+    failures += check(first->open(name, error), "first publisher opens: " + error);
+    first->publish(1, {1.0});
+    {
+        ShmPublisher second("second", {"a", "b"}, 4);
+        failures += check(!second.open(name, error) && error.find("already in use") != std::string::npos, "second publisher is refused: " + error);
+    }
+    ShmReader reader;
+    ShmSample sample;
+    failures += check(reader.open(name, error) && reader.node == "first" && reader.latest(sample) && sample.values[0] == 1.0, "first segment survives the second publisher: " + error);
+
+    // pretend the first publisher's process has exited, by pointing the header at a child that has:
+    pid_t child = fork();
+    if (child == 0) {
+        _exit(0);
+    }
+    waitpid(child, nullptr, 0);
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    void* mapped = fd < 0 ? MAP_FAILED : mmap(nullptr, shm_layout::header_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    failures += check(mapped != MAP_FAILED, "map header for writing");
+    if (mapped != MAP_FAILED) {
+        uint32_t dead = static_cast<uint32_t>(child);
+        std::memcpy(static_cast<unsigned char*>(mapped) + shm_layout::pid_offset, &dead, sizeof(dead));
+        munmap(mapped, shm_layout::header_size);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+
+    ShmPublisher replacement("replacement", {"a"}, 4);
+    failures += check(replacement.open(name, error), "stale segment is taken over: " + error);
+    // the old publisher must not unlink the segment that replaced its own:
+    first.reset();
+    ShmReader after;
+    failures += check(after.open(name, error) && after.node == "replacement", "replacement survives the old publisher exiting: " + error);
+    return failures;
+}
+
+/**
+ * @brief Check the shared-memory layout, history ring, and that a concurrent reader never sees a torn sample, or hangs on one a dead publisher left half written; and that a second publisher can't take over a live one's segment.
+ */
+int main() {
+    int failures = 0;
+    const std::string name = "/foxsi_hk_test_" + std::to_string(getpid());
+    const size_t channels = 5;
+    std::vector<std::string> names;
+    for (size_t k = 0; k < channels; ++k) {
+        names.push_back("ch " + std::to_string(k));
+    }
+
+    ShmPublisher publisher("test", names, 8);
+    std::string error;
+    failures += check(publisher.open(name, error), "publisher opens: " + error);
+
+    ShmReader reader;
+    failures += check(reader.open(name, error), "reader opens: " + error);
+    failures += check(reader.node == "test" && reader.names == names && reader.history_capacity == 8, "header round trip");
+
+    ShmSample sample;
+    failures += check(!reader.latest(sample), "nothing published yet");
+
+    publisher.publish(100, {1.0, 2.0});
+    failures += check(reader.latest(sample) && sample.index == 0 && sample.time == 100, "latest sample");
+    failures += check(sample.values[1] == 2.0 && std::isnan(sample.values[4]), "missing values are NaN");
+
+    for (int64_t k = 1; k < 20; ++k) {
+        publisher.publish(100 + k, {static_cast<double>(k)});
+    }
+    failures += check(reader.published() == 20, "published count");
+    failures += check(reader.history(19, sample) && sample.time == 119, "newest history");
+    failures += check(reader.history(12, sample) && sample.values[0] == 12.0, "oldest history still held");
+    failures += check(!reader.history(11, sample), "overwritten history is refused");
+    failures += check(!reader.history(20, sample), "future history is refused");
+
+    // every value in a sample is the same number, so a torn read would show a mix:
+    std::atomic<bool> done = false;
+    std::thread writer([&] {
+        for (int64_t k = 0; k < 200000; ++k) {
+            publisher.publish(k, std::vector<double>(channels, static_cast<double>(k)));
+        }
+        done = true;
+    });
+    bool consistent = true;
+    size_t reads = 0;
+    while (!done) {
+        // (skipping the sample left over from above)
+        if (reader.latest(sample) && sample.index >= 20) {
+            for (double v: sample.values) {
+                consistent &= v == sample.values[0] && v == static_cast<double>(sample.time);
+            }
+            ++reads;
+        }
+    }
+    writer.join();
+    failures += check(consistent, "no torn reads in " + std::to_string(reads) + " tries");
+
+    // leave the latest slot mid-write (odd sequence), as a publisher killed inside `publish` would:
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    struct stat info;
+    void* mapped = fd < 0 || fstat(fd, &info) != 0 ? MAP_FAILED : mmap(nullptr, info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    failures += check(mapped != MAP_FAILED, "map segment for writing");
+    if (mapped != MAP_FAILED) {
+        unsigned char* base = static_cast<unsigned char*>(mapped);
+        uint64_t latest_offset;
+        uint64_t sequence;
+        std::memcpy(&latest_offset, base + shm_layout::latest_pointer_offset, sizeof(latest_offset));
+        std::memcpy(&sequence, base + latest_offset + shm_layout::slot_sequence_offset, sizeof(sequence));
+        sequence |= 1;
+        std::memcpy(base + latest_offset + shm_layout::slot_sequence_offset, &sequence, sizeof(sequence));
+        failures += check(!reader.latest(sample), "slot left mid-write is given up on");
+        munmap(mapped, info.st_size);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+
+    failures += check_ownership(name + "_owner");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,45 @@
+#include "stats.h"
+#include "test_check.h"
+#include <cmath>
+#include <chrono>
+
+bool close(double a, double b) {
+    return std::abs(a - b) < 1e-9;
+}
+
+/**
+ * @brief Check RunningStats against known values, and WindowedStats bucket expiry.
+ */
+int main() {
+    int failures = 0;
+
+    RunningStats all;
+    RunningStats low;
+    RunningStats high;
+    for (double v: {2.0, 4.0, 4.0, 4.0, 5.0, 5.0, 7.0, 9.0}) {
+        all.add(v);
+        (v < 5.0 ? low : high).add(v);
+    }
+    failures += check(all.count() == 8, "count");
+    failures += check(close(all.mean(), 5.0), "mean");
+    failures += check(close(all.variance(), 32.0 / 7.0), "sample variance");
+    failures += check(all.min() == 2.0 && all.max() == 9.0, "extrema");
+
+    low.merge(high);
+    failures += check(low.count() == 8 && close(low.mean(), 5.0) && close(low.variance(), all.variance()), "merge matches single pass");
+
+    auto t0 = std::chrono::steady_clock::time_point(std::chrono::hours(1000));
+    WindowedStats window(std::chrono::seconds(10), 10);
+    for (int k = 0; k < 30; ++k) {
+        window.add(t0 + std::chrono::seconds(k), static_cast<double>(k));
+    }
+    RunningStats recent = window.query(t0 + std::chrono::seconds(29));
+    failures += check(recent.count() == 10, "window only holds the last 10 s");
+    failures += check(recent.min() == 20.0 && recent.max() == 29.0, "window extrema");
+    RunningStats later = window.query(t0 + std::chrono::seconds(35));
+    failures += check(later.count() == 4, "window expires old buckets on query");
+    RunningStats stale = window.query(t0 + std::chrono::seconds(100));
+    failures += check(stale.count() == 0, "window empty after it passes");
+
+    return failures == 0 ? 0 : 1;
+}
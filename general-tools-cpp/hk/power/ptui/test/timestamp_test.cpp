@@ -0,0 +1,45 @@
+#include "timestamp.h"
+#include "test_check.h"
+#include <sstream>
+#include <string>
+
+/**
+ * @brief Check that a time anchor reads back from its header line, and that a steady-stamped CSV log is exported with wall-clock times, including one with a second session appended.
+ */
+int main() {
+    int failures = 0;
+
+    // 2024-04-01 12:00:00.123 UTC:
+    TimeAnchor anchor{std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(1711972800123456789))), 5000000000};
+    failures += check(format_time(anchor.wall) == "2024-04-01_12-00-00-123", "format_time: " + format_time(anchor.wall));
+
+    TimeAnchor read{};
+    failures += check(TimeAnchor::parse(anchor.header(), read) && read.steady == anchor.steady && read.wall == anchor.wall, "anchor reads back from its header: " + anchor.header());
+    failures += check(!TimeAnchor::parse("# trigger time: 2024-04-01_12-00-00-123", read) && !TimeAnchor::parse("Steady ns,28 V", read), "other lines aren't anchors");
+
+    std::stringstream in(
+        anchor.header() + "\n"
+        "Steady ns,28 V,5 V\n"
+        "5000000000,28.1,5.0\n"
+        "6500000000,28.2,5.1\n"
+        "\n"
+        "# time anchor: steady_ns 100 = unix_ns 1711976400000000000 (2024-04-01_13-00-00-000 UTC)\n"
+        "Steady ns,28 V,5 V\n"
+        "2000000100,27.9,4.9\n");
+    std::stringstream out;
+    std::string error;
+    failures += check(export_wall_clock(in, out, error), "export: " + error);
+    std::string expected =
+        "Time,Steady ns,28 V,5 V\n"
+        "2024-04-01_12-00-00-123,5000000000,28.1,5.0\n"
+        "2024-04-01_12-00-01-623,6500000000,28.2,5.1\n"
+        "2024-04-01_13-00-02-000,2000000100,27.9,4.9\n";
+    failures += check(out.str() == expected, "exported rows:\n" + out.str());
+
+    std::stringstream unanchored("Steady ns,28 V\n5000000000,28.1\n");
+    failures += check(!export_wall_clock(unanchored, out, error) && error == "line 2 comes before any time anchor", "no anchor: " + error);
+    std::stringstream garbled(anchor.header() + "\nSteady ns,28 V\nsoon,28.1\n");
+    failures += check(!export_wall_clock(garbled, out, error) && error == "line 3 doesn't start with a steady time", "bad row: " + error);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,64 @@
+#include "trace.h"
+#include "test_check.h"
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+
+size_t count(const std::string& text, const std::string& part) {
+    size_t result = 0;
+    for (size_t at = text.find(part); at != std::string::npos; at = text.find(part, at + 1)) {
+        ++result;
+    }
+    return result;
+}
+
+/**
+ * @brief Check that spans from several threads end up in the trace file, long details are truncated, and nothing is recorded while tracing is off.
+ */
+int main() {
+    int failures = 0;
+    const std::string path = "trace_test.json";
+
+    {
+        trace::Span ignored("before start", "test");
+    }
+    failures += check(!trace::enabled(), "tracing is off by default");
+
+    failures += check(trace::start(path), "start tracing");
+    trace::set_thread_name("main");
+    std::thread worker([] {
+        trace::set_thread_name("worker");
+        for (int k = 0; k < 100; ++k) {
+            trace::Span span("work", "test");
+        }
+    });
+    {
+        trace::Span span("outer", "test", "with \"quotes\"");
+        trace::Span long_detail("long", "test", std::string(100, 'x'));
+        trace::instant("mark", "test");
+    }
+    worker.join();
+    trace::stop();
+    failures += check(!trace::enabled(), "tracing is off after stop");
+    {
+        trace::Span ignored("after stop", "test");
+    }
+
+    std::ifstream in(path);
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string text = buffer.str();
+    std::remove(path.c_str());
+
+    failures += check(text.rfind("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 0) == 0, "trace-event header");
+    failures += check(count(text, "\"name\":\"work\"") == 100, "all worker spans recorded");
+    failures += check(count(text, "\"ph\":\"X\"") == 102, "complete events");
+    failures += check(count(text, "\"ph\":\"i\"") == 1, "instant event");
+    failures += check(text.find("\"args\":{\"name\":\"worker\"}") != std::string::npos, "thread names");
+    failures += check(text.find("with \\\"quotes\\\"") != std::string::npos, "details are escaped");
+    failures += check(text.find(std::string(trace::detail_size - 1, 'x') + "\"") != std::string::npos && text.find(std::string(trace::detail_size, 'x')) == std::string::npos, "long details are truncated");
+    failures += check(text.find("before start") == std::string::npos && text.find("after stop") == std::string::npos, "nothing recorded while off");
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,64 @@
+#include "listen.h"
+#include "headless.h"
+#include <iostream>
+#include <sys/socket.h>
+
+/**
+ * @brief Poll the RTD board without a UI, for long unattended runs like thermal soaks.
+ *
+ * Logs, captures, alarms, metrics and shared memory all work as in `rtui`. The link is (re)connected automatically, and SIGINT or SIGTERM stops polling and closes every log cleanly (see `HeadlessRunner`). Between polls, every thread is blocked waiting for a deadline, a socket or a signal.
+ */
+int main(int argc, char** argv) {
+    // blocks SIGINT/SIGTERM before any other thread starts, so they only reach `runner.run()`:
+    HeadlessRunner runner("rtuid", "RTD poll", config::rtd_poll_period, config::alarm_path);
+    int status = 0;
+    if (!runner.parse(argc, argv, status)) {
+        return status;
+    }
+
+    boost::asio::io_context context;
+    HKRTDNode node(runner.local, context, runner.period);
+
+    std::string alarm_note;
+    if (node.alarms.load(runner.vm["alarms"].as<std::string>(), alarm_note)) {
+        std::cout << "alarm limits from " << runner.vm["alarms"].as<std::string>() << "\n";
+    } else {
+        std::cout << "no alarm limits: " << alarm_note << "\n";
+    }
+
+    std::string metrics_error;
+    if (!runner.serve_metrics(node.metrics, metrics_error)) {
+        std::cerr << "couldn't serve metrics: " << metrics_error << "\n";
+        return 1;
+    }
+
+    runner.connect = [&] {
+        node.poll_started = node.setup_socket(runner.remote);
+        // the board may have been power cycled, so set up the RTD converters again on the first poll:
+        node.linecounter = 0;
+        return node.poll_started;
+    };
+    runner.disconnect = [&] {
+        boost::system::error_code ignored;
+        node.socket.close(ignored);
+        node.poll_started = false;
+    };
+    runner.poll = [&] { return node.poll_rtd(); };
+    runner.status = [&] {
+        std::string result = std::to_string(node.link.replies.value()) + " replies, " + std::to_string(node.link.short_reads.value()) + " short, " + std::to_string(node.link.timeouts.value()) + " timeouts, "
+            + std::to_string(node.link.reconnects.value()) + " reconnects";
+        for (size_t k = 0; k < node.latency.names.size(); ++k) {
+            result += "\n\t" + node.latency.brief(k);
+        }
+        return result;
+    };
+    runner.interrupt = [&] { ::shutdown(node.socket.native_handle(), SHUT_RDWR); };
+    runner.time_tag = util::get_now_string;
+
+    int result = runner.run();
+    for (size_t k = 0; k < node.latency.names.size(); ++k) {
+        std::cout << node.latency.brief(k) << "\n";
+    }
+    // logs are flushed and closed as `node` goes out of scope.
+    return result;
+}
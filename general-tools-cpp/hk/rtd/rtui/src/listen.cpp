@@ -1,12 +1,44 @@
 #include "parameters.h"
 #include "listen.h"
+#include "trace.h"
 #include <chrono>
 #include <iomanip>
+#include <algorithm>
 #include <sstream>
 #include <boost/bind.hpp>
 #include <unordered_map>
+#include <limits>
 
-HKRTDNode::HKRTDNode(boost::asio::ip::tcp::endpoint &local, boost::asio::io_context &io_context): 
+// display names for every RTD channel, in `util::rtd_channel` order
+std::vector<std::string> rtd_channel_names() {
+    std::vector<std::string> names;
+    for (uint8_t id: config::rtd_ids) {
+        for (uint8_t k = 0; k < config::RTD_CHANNELS; ++k) {
+            names.push_back("RTD " + std::to_string(util::rtd_number(id, k)));
+        }
+    }
+    return names;
+}
+
+// latency histogram names for the `read` request to each RTD board, in `config::rtd_ids` order
+std::vector<std::string> rtd_request_names() {
+    std::vector<std::string> names;
+    for (uint8_t id: config::rtd_ids) {
+        names.push_back("read board " + std::to_string(id));
+    }
+    return names;
+}
+
+HKRTDNode::HKRTDNode(boost::asio::ip::tcp::endpoint &local, boost::asio::io_context &io_context, std::chrono::milliseconds poll_period): 
+        stats(rtd_channel_names(), "log/stats_" + util::get_now_string() + ".csv", config::stats_rollup_period),
+        history(config::rtd_ids.size() * config::RTD_CHANNELS),
+        index(config::rtd_ids.size() * config::RTD_CHANNELS),
+        alarms(rtd_channel_names(), "log/alarms_" + util::get_now_string() + ".log"),
+        wire("log/wire_" + util::get_now_string() + ".csv"),
+        latency("rtui", rtd_request_names(), "log/latency_" + util::get_now_string() + ".txt"),
+        metrics("rtui"),
+        link(metrics),
+        shm("rtui", rtd_channel_names(), util::poll_count(config::shm_history_seconds, poll_period)),
         context(io_context), 
         socket(io_context)
 {
@@ -25,15 +57,25 @@ HKRTDNode::HKRTDNode(boost::asio::ip::tcp::endpoint &local, boost::asio::io_cont
     csv_file.open("log/parse_" + util::get_now_string() + ".csv", std::ios::out | std::ios::app);
     csv_first = true;
     poll_started = false;
+
+    std::string shm_error;
+    if (!shm.open(config::shm_name, shm_error)) {
+        std::cout << "not publishing to shared memory: " << shm_error << "\n";
+    }
 }
 
 bool HKRTDNode::setup_socket(boost::asio::ip::tcp::endpoint &target) {
     if (socket.is_open()) {
         try {
             socket.connect(target);
+            if (link.connects.value() > 0) {
+                link.reconnects.add();
+            }
+            link.connects.add();
             return true;
         } catch (std::exception &e) {
             std::cout << "connect error: " << e.what() << "\n";
+            link.connect_errors.add();
             return false;
         }
     } else {
@@ -45,6 +87,14 @@ bool HKRTDNode::setup_socket(boost::asio::ip::tcp::endpoint &target) {
     }
 }
 
+bool HKRTDNode::set_wire_timestamps(bool enable, std::string& error) {
+    if (!enable) {
+        wire.disable(socket.native_handle());
+        return true;
+    }
+    return wire.enable(socket.native_handle(), error);
+}
+
 void HKRTDNode::sync_write(std::vector<uint8_t> data) {
     try {
         socket.async_send(
@@ -129,12 +179,19 @@ void HKRTDNode::async_read_handler(const boost::system::error_code &ec, std::siz
     *out_length = length;
 }
 
+bool HKRTDNode::wait_for_reply() {
+    // only wait here; the reply itself is read with a plain (or timestamped) receive once it's there.
+    socket.async_wait(boost::asio::ip::tcp::socket::wait_read, [](const boost::system::error_code&) {});
+    return !run_context_until();
+}
+
 bool HKRTDNode::run_context_until() {
     context.restart();
     context.run_for(io_timeout);
     if (!context.stopped()) {
         socket.cancel();
         context.run();
+        link.timeouts.add();
         return true;
     }
     return false;
@@ -167,17 +224,19 @@ void HKRTDNode::handle_adc_reply(const boost::system::error_code& err, std::size
     }
 }
 
-void HKRTDNode::poll_rtd() {
+bool HKRTDNode::poll_rtd() {
     if (!poll_started) {
-        return;
+        return true;
     }
+    trace::Span span("poll cycle", "poll");
+    link.polls.add();
 
     if (linecounter == 0) {
         // send setup
         for (uint8_t id: config::rtd_ids) {
-            socket.send(boost::asio::buffer({id, config::setup}));
+            link.bytes_sent.add(socket.send(boost::asio::buffer({id, config::setup})));
             std::this_thread::sleep_for(std::chrono::milliseconds(1500));
-            socket.send(boost::asio::buffer({id, config::convert}));
+            link.bytes_sent.add(socket.send(boost::asio::buffer({id, config::convert})));
         }
         accumulate_error.clear();
     }
@@ -185,50 +244,96 @@ void HKRTDNode::poll_rtd() {
     // std::this_thread::sleep_for(std::chrono::milliseconds(1500));
     
     format_table.clear();
-    format_table.push_back({"RTD", "fault", "temp ºC", "fault rate"});
+    format_channels.clear();
+    format_table.push_back({"RTD", "fault", "temp ºC", "fault rate", "mean", "stddev", "min", "max", "last 10 min"});
+
+    // every channel's reading from this poll, NaN where there was a fault or no reply, for shared memory:
+    std::vector<double> shm_values(config::rtd_ids.size() * config::RTD_CHANNELS, std::numeric_limits<double>::quiet_NaN());
+    int64_t shm_time = 0;
 
+    PhaseProfiler::Lap timer(profile);
+    bool replied = true;
     for (uint8_t id: config::rtd_ids) {
         // read command:
-        socket.send(boost::asio::buffer({id, config::read}));
+        wire.before_send(socket.native_handle());
+        int64_t send_time = steady_now_ns();
+        link.bytes_sent.add(socket.send(boost::asio::buffer({id, config::read})));
+        timer.lap(PollPhase::send);
         std::vector<uint8_t> reply;
         size_t target_size = config::REPLY_SIZE;
         reply.resize(target_size);
-        size_t reply_size = socket.receive(boost::asio::buffer(reply));
+        if (!wait_for_reply()) {
+            // the other boards are on the same link, so don't wait on each of them too
+            timer.lap(PollPhase::wait);
+            trace::instant("reply timeout", "poll");
+            replied = false;
+            break;
+        }
+        size_t reply_size = wire.enabled() ? wire.receive(socket.native_handle(), reply.data(), reply.size()) : socket.receive(boost::asio::buffer(reply));
+        auto now = std::chrono::steady_clock::now();
+        timer.lap(PollPhase::wait);
+        link.bytes_received.add(reply_size);
+        if (wire.enabled()) {
+            wire.finish(socket.native_handle(), steady_ns(now));
+        }
+        if (reply_size > 0) {
+            latency.add(std::find(config::rtd_ids.begin(), config::rtd_ids.end(), id) - config::rtd_ids.begin(), send_time, steady_ns(now));
+        }
+        timer.lap(PollPhase::record);
     
         if (reply_size == target_size) {
             reply.resize(reply_size);
 
             // start the next conversion:
-            socket.send(boost::asio::buffer({id, config::convert}));
+            link.bytes_sent.add(socket.send(boost::asio::buffer({id, config::convert})));
+            timer.lap(PollPhase::send);
             
             sync_write(raw_file, reply);
             raw_file.flush();
+            timer.lap(PollPhase::raw);
 
             ++linecounter;
+            link.replies.add();
 
             last_data[id] = parse_rtd(reply);
+            timer.lap(PollPhase::decode);
             for (auto row: last_data[id]) {
                 std::stringstream temp_val;
-                int rtd_num = row.first;
-                if (id == 0x01) {
-                    rtd_num = 9 - rtd_num;
-                } else if  (id == 0x02) {
-                    rtd_num = 20 - rtd_num;
-                }
+                int rtd_num = util::rtd_number(id, row.first);
+                size_t channel = util::rtd_channel(id, row.first);
 
                 temp_val << std::fixed << std::setprecision(3) << std::to_string(row.second.second);
 
                 if (row.second.first != 1) { // if any error flag is set, add this to the error total for this channel.
                     accumulate_error[id][row.first].first += 1;
+                } else {
+                    stats.add(channel, now, row.second.second);
+                    history[channel].add(now, row.second.second);
+                    index[channel].add(now, row.second.second);
+                    alarms.check(channel, row.second.second);
+                    if (channel < shm_values.size()) {
+                        shm_values[channel] = row.second.second;
+                    }
+                    shm_time = steady_ns(now);
                 }
+                timer.lap(PollPhase::record);
                 // count this measurement for this channel total
                 accumulate_error[id][row.first].second += 1;
                 double error_rate_d = static_cast<double>(accumulate_error[id][row.first].first) / accumulate_error[id][row.first].second;
                 std::stringstream error_rate;
                 error_rate << std::fixed << std::setprecision(3) << std::to_string(error_rate_d);
 
-                format_table.push_back({std::to_string(rtd_num), std::to_string(row.second.first), temp_val.str(), error_rate.str()});
+                std::vector<std::string> table_row = {std::to_string(rtd_num), std::to_string(row.second.first), temp_val.str(), error_rate.str()};
+                for (auto& col: StatsBank::columns(stats.channels[channel].minute.query(now), 3)) {
+                    table_row.push_back(col);
+                }
+                table_row.push_back(history[channel].sparkline(now, config::trend_span, config::trend_width));
+                format_table.push_back(table_row);
+                format_channels.push_back(channel);
+                timer.lap(PollPhase::format);
             }
+            stats.rollup(now, util::get_now_string());
+            timer.lap(PollPhase::record);
         
             // last_reading = adc_table(reply);
             // displayable_reading.clear();
@@ -243,8 +348,14 @@ void HKRTDNode::poll_rtd() {
             // csv_write();
         } else {
             std::cout << "got reply size: " << std::to_string(reply_size);
+            trace::instant("short reply", "poll");
+            link.short_reads.add();
         }
     }
+    if (shm_time != 0) {
+        shm.publish(shm_time, shm_values);
+    }
+    return replied;
 }
 
 void HKRTDNode::csv_write() {
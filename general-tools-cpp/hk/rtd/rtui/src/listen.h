@@ -11,6 +11,16 @@
 #include <iostream>
 #include <ctime>                // for timestamping
 #include "parameters.h"
+#include "stats.h"
+#include "history.h"
+#include "rangeindex.h"
+#include "alarm.h"
+#include "timestamp.h"
+#include "wiretime.h"
+#include "latency.h"
+#include "profiler.h"
+#include "metrics.h"
+#include "shm.h"
 
 /**
  * @brief A class to query the Housekeeping board's ADC subsystem.
@@ -24,8 +34,9 @@ class HKRTDNode {
          * 
          * @param local the local endpoint to bind to.
          * @param io_context the `boost::asio` `io_context` used to manage communication.
+         * @param poll_period time between polls, which sets how many readings shared memory holds.
          */
-        HKRTDNode(boost::asio::ip::tcp::endpoint &local, boost::asio::io_context& io_context);
+        HKRTDNode(boost::asio::ip::tcp::endpoint &local, boost::asio::io_context& io_context, std::chrono::milliseconds poll_period = config::rtd_poll_period);
 
         // socket should already be bound by the time these are called:
 
@@ -97,8 +108,12 @@ class HKRTDNode {
          * This function polls the Housekeeping board for new power readings, stores those readings in the CSV and raw data files, and populates other fields for the FTXUI display to use.
          * 
          * This can be called on a timer in a background thread to continuously update the display or continuously store power readings.
+         *
+         * Waits at most `::io_timeout` for each reply, so a board that stops answering (while the TCP connection stays up) can't block the caller.
+         *
+         * @return false if the board didn't reply in time. The socket may still deliver the late reply, so reconnect before polling again.
          */
-        void poll_rtd();
+        bool poll_rtd();
 
         /**
          * @brief The last parsed measurement taken from the Housekeeping board.
@@ -112,6 +127,10 @@ class HKRTDNode {
          * @brief A formatted version of `::last_reading` for the FTXUI display to ingest.
          */
         std::vector<std::vector<std::string>> format_table;
+        /**
+         * @brief The channel (see `util::rtd_channel`) shown in each data row of `::format_table`.
+         */
+        std::vector<size_t> format_channels;
 
 
         /**
@@ -134,6 +153,56 @@ class HKRTDNode {
          */
         std::unordered_map<uint8_t, std::unordered_map<uint8_t, std::pair<size_t, size_t>>> accumulate_error;
 
+        /**
+         * @brief Streaming temperature statistics for each RTD channel, indexed by `util::rtd_channel`.
+         */
+        StatsBank stats;
+        /**
+         * @brief Decimated min/max temperature history for each RTD channel, indexed by `util::rtd_channel`.
+         */
+        std::vector<DecimatedHistory> history;
+        /**
+         * @brief Session-long range query index of temperature for each RTD channel, indexed by `util::rtd_channel`.
+         */
+        std::vector<TimedRangeIndex> index;
+        /**
+         * @brief Limit checking for each RTD channel, indexed by `util::rtd_channel`. Limits are disabled until loaded with `AlarmEngine::load`.
+         */
+        AlarmEngine alarms;
+        /**
+         * @brief Optional kernel timestamps for each RTD request/reply, separating wire round trip from our own delay. Off until enabled with `::set_wire_timestamps`.
+         */
+        WireTimer wire;
+        /**
+         * @brief Round-trip latency of each RTD board `read` (one histogram per board), from send to reply. Summarized to `log/latency_*.txt` at exit.
+         */
+        LatencyBank latency;
+        /**
+         * @brief Time spent in each phase of the poll cycle (and in rendering, timed by the UI).
+         */
+        PhaseProfiler profile;
+        /**
+         * @brief Counters and gauges served on the metrics page (see `MetricsServer`).
+         */
+        MetricsRegistry metrics;
+        /**
+         * @brief Link health counters (polls, replies, short reads, timeouts, bytes, connections), registered in `::metrics`.
+         */
+        LinkMetrics link;
+        /**
+         * @brief Publishes each reading to shared memory (`config::shm_name`) for other local programs, see `shm_layout`.
+         */
+        ShmPublisher shm;
+
+        /**
+         * @brief Turn kernel (`SO_TIMESTAMPING`) timestamps on the board socket on or off.
+         * 
+         * @param enable true to turn timestamps on.
+         * @param error set to a description of the problem if they couldn't be turned on.
+         * @return true if timestamps are now in the requested state.
+         */
+        bool set_wire_timestamps(bool enable, std::string& error);
+
         /**
          * @brief An optional message for debugging with the FTXUI interface.
          */
@@ -183,6 +252,12 @@ class HKRTDNode {
          * @return false 
          */
         bool run_context_until();
+        /**
+         * @brief Wait up to `::io_timeout` for the socket to have a reply to read.
+         *
+         * @return false if nothing arrived in time.
+         */
+        bool wait_for_reply();
         /**
          * @brief Internal method for managing read timeouts/retries.
          * 
@@ -194,7 +269,7 @@ class HKRTDNode {
         void async_read_handler(const boost::system::error_code &ec, std::size_t length, boost::system::error_code *out_ec, std::size_t *out_length);
 
         /**
-         * @brief Duration to wait for response (in `::async_read`) before trying again or abandoning.
+         * @brief Duration to wait for a response (in `::async_read` and each poll) before trying again or abandoning.
          */
         std::chrono::milliseconds io_timeout;
         /**
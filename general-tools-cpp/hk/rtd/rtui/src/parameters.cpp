@@ -1,30 +1,24 @@
 #include "parameters.h"
+#include "timestamp.h"
+#include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <ctime>
-#include <sys/time.h>
+#include <iomanip>
+#include <sstream>
 
 std::string util::get_now_string() {
-    char time_format[std::size("yyyy-mm-dd_hh-mm-ss")];
-    auto start_time = std::time({});
-
-    std::strftime(std::data(time_format), std::size(time_format), "%F_%H-%M-%S", std::gmtime(&start_time));
-
-    return std::string(time_format) + "-" + get_now_millis();
+    return format_time(std::chrono::system_clock::now());
 }
 std::string util::get_now_millis() {
-    int millisec;
-    struct tm* tm_info;
-    struct timeval tv;
+    auto millisec = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count() % 1000;
 
-    gettimeofday(&tv, NULL);
-
-    millisec = lrint(tv.tv_usec/1000.0); // Round to nearest millisec
-    if (millisec>=1000) { // Allow for rounding up to nearest second
-        millisec -=1000;
-        tv.tv_sec++;
-    }
-
-    return std::to_string(millisec);
+    std::stringstream result;
+    result << std::setw(3) << std::setfill('0') << millisec;
+    return result.str();
+}
+std::string util::format_time(std::chrono::system_clock::time_point time) {
+    return ::format_time(time);
 }
 
 uint32_t util::bytes_to_uint32_t(std::vector<uint8_t>& data) {
@@ -37,7 +31,25 @@ uint32_t util::bytes_to_uint32_t(std::vector<uint8_t>& data) {
     //         break;
     //     }
     // }
-    memcpy(&result, data.data(), 4);
+    // least significant byte first; a shorter value (like a 3-byte RTD reading) fills the low bytes
+    memcpy(&result, data.data(), std::min<size_t>(data.size(), 4));
 
     return result;
+}
+
+int util::rtd_number(uint8_t id, uint8_t index) {
+    if (id == 0x01) {
+        return 9 - index;
+    } else if (id == 0x02) {
+        return 20 - index;
+    }
+    return index;
+}
+
+size_t util::rtd_channel(uint8_t id, uint8_t index) {
+    return (id - 1) * config::RTD_CHANNELS + index;
+}
+
+size_t util::poll_count(size_t seconds, std::chrono::milliseconds period) {
+    return std::max<size_t>(1, seconds * 1000 / std::max<std::chrono::milliseconds::rep>(1, period.count()));
 }
\ No newline at end of file
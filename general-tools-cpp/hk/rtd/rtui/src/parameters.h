@@ -6,10 +6,13 @@
 #include <string>
 #include <iostream>
 #include <unordered_map>
+#include <chrono>
 
 namespace config {
 // power board ADC reply message size
 static const size_t REPLY_SIZE = 36;
+// number of RTD channels in each RTD reply message
+static const size_t RTD_CHANNELS = REPLY_SIZE / 4;
 // commands to setup ADC and request data
 static const std::vector<uint8_t> setup_rtd1 = {0x01, 0xff, 0x00};
 static const std::vector<uint8_t> setup_rtd2 = {0x02, 0xff, 0x00};
@@ -22,15 +25,39 @@ static const std::vector<uint8_t> rtd_ids = {0x01, 0x02};
 static const uint8_t setup = 0xff;
 static const uint8_t convert = 0xf0;
 static const uint8_t read = 0xf2;
+// default period between RTD board polls (`--poll-period` overrides it)
+static const std::chrono::milliseconds rtd_poll_period(1600);
+
+// time span and width (in characters) of the trend sparkline for each RTD
+static const std::chrono::seconds trend_span(600);
+static const size_t trend_width = 20;
+
+// default alarm limit file
+static const std::string alarm_path = "config/alarms.json";
+
+// shared-memory segment the latest readings are published to, and how many seconds of recent readings it keeps
+static const std::string shm_name = "/foxsi_hk_rtui";
+static const size_t shm_history_seconds = 600;
+
+// how often to append per-channel statistics to the stats log
+static const std::chrono::seconds stats_rollup_period(60);
 
 }; // namespace config
 namespace util {
-    // get current time as string
+    // get current time as string, including zero-padded milliseconds
     std::string get_now_string();
-    // get current time as string, including milliseconds
+    // get the milliseconds part of the current time, zero-padded to three digits
     std::string get_now_millis();
-    // convert four bytes to a uint32_t type
+    // format a time point as string, including milliseconds
+    std::string format_time(std::chrono::system_clock::time_point time);
+    // convert up to four bytes, least significant first, to a uint32_t
     uint32_t bytes_to_uint32_t(std::vector<uint8_t>& data);
+    // convert an RTD chip ID and channel index in its reply to the harness RTD number
+    int rtd_number(uint8_t id, uint8_t index);
+    // convert an RTD chip ID and channel index in its reply to a flat channel index, counting from 0
+    size_t rtd_channel(uint8_t id, uint8_t index);
+    // number of polls every `period` that fit in `seconds`, at least one
+    size_t poll_count(size_t seconds, std::chrono::milliseconds period);
 };
 
 #endif
@@ -0,0 +1,128 @@
+#include "listen.h"
+#include "parameters.h"
+#include "shm.h"
+#include "test_check.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+// a faulted channel, flagged in every reply from the stand-in board
+static const uint8_t faulted_id = 0x02;
+static const uint8_t faulted_index = 4;
+
+// the temperature the stand-in board reports for channel `index` of board `id`
+double reading(uint8_t id, uint8_t index) {
+    return id * 100 + index;
+}
+
+// a stand-in for the RTD boards: take each two-byte request (board ID, command) and answer every `read` with a full reply, until the client hangs up
+void serve(boost::asio::ip::tcp::acceptor& acceptor) {
+    boost::asio::ip::tcp::socket board = acceptor.accept();
+    boost::system::error_code ec;
+    while (true) {
+        std::array<uint8_t, 2> request;
+        boost::asio::read(board, boost::asio::buffer(request), ec);
+        if (ec) {
+            return;
+        }
+        if (request[1] != config::read) {
+            continue;
+        }
+        uint8_t id = request[0];
+        std::vector<uint8_t> reply;
+        for (uint8_t k = 0; k < config::RTD_CHANNELS; ++k) {
+            // fault flag (1 is a good reading), then the temperature in 1/1024 ºC, least significant byte first
+            uint32_t raw = static_cast<uint32_t>(reading(id, k) * 1024);
+            reply.push_back(id == faulted_id && k == faulted_index ? 0x00 : 0x01);
+            reply.push_back(raw & 0xff);
+            reply.push_back((raw >> 8) & 0xff);
+            reply.push_back((raw >> 16) & 0xff);
+        }
+        boost::asio::write(board, boost::asio::buffer(reply), ec);
+        if (ec) {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Poll a stand-in for both RTD boards once through `HKRTDNode`, and check each reading reaches the table, statistics, alarms and shared memory on its own channel, with the faulted one left out.
+ *
+ * Run from the rtui directory, so the node's logs go to log/.
+ */
+int main() {
+    int failures = 0;
+
+    boost::asio::io_context board_context;
+    boost::asio::ip::tcp::acceptor acceptor(board_context, boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+    boost::asio::ip::tcp::endpoint target = acceptor.local_endpoint();
+    std::thread board([&] { serve(acceptor); });
+
+    // limits on RTD 5 (board 1, channel 4), below what the board reports for it:
+    const std::string limits_path = "/tmp/rtui_node_test_" + std::to_string(getpid()) + ".json";
+    {
+        std::ofstream limits(limits_path);
+        limits << R"({"channels": [{"name": "RTD 5", "yellow_high": 90.0, "red_high": 100.0}]})";
+    }
+
+    {
+        boost::asio::io_context context;
+        boost::asio::ip::tcp::endpoint local(boost::asio::ip::address_v4::loopback(), 0);
+        HKRTDNode node(local, context);
+        std::string error;
+        failures += check(node.alarms.load(limits_path, error), "alarm limits load: " + error);
+        failures += check(node.setup_socket(target), "connect to the stand-in board");
+
+        // skip the converter setup, which waits 1.5 s for each board:
+        node.poll_started = true;
+        node.linecounter = 1;
+        failures += check(node.poll_rtd(), "both boards reply");
+        failures += check(node.link.replies.value() == config::rtd_ids.size(), "one reply per board");
+
+        size_t total = config::rtd_ids.size() * config::RTD_CHANNELS;
+        failures += check(node.format_table.size() == total + 1 && node.format_channels.size() == total, "a table row for every channel");
+        std::vector<bool> shown(total, false);
+        for (size_t channel: node.format_channels) {
+            if (channel < total) {
+                shown[channel] = true;
+            }
+        }
+        failures += check(std::find(shown.begin(), shown.end(), false) == shown.end(), "every channel is shown once");
+
+        ShmReader reader;
+        ShmSample sample;
+        failures += check(reader.open(config::shm_name, error) && reader.latest(sample), "reading published to shared memory: " + error);
+        failures += check(sample.values.size() == total, "shared memory has every channel");
+
+        for (uint8_t id: config::rtd_ids) {
+            for (uint8_t k = 0; k < config::RTD_CHANNELS; ++k) {
+                size_t channel = util::rtd_channel(id, k);
+                std::string name = "RTD " + std::to_string(util::rtd_number(id, k));
+                const RunningStats& session = node.stats.channels[channel].session;
+                double published = channel < sample.values.size() ? sample.values[channel] : 0.0;
+                if (id == faulted_id && k == faulted_index) {
+                    failures += check(session.count() == 0, name + ": faulted reading left out of statistics");
+                    failures += check(std::isnan(published), name + ": faulted reading is NaN in shared memory");
+                    failures += check(node.accumulate_error[id][k] == std::make_pair<size_t, size_t>(1, 1), name + ": fault counted");
+                } else {
+                    failures += check(session.count() == 1 && session.mean() == reading(id, k), name + ": statistics on channel " + std::to_string(channel));
+                    failures += check(published == reading(id, k), name + ": shared memory on channel " + std::to_string(channel));
+                    failures += check(node.accumulate_error[id][k] == std::make_pair<size_t, size_t>(0, 1), name + ": no fault counted");
+                }
+            }
+        }
+        failures += check(node.alarms.level(util::rtd_channel(0x01, 4)) == AlarmLevel::red, "RTD 5 over its red limit");
+        failures += check(node.alarms.worst() == AlarmLevel::red && node.alarms.level(util::rtd_channel(0x01, 3)) == AlarmLevel::nominal, "no other channel alarms");
+    }
+
+    // the node's socket is closed, so the board stops:
+    board.join();
+    std::remove(limits_path.c_str());
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,41 @@
+#include "parameters.h"
+#include "test_check.h"
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Check the RTD numbering: which harness RTD each chip's reply channel is, that every channel gets its own flat index, how reply bytes become a reading, and how many polls fit in a time span.
+ */
+int main() {
+    int failures = 0;
+
+    // board 1 carries RTDs 9 down to 1, board 2 carries 20 down to 12:
+    failures += check(util::rtd_number(0x01, 0) == 9 && util::rtd_number(0x01, 8) == 1, "board 1 RTD numbers");
+    failures += check(util::rtd_number(0x02, 0) == 20 && util::rtd_number(0x02, 8) == 12, "board 2 RTD numbers");
+    failures += check(util::rtd_number(0x07, 3) == 3, "unknown board keeps the channel index");
+
+    std::set<size_t> channels;
+    std::set<int> numbers;
+    for (uint8_t id: config::rtd_ids) {
+        for (uint8_t k = 0; k < config::RTD_CHANNELS; ++k) {
+            channels.insert(util::rtd_channel(id, k));
+            numbers.insert(util::rtd_number(id, k));
+        }
+    }
+    size_t total = config::rtd_ids.size() * config::RTD_CHANNELS;
+    failures += check(channels.size() == total && *channels.begin() == 0 && *channels.rbegin() == total - 1, "flat channels are 0 to " + std::to_string(total - 1) + " with no gaps or repeats");
+    failures += check(numbers.size() == total, "every channel is a different RTD");
+    failures += check(util::rtd_channel(0x01, 8) + 1 == util::rtd_channel(0x02, 0), "board 2 follows board 1");
+
+    // a reading's value is three bytes, least significant first:
+    std::vector<uint8_t> value = {0x00, 0x64, 0x00};
+    failures += check(util::bytes_to_uint32_t(value) == 0x6400, "three-byte value");
+    value = {0x01, 0x02, 0x03, 0x04};
+    failures += check(util::bytes_to_uint32_t(value) == 0x04030201, "four-byte value");
+
+    failures += check(util::poll_count(config::shm_history_seconds, config::rtd_poll_period) == 375, "shared memory holds 10 minutes at the default period");
+    failures += check(util::poll_count(600, std::chrono::milliseconds(250)) == 2400 && util::poll_count(1, std::chrono::milliseconds(5000)) == 1, "poll count follows the period, at least one");
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,139 @@
+"""Read the latest housekeeping readings that `ptui` and `rtui` publish to shared memory.
+
+The segment layout is documented with `shm_layout` in `general-tools-cpp/hk/common/src/shm.h`.
+Readers only ever map the segment read-only, so any number of them can poll it without
+slowing down the publisher.
+"""
+
+import sys
+import time
+import math
+import mmap
+import struct
+import argparse
+from datetime import datetime, timezone
+
+MAGIC = b"FOXSIHK\x00"
+VERSION = 1
+HEADER_SIZE = 128
+NAME_SIZE = 32
+
+# header fields: magic, version, channels, capacity, slot size, names/latest/history offsets,
+# anchor steady ns, anchor unix ns, published, writer pid, reserved, node name
+HEADER = struct.Struct("<8sIIIIQQQqqQII32s")
+# slot fields before the values: sequence, sample number, steady ns
+SLOT_HEAD = struct.Struct("<QQq")
+# attempts at reading a slot before giving up on it: only a publisher that died mid-write uses them all
+READ_RETRIES = 10000
+
+
+def _name(raw):
+    """Decode a NUL-padded name."""
+    return raw.split(b"\x00", 1)[0].decode("utf-8", errors="replace")
+
+
+class HKReader:
+    """A read-only view of a housekeeping shared-memory segment.
+
+    `name` is the segment name without the leading slash, like `foxsi_hk_ptui`. On Linux the
+    segment is the file `/dev/shm/<name>`.
+    """
+
+    def __init__(self, name="foxsi_hk_ptui"):
+        path = name if name.startswith("/dev/shm/") else "/dev/shm/" + name.lstrip("/")
+        with open(path, "rb") as f:
+            self.map = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+
+        fields = HEADER.unpack_from(self.map, 0)
+        if fields[0] != MAGIC:
+            raise ValueError(path + " is not a housekeeping segment")
+        if fields[1] != VERSION:
+            raise ValueError(path + " has layout version " + str(fields[1]) + ", expected " + str(VERSION))
+        (_, _, self.channel_count, self.capacity, self.slot_size,
+         names_offset, self.latest_offset, self.history_offset,
+         self.anchor_steady, self.anchor_unix, _, self.pid, _, node) = fields
+        self.node = _name(node)
+        self.names = [
+            _name(self.map[names_offset + k * NAME_SIZE:names_offset + (k + 1) * NAME_SIZE])
+            for k in range(self.channel_count)
+        ]
+        self.values = struct.Struct("<" + str(self.channel_count) + "d")
+
+    def close(self):
+        self.map.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def published(self):
+        """Number of samples published so far."""
+        return struct.unpack_from("<Q", self.map, 64)[0]
+
+    def unix_time(self, steady_ns):
+        """Convert a sample's steady-clock time to Unix seconds, using the segment's time anchor."""
+        return (self.anchor_unix + steady_ns - self.anchor_steady) * 1e-9
+
+    def _read_slot(self, offset):
+        """Copy one slot, retrying while the publisher is writing it (seqlock).
+
+        Returns `(sample number, steady ns, {channel name: value})`, or None if the slot stayed
+        mid-write for `READ_RETRIES` attempts.
+        """
+        for _ in range(READ_RETRIES):
+            before = struct.unpack_from("<Q", self.map, offset)[0]
+            if before % 2 == 1:
+                time.sleep(0)
+                continue
+            _, index, steady = SLOT_HEAD.unpack_from(self.map, offset)
+            values = self.values.unpack_from(self.map, offset + SLOT_HEAD.size)
+            if struct.unpack_from("<Q", self.map, offset)[0] == before:
+                return index, steady, dict(zip(self.names, values))
+        return None
+
+    def latest(self):
+        """The most recent sample as `(sample number, steady ns, {channel: value})`, or None before the first (or if it can't be read)."""
+        if self.published() == 0:
+            return None
+        return self._read_slot(self.latest_offset)
+
+    def history(self, index):
+        """Sample number `index` from the history ring, or None if it isn't there (yet, or any more)."""
+        count = self.published()
+        if index >= count or count - index > self.capacity:
+            return None
+        sample = self._read_slot(self.history_offset + (index % self.capacity) * self.slot_size)
+        return sample if sample is not None and sample[0] == index else None
+
+    def recent(self):
+        """Every sample still in the history ring, oldest first."""
+        count = self.published()
+        samples = (self.history(k) for k in range(max(0, count - self.capacity), count))
+        return [s for s in samples if s is not None]
+
+
+parser = argparse.ArgumentParser("hkshm.py")
+parser.add_argument("--name", help="shared-memory segment name (default foxsi_hk_ptui)", type=str, default="foxsi_hk_ptui")
+parser.add_argument("--period", help="seconds between printouts (default 1)", type=float, default=1.0)
+
+if __name__ == "__main__":
+    args = parser.parse_args()
+    try:
+        reader = HKReader(args.name)
+    except (OSError, ValueError) as e:
+        print("couldn't open housekeeping shared memory:", e)
+        sys.exit(1)
+
+    print("reading", reader.node, "(pid", str(reader.pid) + ")", "with", reader.channel_count, "channels")
+    last = None
+    with reader:
+        while True:
+            sample = reader.latest()
+            if sample is not None and sample[0] != last:
+                last = sample[0]
+                stamp = datetime.fromtimestamp(reader.unix_time(sample[1]), tz=timezone.utc).strftime("%Y-%m-%d %H:%M:%S.%f")[:-3]
+                readings = ", ".join(name + " " + ("-" if math.isnan(v) else "{:.3f}".format(v)) for name, v in sample[2].items())
+                print("[" + stamp + "] #" + str(sample[0]) + ": " + readings)
+            time.sleep(args.period)